@@ -0,0 +1,540 @@
+// Regression benchmark for the blocks covered by the test_gen fixtures:
+// conv2d, conv2d_transpose, ResnetBlock2D (simple, SD1.5 UNet and VAE) and
+// Upsample2D/Downsample2D.
+//
+// Each block is loaded from its fixture and first checked against the
+// fixture output at the fixture shape. It is then timed with random input
+// at the shape it runs at in SD1.5 at 512x512, keeping the fixture weights.
+// Peak memory is the allocator high-water mark of one production-shape
+// forward above what was allocated before it, see [ModuleProfiler].
+//
+// Results are written as JSON with one entry per block, sorted by name, so
+// that runs can be diffed. With --baseline, blocks that got slower by more
+// than --tolerance, or that no longer match their fixture, are reported
+// and the exit code is 1. Fixtures that were not generated are skipped.
+//
+// Run test_gen/generate.sh first.
+//
+// Usage: dart run benchmark/blocks.dart [--iterations 10] [--batch 1]
+//            [--out blocks.json] [--baseline old.json] [--tolerance 0.1]
+
+import 'dart:convert';
+import 'dart:io';
+
+import 'package:tensor/tensor.dart';
+
+const _schema = 1;
+
+class _ResnetBlock2D extends Module implements EmbeddableModule {
+  final GroupNorm norm1;
+  final Conv2D conv1;
+  final LinearLayer? timeEmbProj;
+  final GroupNorm norm2;
+  final Conv2D conv2;
+  final Conv2D? convShortcut;
+
+  _ResnetBlock2D({
+    required super.name,
+    required this.norm1,
+    required this.conv1,
+    required this.timeEmbProj,
+    required this.norm2,
+    required this.conv2,
+    required this.convShortcut,
+  });
+
+  @override
+  Tensor forward(Tensor x, {Tensor? embeds, required Context context}) {
+    return context.runForward(this, () {
+      Tensor h = norm1.forward(x, context: context).silu();
+      h = conv1.forward(h, context: context);
+      final proj = timeEmbProj;
+      if (proj != null && embeds != null) {
+        final temb = proj.forward(embeds.silu(), context: context);
+        h = h + temb.unsqueeze(-1).unsqueeze(-1);
+      }
+      h = norm2.forward(h, context: context).silu();
+      h = conv2.forward(h, context: context);
+      final residual = convShortcut?.forward(x, context: context) ?? x;
+      return residual + h;
+    });
+  }
+
+  @override
+  void resetParameters() {}
+
+  @override
+  Map<String, dynamic> get meta => {};
+
+  @override
+  Iterable<Tensor> get parameters => [];
+
+  @override
+  Iterable<Module> get submodules => [
+    norm1,
+    conv1,
+    ?timeEmbProj,
+    norm2,
+    conv2,
+    ?convShortcut,
+  ];
+
+  static Future<_ResnetBlock2D> load(
+    SafeTensorLoader loader,
+    String prefix, {
+    required String name,
+    required double eps,
+  }) async {
+    Future<Conv2D?> conv(String convName, int padding) async {
+      if (!loader.hasTensor('$prefix$convName.weight')) return null;
+      return Conv2D.loadFromSafeTensor(
+        loader,
+        prefix: '$prefix$convName.',
+        name: convName,
+        padding: SymmetricPadding2D.same(padding),
+      );
+    }
+
+    return _ResnetBlock2D(
+      name: name,
+      norm1: await GroupNorm.loadFromSafeTensor(
+        loader,
+        prefix: '${prefix}norm1.',
+        name: 'norm1',
+        eps: eps,
+        numGroups: 32,
+      ),
+      conv1: (await conv('conv1', 1))!,
+      timeEmbProj: loader.hasTensor('${prefix}time_emb_proj.weight')
+          ? await LinearLayer.loadFromSafeTensor(
+              loader,
+              prefix: '${prefix}time_emb_proj.',
+              name: 'time_emb_proj',
+            )
+          : null,
+      norm2: await GroupNorm.loadFromSafeTensor(
+        loader,
+        prefix: '${prefix}norm2.',
+        name: 'norm2',
+        eps: eps,
+        numGroups: 32,
+      ),
+      conv2: (await conv('conv2', 1))!,
+      convShortcut: await conv('conv_shortcut', 0),
+    );
+  }
+}
+
+/// diffusers Downsample2D with a convolution. Padding 0 pads the bottom and
+/// right edges by one before the strided convolution.
+class _Downsample2D extends Module implements SimpleModule {
+  final Conv2D conv;
+  final bool padBottomRight;
+
+  _Downsample2D({
+    required super.name,
+    required this.conv,
+    required this.padBottomRight,
+  });
+
+  @override
+  Tensor forward(Tensor x, {required Context context}) {
+    return context.runForward(this, () {
+      if (padBottomRight) x = x.pad([0, 1, 0, 1]);
+      return conv.forward(x, context: context);
+    });
+  }
+
+  @override
+  void resetParameters() {}
+
+  @override
+  Map<String, dynamic> get meta => {};
+
+  @override
+  Iterable<Tensor> get parameters => [];
+
+  @override
+  Iterable<Module> get submodules => [conv];
+
+  static Future<_Downsample2D> load(
+    SafeTensorLoader loader,
+    String prefix, {
+    required String name,
+    required int padding,
+  }) async {
+    return _Downsample2D(
+      name: name,
+      conv: await Conv2D.loadFromSafeTensor(
+        loader,
+        prefix: '${prefix}conv.',
+        stride: const SymmetricPadding2D.same(2),
+        padding: SymmetricPadding2D.same(padding),
+      ),
+      padBottomRight: padding == 0,
+    );
+  }
+}
+
+class _Block {
+  final String name;
+  final String fixture;
+  final Module module;
+  final Tensor Function(Tensor x, Context context) forward;
+  final Tensor input;
+  final Tensor expected;
+
+  /// Height and width the block runs at in production.
+  final int size;
+
+  _Block({
+    required this.name,
+    required this.fixture,
+    required this.module,
+    required this.forward,
+    required this.input,
+    required this.expected,
+    required this.size,
+  });
+}
+
+typedef _Loader =
+    Future<List<_Block>> Function(
+      SafeTensorLoader loader,
+      String fixture,
+      Device device,
+    );
+
+/// Fixture files, relative to test_data, and how to load their blocks.
+final Map<String, _Loader> _fixtures = {
+  'nn2d/conv2d/conv2d_simple.safetensors': _loadConv2D,
+  'nn2d/conv2d_transpose/simple.safetensors': _loadConvTranspose2D,
+  'resnet/resnet_tests.safetensors': _resnet('simple1', 1e-6, 64),
+  'resnet/resnet_sd15_unet_tests.safetensors': _resnet('unet', 1e-5, 64),
+  'resnet/resnet_sd15_vae_tests.safetensors': _resnet('vae', 1e-6, 64),
+  'unet/upsample/upsample_simple.safetensors': _upsample('upsample', 64),
+  'unet/upsample/upsample_vae.safetensors': _upsample('vae1', 64),
+  'unet/downsample/downsample_simple.safetensors': _downsample(
+    'downsample2d',
+    64,
+  ),
+  'unet/downsample/downsample_vae.safetensors': _downsample('vae1', 512),
+};
+
+Iterable<String> _caseNames(SafeTensorLoader loader) =>
+    loader.tensorInfos.keys.map((t) => t.split('.').first).toSet();
+
+SymmetricPadding2D _metaPadding(SafeTensorLoader loader, String key) =>
+    SymmetricPadding2D.fromPytorchString(loader.header.metadata[key]!);
+
+Future<List<_Block>> _loadConv2D(
+  SafeTensorLoader loader,
+  String fixture,
+  Device device,
+) async {
+  return [
+    for (final name in _caseNames(loader))
+      await () async {
+        PadMode? padMode = PadMode.tryFromPytorchString(
+          loader.header.metadata['$name.padding_mode'],
+        );
+        if (padMode == PadMode.constant) padMode = null;
+        final conv = await Conv2D.loadFromSafeTensor(
+          loader,
+          prefix: '$name.conv.',
+          name: 'conv2d.$name',
+          padding: _metaPadding(loader, '$name.padding'),
+          stride: _metaPadding(loader, '$name.stride'),
+          dilation: _metaPadding(loader, '$name.dilation'),
+          groups: int.parse(loader.header.metadata['$name.groups']!),
+          padMode: padMode,
+        );
+        return _Block(
+          name: conv.name,
+          fixture: fixture,
+          module: conv,
+          forward: (x, context) => conv.forward(x, context: context),
+          input: await loader.loadByName('$name.input', device: device),
+          expected: await loader.loadByName('$name.output', device: device),
+          size: 64,
+        );
+      }(),
+  ];
+}
+
+Future<List<_Block>> _loadConvTranspose2D(
+  SafeTensorLoader loader,
+  String fixture,
+  Device device,
+) async {
+  return [
+    for (final name in _caseNames(loader))
+      await () async {
+        final conv = await ConvTranspose2D.loadFromSafeTensor(
+          loader,
+          prefix: '$name.conv.',
+          name: 'conv_transpose2d.$name',
+          padding: _metaPadding(loader, '$name.padding'),
+          stride: _metaPadding(loader, '$name.stride'),
+          dilation: _metaPadding(loader, '$name.dilation'),
+          groups: int.parse(loader.header.metadata['$name.groups']!),
+          outputPadding: _metaPadding(loader, '$name.output_padding'),
+        );
+        return _Block(
+          name: conv.name,
+          fixture: fixture,
+          module: conv,
+          forward: (x, context) => conv.forward(x, context: context),
+          input: await loader.loadByName('$name.input', device: device),
+          expected: await loader.loadByName('$name.output', device: device),
+          size: 64,
+        );
+      }(),
+  ];
+}
+
+_Loader _resnet(String name, double eps, int size) {
+  return (loader, fixture, device) async {
+    final block = await _ResnetBlock2D.load(
+      loader,
+      '$name.resnet.',
+      name: 'resnet.$name',
+      eps: eps,
+    );
+    final embeds = loader.hasTensor('$name.temb')
+        ? await loader.loadByName('$name.temb', device: device)
+        : null;
+    return [
+      _Block(
+        name: block.name,
+        fixture: fixture,
+        module: block,
+        forward: (x, context) {
+          // The time embedding does not depend on the spatial size.
+          final temb = embeds?.expand([x.shape[0], embeds.shape[1]]);
+          return block.forward(x, embeds: temb, context: context);
+        },
+        input: await loader.loadByName('$name.input', device: device),
+        expected: await loader.loadByName('$name.output', device: device),
+        size: size,
+      ),
+    ];
+  };
+}
+
+_Loader _upsample(String name, int size) {
+  return (loader, fixture, device) async {
+    final input = await loader.loadByName('$name.input', device: device);
+    final upsample = await Upsample2D.loadFromSafeTensor(
+      loader,
+      prefix: '$name.upsample.',
+      name: 'upsample.$name',
+      channels: input.shape[1],
+    );
+    return [
+      _Block(
+        name: upsample.name,
+        fixture: fixture,
+        module: upsample,
+        forward: (x, context) => upsample.forward(x, context: context),
+        input: input,
+        expected: await loader.loadByName('$name.output', device: device),
+        size: size,
+      ),
+    ];
+  };
+}
+
+_Loader _downsample(String name, int size) {
+  return (loader, fixture, device) async {
+    final downsample = await _Downsample2D.load(
+      loader,
+      '$name.downsample.',
+      name: 'downsample.$name',
+      padding: int.parse(loader.header.metadata['$name.padding']!),
+    );
+    return [
+      _Block(
+        name: downsample.name,
+        fixture: fixture,
+        module: downsample,
+        forward: (x, context) => downsample.forward(x, context: context),
+        input: await loader.loadByName('$name.input', device: device),
+        expected: await loader.loadByName('$name.output', device: device),
+        size: size,
+      ),
+    ];
+  };
+}
+
+/// Waits for queued device work by reading back a scalar.
+void _sync(Tensor output, Device device) {
+  if (device.deviceType == DeviceType.cpu) return;
+  output.sum().scalar;
+}
+
+double _round(double value, int digits) =>
+    double.parse(value.toStringAsFixed(digits));
+
+Map<String, dynamic> _run(
+  _Block block,
+  Context context, {
+  required int iterations,
+  required int batch,
+}) {
+  final output = block.forward(block.input, context);
+  final error = (output - block.expected)
+      .to(dataType: DataType.float32)
+      .norm(double.infinity)
+      .scalar as num;
+  final half = block.expected.dataType != DataType.float32;
+  final passed = block.expected.allClose(
+    output,
+    atol: half ? 1e-2 : 1e-3,
+    rtol: 1e-3,
+  );
+
+  final shape = [batch, block.input.shape[1], block.size, block.size];
+  final x = Tensor.randn(
+    shape,
+    device: context.device,
+    datatype: block.input.dataType,
+  );
+  // Warm up: lets oneDNN and cuDNN pick their kernels.
+  _sync(block.forward(x, context), context.device);
+
+  final profiler = ModuleProfiler(model: block.module)..attach(context);
+  final out = block.forward(x, context);
+  _sync(out, context.device);
+  profiler.detach(context);
+  final profile = profiler.root.children.values.single;
+  profiler.dispose();
+
+  final latencies = <double>[];
+  for (int i = 0; i < iterations; i++) {
+    final stopwatch = Stopwatch()..start();
+    _sync(block.forward(x, context), context.device);
+    latencies.add(stopwatch.elapsedMicroseconds / 1000);
+  }
+  latencies.sort();
+  final median = latencies[latencies.length ~/ 2];
+  final mean = latencies.reduce((a, b) => a + b) / latencies.length;
+
+  return {
+    'name': block.name,
+    'fixture': block.fixture,
+    'passed': passed,
+    'maxAbsError': error.toDouble(),
+    'fixtureShape': block.input.shape,
+    'shape': shape,
+    'outputShape': out.shape,
+    'latencyMs': {
+      'median': _round(median, 3),
+      'mean': _round(mean, 3),
+      'min': _round(latencies.first, 3),
+    },
+    'samplesPerSecond': _round(batch * 1000 / median, 2),
+    'peakBytes': profile.peakBytes,
+  };
+}
+
+/// Names of blocks in [current] that are slower than in [baseline] by more
+/// than [tolerance] or stopped matching their fixture.
+List<String> _regressions(
+  List<Map<String, dynamic>> current,
+  Map<String, dynamic> baseline,
+  double tolerance,
+) {
+  final previous = {
+    for (final block in baseline['blocks'] as List) block['name']: block,
+  };
+  final regressions = <String>[];
+  for (final block in current) {
+    final before = previous[block['name']];
+    if (before == null) continue;
+    final now = block['latencyMs']['median'] as num;
+    final then = before['latencyMs']['median'] as num;
+    if (now > then * (1 + tolerance)) {
+      regressions.add(
+        '${block['name']}: ${then}ms -> ${now}ms '
+        '(+${((now / then - 1) * 100).toStringAsFixed(1)}%)',
+      );
+    }
+    if (before['passed'] == true && block['passed'] != true) {
+      regressions.add('${block['name']}: no longer matches its fixture');
+    }
+  }
+  return regressions;
+}
+
+Future<void> main(List<String> args) async {
+  final options = <String, String>{};
+  for (int i = 0; i + 1 < args.length; i += 2) {
+    options[args[i].replaceFirst('--', '')] = args[i + 1];
+  }
+  final iterations = int.parse(options['iterations'] ?? '10');
+  final batch = int.parse(options['batch'] ?? '1');
+  final tolerance = double.parse(options['tolerance'] ?? '0.1');
+  final context = Context.best();
+
+  final results = <Map<String, dynamic>>[];
+  final skipped = <String>[];
+  for (final MapEntry(key: fixture, value: load) in _fixtures.entries) {
+    final path = './test_data/$fixture';
+    if (!File(path).existsSync()) {
+      skipped.add(fixture);
+      continue;
+    }
+    final file = await SafeTensorsFile.load(path);
+    final loader = file.mmapTensorLoader();
+    for (final block in await load(loader, fixture, context.device)) {
+      results.add(
+        _run(block, context, iterations: iterations, batch: batch),
+      );
+    }
+  }
+  results.sort((a, b) => (a['name'] as String).compareTo(b['name']));
+
+  print('block\tshape\tmedian ms\tsamples/s\tpeak MiB\tmax err\tok');
+  for (final r in results) {
+    print(
+      '${r['name']}\t${(r['shape'] as List).join('x')}\t'
+      '${r['latencyMs']['median']}\t${r['samplesPerSecond']}\t'
+      '${((r['peakBytes'] as int) / (1 << 20)).toStringAsFixed(1)}\t'
+      '${(r['maxAbsError'] as double).toStringAsExponential(2)}\t'
+      '${r['passed']}',
+    );
+  }
+  for (final fixture in skipped) {
+    print('skipped $fixture: not generated');
+  }
+
+  final report = {
+    'schema': _schema,
+    'device': context.device.toString(),
+    'batch': batch,
+    'iterations': iterations,
+    'blocks': results,
+  };
+  final out = options['out'];
+  if (out != null) {
+    File(out).writeAsStringSync(
+      '${const JsonEncoder.withIndent('  ').convert(report)}\n',
+    );
+  }
+
+  final baselinePath = options['baseline'];
+  final failed = results.where((r) => r['passed'] != true).length;
+  if (baselinePath != null) {
+    final baseline = jsonDecode(File(baselinePath).readAsStringSync());
+    if (baseline['schema'] != _schema) {
+      throw Exception('Baseline $baselinePath has another schema');
+    }
+    final regressions = _regressions(results, baseline, tolerance);
+    for (final regression in regressions) {
+      print('REGRESSION $regression');
+    }
+    if (regressions.isNotEmpty) exitCode = 1;
+  }
+  if (failed > 0) exitCode = 1;
+}
@@ -0,0 +1,64 @@
+// Benchmarks one classifier-free guidance step with the unconditional and
+// conditional passes batched into a single call and the guidance combined
+// by the fused kernel, against two separate passes combined with
+// subtraction, multiplication and addition.
+//
+// The model stand-in is a pair of 3x3 convolutions at SD latent shapes.
+//
+// Usage: dart run benchmark/classifier_free_guidance.dart [iterations]
+
+import 'package:tensor/tensor.dart';
+
+double _time(void Function() step, int iterations) {
+  step();
+  final stopwatch = Stopwatch()..start();
+  for (int i = 0; i < iterations; i++) {
+    step();
+  }
+  return stopwatch.elapsedMicroseconds / iterations;
+}
+
+void main(List<String> args) {
+  final iterations = args.isNotEmpty ? int.parse(args.first) : 20;
+  final context = Context(isTraining: false, device: Device.cpu);
+  final convIn = Conv2D.make(
+    numInChannels: 4,
+    numOutChannels: 64,
+    padding: const SymmetricPadding2D.same(1),
+  );
+  final convOut = Conv2D.make(
+    numInChannels: 64,
+    numOutChannels: 4,
+    padding: const SymmetricPadding2D.same(1),
+  );
+  Tensor model(Tensor latent, Tensor conditioning) {
+    final hidden = convIn.forward(latent, context: context) + conditioning;
+    return convOut.forward(hidden, context: context);
+  }
+
+  const scale = 7.5;
+  final guidance = ClassifierFreeGuidance(scale: scale);
+  print('batch\tsize\tseparate us\tbatched us\tspeedup');
+  for (final batch in [1, 2]) {
+    for (final size in [64, 96]) {
+      final latent = Tensor.randn([batch, 4, size, size]);
+      final uncond = Tensor.randn([batch, 64, 1, 1]);
+      final cond = Tensor.randn([batch, 64, 1, 1]);
+      final conditioning = guidance.batchConditioning(uncond, cond);
+
+      final separate = _time(() {
+        final u = model(latent, uncond);
+        final c = model(latent, cond);
+        u + (c - u) * scale;
+      }, iterations);
+      final batched = _time(() {
+        guidance.forward(latent, conditioning, model);
+      }, iterations);
+      print(
+        '$batch\t$size\t${separate.toStringAsFixed(1)}\t'
+        '${batched.toStringAsFixed(1)}\t'
+        '${(separate / batched).toStringAsFixed(2)}x',
+      );
+    }
+  }
+}
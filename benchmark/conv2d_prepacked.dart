@@ -0,0 +1,51 @@
+// Benchmarks Conv2D inference with the weight prepacked for oneDNN against
+// the plain convolution, for contiguous and channels-last activations.
+//
+// Shapes are 3x3 convolutions of the Stable Diffusion VAE decoder and UNet.
+//
+// Usage: dart run benchmark/conv2d_prepacked.dart [iterations]
+
+import 'package:tensor/tensor.dart';
+
+double _run(Conv2D conv, Tensor x, Context context, int iterations) {
+  conv.forward(x, context: context);
+  final stopwatch = Stopwatch()..start();
+  for (int i = 0; i < iterations; i++) {
+    conv.forward(x, context: context);
+  }
+  return stopwatch.elapsedMicroseconds / iterations;
+}
+
+void main(List<String> args) {
+  final iterations = args.isNotEmpty ? int.parse(args.first) : 20;
+  // (channels, height and width)
+  const shapes = [(512, 32), (512, 64), (256, 128), (320, 64), (1280, 16)];
+
+  print('channels\tsize\tformat\tplain us\tpacked us\tspeedup');
+  for (final format in [null, MemoryFormat.channelsLast]) {
+    final context = Context(
+      isTraining: false,
+      device: Device.cpu,
+      preferredMemoryFormat: format,
+    );
+    for (final (channels, size) in shapes) {
+      final conv = Conv2D.make(
+        numInChannels: channels,
+        numOutChannels: channels,
+        padding: SymmetricPadding2D.same(1),
+      );
+      final x = context.toPreferredFormat(
+        Tensor.randn([1, channels, size, size]),
+      );
+      conv.usePrepacked = false;
+      final plain = _run(conv, x, context, iterations);
+      conv.usePrepacked = true;
+      final packed = _run(conv, x, context, iterations);
+      print(
+        '$channels\t$size\t${(format ?? MemoryFormat.contiguous).name}\t'
+        '${plain.toStringAsFixed(1)}\t${packed.toStringAsFixed(1)}\t'
+        '${(plain / packed).toStringAsFixed(2)}x',
+      );
+    }
+  }
+}
@@ -0,0 +1,66 @@
+// Benchmarks LinearLayer with a fused activation and the fused gated linear
+// unit against the unfused projection followed by separate elementwise ops,
+// from decode-sized to latent-sized numbers of rows.
+//
+// Shapes are the SD1.5 UNet GEGLU at its widest and a GPT-2 small MLP.
+//
+// Usage: dart run benchmark/fused_linear.dart [iterations]
+
+import 'package:tensor/tensor.dart';
+
+double _time(void Function() run, int iterations) {
+  run();
+  final stopwatch = Stopwatch()..start();
+  for (int i = 0; i < iterations; i++) {
+    run();
+  }
+  return stopwatch.elapsedMicroseconds / iterations;
+}
+
+void main(List<String> args) {
+  final iterations = args.isNotEmpty ? int.parse(args.first) : 20;
+  final context = Context(isTraining: false, device: Device.cpu);
+  const rowCounts = [1, 16, 64, 256, 1024, 4096];
+
+  print('op\tin\tout\trows\tunfused us\tfused us\tspeedup');
+  void report(
+    String op,
+    int inFeatures,
+    int outFeatures,
+    int rows,
+    double unfused,
+    double fused,
+  ) {
+    print(
+      '$op\t$inFeatures\t$outFeatures\t$rows\t'
+      '${unfused.toStringAsFixed(1)}\t${fused.toStringAsFixed(1)}\t'
+      '${(unfused / fused).toStringAsFixed(2)}x',
+    );
+  }
+
+  final geglu = GEGLU.make(inFeatures: 1280, outFeatures: 5120);
+  for (final rows in rowCounts) {
+    final x = Tensor.randn([rows, 1280]);
+    final unfused = _time(() {
+      final projected = geglu.proj.forward(x, context: context);
+      projected.slice(-1, 0, end: 5120) *
+          projected.slice(-1, 5120).gelu(GeluApporimate.none);
+    }, iterations);
+    final fused = _time(() => geglu.forward(x, context: context), iterations);
+    report('geglu', 1280, 5120, rows, unfused, fused);
+  }
+
+  final mlp = LinearLayer.make(inFeatures: 768, outFeatures: 3072);
+  for (final rows in rowCounts) {
+    final x = Tensor.randn([rows, 768]);
+    final unfused = _time(
+      () => mlp.forward(x, context: context).gelu(GeluApporimate.none),
+      iterations,
+    );
+    final fused = _time(
+      () => mlp.forwardActivated(x, Activation.gelu, context: context),
+      iterations,
+    );
+    report('gelu', 768, 3072, rows, unfused, fused);
+  }
+}
@@ -0,0 +1,62 @@
+// Benchmarks LinearLayer at decode-shaped batch sizes with the weight
+// prepacked for oneDNN against the plain linear that repacks every call.
+//
+// Shapes are those of the GPT-2 small MLP. The last line of each data type
+// is the geometric mean speedup over all shapes and batch sizes, which
+// LinearLayer.usePrepacked should default to true on only if it is ahead
+// for both data types on the target machines.
+//
+// Usage: dart run benchmark/linear_decode_prepacked.dart [iterations]
+
+import 'dart:math';
+
+import 'package:tensor/tensor.dart';
+
+double _run(LinearLayer linear, Tensor x, Context context, int iterations) {
+  linear.forward(x, context: context);
+  final stopwatch = Stopwatch()..start();
+  for (int i = 0; i < iterations; i++) {
+    linear.forward(x, context: context);
+  }
+  return stopwatch.elapsedMicroseconds / iterations;
+}
+
+void main(List<String> args) {
+  final iterations = args.isNotEmpty ? int.parse(args.first) : 200;
+  final context = Context(isTraining: false, device: Device.cpu);
+  const shapes = [(768, 3072), (3072, 768)];
+
+  print('dtype\tin\tout\tbatch\tplain us\tpacked us\tspeedup');
+  for (final dataType in [DataType.float32, DataType.bFloat16]) {
+    double logSpeedups = 0;
+    int runs = 0;
+    for (final (inFeatures, outFeatures) in shapes) {
+      final linear = LinearLayer.make(
+        inFeatures: inFeatures,
+        outFeatures: outFeatures,
+        dataType: dataType,
+      );
+      for (final batch in [1, 2, 4, 8, 16]) {
+        final x = Tensor.randn([batch, 1, inFeatures]).to(dataType: dataType);
+        linear.usePrepacked = false;
+        final plain = _run(linear, x, context, iterations);
+        // Packed for this batch size, as a decode loop would be.
+        linear
+          ..invalidatePacked()
+          ..usePrepacked = true;
+        final packed = _run(linear, x, context, iterations);
+        logSpeedups += log(plain / packed);
+        runs++;
+        print(
+          '${dataType.name}\t$inFeatures\t$outFeatures\t$batch\t'
+          '${plain.toStringAsFixed(1)}\t${packed.toStringAsFixed(1)}\t'
+          '${(plain / packed).toStringAsFixed(2)}x',
+        );
+      }
+    }
+    print(
+      '${dataType.name}\tgeometric mean speedup '
+      '${exp(logSpeedups / runs).toStringAsFixed(2)}x',
+    );
+  }
+}
@@ -0,0 +1,127 @@
+// Benchmarks a Stable Diffusion 1.5 VAE decoder shaped conv stack with
+// NCHW activations against channels-last activations.
+//
+// Weights are random; only the layer shapes match the SD1.5 decoder. The
+// mid-block attention is left out since it does not go through the 2D conv
+// stack.
+//
+// Usage: dart run benchmark/vae_decoder_memory_format.dart [latentSize]
+
+import 'package:tensor/tensor.dart';
+
+class _ResnetBlock {
+  final GroupNorm norm1;
+  final Conv2D conv1;
+  final GroupNorm norm2;
+  final Conv2D conv2;
+  final Conv2D? shortcut;
+
+  _ResnetBlock(int inChannels, int outChannels)
+    : norm1 = GroupNorm.make(numGroups: 32, numChannels: inChannels),
+      conv1 = _conv3x3(inChannels, outChannels),
+      norm2 = GroupNorm.make(numGroups: 32, numChannels: outChannels),
+      conv2 = _conv3x3(outChannels, outChannels),
+      shortcut = inChannels == outChannels
+          ? null
+          : Conv2D.make(
+              numInChannels: inChannels,
+              numOutChannels: outChannels,
+              kernelSize: const SymmetricPadding2D.same(1),
+            );
+
+  Tensor forward(Tensor x, Context context) {
+    Tensor h = norm1.forward(x, context: context).silu();
+    h = conv1.forward(h, context: context);
+    h = norm2.forward(h, context: context).silu();
+    h = conv2.forward(h, context: context);
+    final residual = shortcut?.forward(x, context: context) ?? x;
+    return context.checkLayout('add', residual + h);
+  }
+}
+
+Conv2D _conv3x3(int inChannels, int outChannels) => Conv2D.make(
+  numInChannels: inChannels,
+  numOutChannels: outChannels,
+  padding: const SymmetricPadding2D.same(1),
+);
+
+class _Decoder {
+  final Conv2D convIn = _conv3x3(4, 512);
+  final List<_ResnetBlock> mid = [
+    _ResnetBlock(512, 512),
+    _ResnetBlock(512, 512),
+  ];
+  final List<List<_ResnetBlock>> up = [];
+  final List<Conv2D?> upsample = [];
+  final GroupNorm normOut = GroupNorm.make(numGroups: 32, numChannels: 128);
+  final Conv2D convOut = _conv3x3(128, 3);
+
+  _Decoder() {
+    const channels = [512, 512, 256, 128];
+    int previous = 512;
+    for (int i = 0; i < channels.length; i++) {
+      up.add([
+        for (int j = 0; j < 3; j++)
+          _ResnetBlock(j == 0 ? previous : channels[i], channels[i]),
+      ]);
+      upsample.add(
+        i == channels.length - 1 ? null : _conv3x3(channels[i], channels[i]),
+      );
+      previous = channels[i];
+    }
+  }
+
+  Tensor forward(Tensor z, Context context) {
+    Tensor x = convIn.forward(z, context: context);
+    for (final block in mid) {
+      x = block.forward(x, context);
+    }
+    for (int i = 0; i < up.length; i++) {
+      for (final block in up[i]) {
+        x = block.forward(x, context);
+      }
+      final conv = upsample[i];
+      if (conv != null) {
+        x = interpolateNearest(x, [x.shape[2] * 2, x.shape[3] * 2]);
+        x = context.checkLayout('upsample_nearest2d', x);
+        x = conv.forward(x, context: context);
+      }
+    }
+    x = normOut.forward(x, context: context).silu();
+    return convOut.forward(x, context: context);
+  }
+}
+
+double _run(_Decoder decoder, Tensor z, Context context, int iterations) {
+  // Warm up: converts weights and lets oneDNN pick its kernels.
+  decoder.forward(z, context);
+  final stopwatch = Stopwatch()..start();
+  for (int i = 0; i < iterations; i++) {
+    decoder.forward(z, context);
+  }
+  return stopwatch.elapsedMilliseconds / iterations;
+}
+
+void main(List<String> args) {
+  final latentSize = args.isNotEmpty ? int.parse(args.first) : 32;
+  const iterations = 3;
+  final z = Tensor.randn([1, 4, latentSize, latentSize]);
+
+  final nchw = Context(isTraining: false, device: Device.cpu);
+  final nchwMs = _run(_Decoder(), z, nchw, iterations);
+
+  final channelsLast = Context(
+    isTraining: false,
+    device: Device.cpu,
+    preferredMemoryFormat: MemoryFormat.channelsLast,
+  );
+  final channelsLastMs = _run(_Decoder(), z, channelsLast, iterations);
+
+  print('latent ${latentSize}x$latentSize, $iterations iterations');
+  print('NCHW:          ${nchwMs.toStringAsFixed(1)} ms');
+  print('channels-last: ${channelsLastMs.toStringAsFixed(1)} ms');
+  print('speedup:       ${(nchwMs / channelsLastMs).toStringAsFixed(2)}x');
+  if (channelsLast.layoutFallbacks.isNotEmpty) {
+    print('layout fallbacks: ${channelsLast.layoutFallbacks}');
+  }
+}
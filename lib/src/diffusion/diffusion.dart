@@ -0,0 +1,2 @@
+export 'sampler.dart';
+export 'guidance.dart';
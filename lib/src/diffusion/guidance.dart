@@ -0,0 +1,67 @@
+import 'dart:ffi' as ffi;
+
+import 'package:ffi/ffi.dart' as ffi;
+import 'package:tensor/tensor.dart';
+import 'package:tensor/src/ffi/torch_ffi.dart';
+
+/// Classifier-free guidance with the unconditional and conditional passes
+/// batched into a single model call.
+///
+/// The batch is laid out as `[uncond, cond]` along dimension 0.
+class ClassifierFreeGuidance {
+  double scale;
+
+  ClassifierFreeGuidance({this.scale = 7.5});
+
+  /// Guidance is a no-op at scale 1 and the unconditional pass can be
+  /// skipped entirely.
+  bool get isEnabled => scale != 1;
+
+  /// Doubles [latent] along the batch dimension for the batched pass.
+  Tensor batchInput(Tensor latent) {
+    if (!isEnabled) return latent;
+    return Tensor.cat([latent, latent]);
+  }
+
+  /// Stacks the [unconditional] and [conditional] embeddings along the batch
+  /// dimension in the order [combine] expects. Compute it once per prompt.
+  Tensor batchConditioning(Tensor unconditional, Tensor conditional) {
+    if (!isEnabled) return conditional;
+    return Tensor.cat([unconditional, conditional]);
+  }
+
+  /// `uncond + scale * (cond - uncond)` read directly from the two halves of
+  /// the batched [output].
+  Tensor combine(Tensor output) {
+    if (!isEnabled) return output;
+    return combineHalves(output, scale);
+  }
+
+  /// Runs [model] once on the doubled batch and combines the result.
+  Tensor forward(
+    Tensor latent,
+    Tensor conditioning,
+    Tensor Function(Tensor latent, Tensor conditioning) model,
+  ) {
+    return combine(model(batchInput(latent), conditioning));
+  }
+
+  static Tensor combineHalves(Tensor output, double scale) {
+    final arena = ffi.Arena();
+    try {
+      final errorPtr = arena.allocate<ffi.Pointer<ffi.Utf8>>(
+        ffi.sizeOf<ffi.Pointer<ffi.Utf8>>(),
+      );
+      errorPtr.value = ffi.nullptr;
+      final tensor = FFIGuidance.combine(output.nativePtr, scale, errorPtr);
+      if (errorPtr.value != ffi.nullptr) {
+        final error = errorPtr.value.toDartString();
+        ffi.malloc.free(errorPtr.value);
+        throw Exception(error);
+      }
+      return Tensor(tensor);
+    } finally {
+      arena.releaseAll();
+    }
+  }
+}
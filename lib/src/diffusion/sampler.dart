@@ -0,0 +1,154 @@
+import 'dart:ffi' as ffi;
+
+import 'package:ffi/ffi.dart' as ffi;
+import 'package:tensor/tensor.dart';
+import 'package:tensor/src/ffi/torch_ffi.dart';
+
+/// Scheduler step updates applied in place on the latent in a single fused
+/// pass, instead of a chain of latent-sized elementwise ops.
+abstract class SamplerUtil {
+  /// `x = a * x + c1 * t1 + c2 * t2 + noiseScale * N(0, 1)`.
+  static void step_(
+    Tensor x, {
+    double a = 1,
+    Tensor? t1,
+    double c1 = 0,
+    Tensor? t2,
+    double c2 = 0,
+    double noiseScale = 0,
+    Generator? generator,
+  }) {
+    _call(
+      (error) => FFISampler.step_(
+        x.nativePtr,
+        a,
+        t1?.nativePtr ?? ffi.nullptr,
+        c1,
+        t2?.nativePtr ?? ffi.nullptr,
+        c2,
+        noiseScale,
+        generator?.nativePtr ?? ffi.nullptr,
+        error,
+      ),
+    );
+  }
+
+  /// Euler step from [sigma] to [sigmaNext] given the [denoised] prediction.
+  /// [eta] > 0 makes it ancestral, adding noise from [generator].
+  static void eulerStep_(
+    Tensor x,
+    Tensor denoised, {
+    required double sigma,
+    required double sigmaNext,
+    double eta = 0,
+    Generator? generator,
+  }) {
+    _call(
+      (error) => FFISampler.eulerStep_(
+        x.nativePtr,
+        denoised.nativePtr,
+        sigma,
+        sigmaNext,
+        eta,
+        generator?.nativePtr ?? ffi.nullptr,
+        error,
+      ),
+    );
+  }
+
+  /// DDIM step between timesteps with cumulative alphas [alphaCumprod] and
+  /// [alphaCumprodPrev] given the [noisePrediction].
+  static void ddimStep_(
+    Tensor x,
+    Tensor noisePrediction, {
+    required double alphaCumprod,
+    required double alphaCumprodPrev,
+    double eta = 0,
+    Generator? generator,
+  }) {
+    _call(
+      (error) => FFISampler.ddimStep_(
+        x.nativePtr,
+        noisePrediction.nativePtr,
+        alphaCumprod,
+        alphaCumprodPrev,
+        eta,
+        generator?.nativePtr ?? ffi.nullptr,
+        error,
+      ),
+    );
+  }
+
+  /// DPM-Solver++(2M) step. [previousDenoised] and [sigmaPrevious] come from
+  /// the previous step and are null on the first one.
+  static void dpmpp2mStep_(
+    Tensor x,
+    Tensor denoised, {
+    Tensor? previousDenoised,
+    required double sigma,
+    required double sigmaNext,
+    double? sigmaPrevious,
+  }) {
+    assert((previousDenoised == null) == (sigmaPrevious == null));
+    _call(
+      (error) => FFISampler.dpmpp2mStep_(
+        x.nativePtr,
+        denoised.nativePtr,
+        previousDenoised?.nativePtr ?? ffi.nullptr,
+        sigma,
+        sigmaNext,
+        sigmaPrevious ?? 0,
+        error,
+      ),
+    );
+  }
+
+  static void _call(void Function(ffi.Pointer<ffi.Pointer<ffi.Utf8>>) op) {
+    final arena = ffi.Arena();
+    try {
+      final errorPtr = arena.allocate<ffi.Pointer<ffi.Utf8>>(
+        ffi.sizeOf<ffi.Pointer<ffi.Utf8>>(),
+      );
+      errorPtr.value = ffi.nullptr;
+      op(errorPtr);
+      if (errorPtr.value != ffi.nullptr) {
+        final error = errorPtr.value.toDartString();
+        ffi.malloc.free(errorPtr.value);
+        throw Exception(error);
+      }
+    } finally {
+      arena.releaseAll();
+    }
+  }
+}
+
+/// DPM-Solver++(2M) over a decreasing [sigmas] schedule ending in 0,
+/// keeping the previous denoised prediction between steps.
+class DPMPP2MSampler {
+  final List<double> sigmas;
+
+  Tensor? _previousDenoised;
+
+  int _step = 0;
+
+  DPMPP2MSampler(this.sigmas);
+
+  int get step => _step;
+
+  bool get isDone => _step >= sigmas.length - 1;
+
+  /// Advances [x] in place by one step given the model's [denoised]
+  /// prediction at `sigmas[step]`.
+  void step_(Tensor x, Tensor denoised) {
+    SamplerUtil.dpmpp2mStep_(
+      x,
+      denoised,
+      previousDenoised: _previousDenoised,
+      sigma: sigmas[_step],
+      sigmaNext: sigmas[_step + 1],
+      sigmaPrevious: _previousDenoised == null ? null : sigmas[_step - 1],
+    );
+    _previousDenoised = denoised;
+    _step++;
+  }
+}
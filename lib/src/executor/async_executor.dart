@@ -0,0 +1,163 @@
+import 'dart:async';
+import 'dart:ffi' as ffi;
+
+import 'package:ffi/ffi.dart' as ffi;
+import 'package:tensor/tensor.dart';
+import 'package:tensor/src/ffi/torch_ffi.dart';
+
+enum AsyncRequestStatus { queued, running, finished }
+
+/// A tape submitted to an [AsyncExecutor].
+class AsyncRequest {
+  final int id;
+
+  /// Completes with the outputs of the tape, in the order they were marked
+  /// with [OpTape.output].
+  final Future<List<Tensor>> result;
+
+  final AsyncExecutor _executor;
+
+  AsyncRequest._(this.id, this.result, this._executor);
+
+  /// How far the request has got: ops of the tape that completed and the
+  /// total number of ops. Finished requests report no progress.
+  ({AsyncRequestStatus status, int done, int total}) get progress =>
+      _executor._progress(id);
+}
+
+/// Runs [OpTape]s on native worker threads so that long ops such as large
+/// convolutions or a VAE decode do not block this isolate's event loop.
+///
+/// Requests submitted to the same stream run one after the other in
+/// submission order; requests on different streams may run concurrently,
+/// up to the number of worker threads. Grad mode and autocast state are
+/// taken from this isolate's thread at submission. Completions arrive as
+/// messages on this isolate through a [ffi.NativeCallable.listener].
+///
+/// ```dart
+/// final executor = AsyncExecutor(threads: 2);
+/// final decoded = await executor.run('aten::conv2d', [x, w, b]);
+/// await executor.close();
+/// ```
+class AsyncExecutor {
+  final ffi.Pointer<ffi.Void> _nativePtr;
+
+  final ffi.NativeCallable<CExecutorCompletion> _completion;
+
+  final Map<int, Completer<List<Tensor>>> _pending;
+
+  bool _closed = false;
+
+  AsyncExecutor._(this._nativePtr, this._completion, this._pending);
+
+  factory AsyncExecutor({int threads = 1}) {
+    final pending = <int, Completer<List<Tensor>>>{};
+    final completion = ffi.NativeCallable<CExecutorCompletion>.listener((
+      int requestId,
+      ffi.Pointer<CTensor> outputs,
+      int count,
+      ffi.Pointer<ffi.Utf8> error,
+    ) {
+      final completer = pending.remove(requestId);
+      if (error != ffi.nullptr) {
+        final message = error.toDartString();
+        ffi.malloc.free(error);
+        completer?.completeError(Exception(message));
+        return;
+      }
+      final tensors = [for (int i = 0; i < count; i++) Tensor(outputs[i])];
+      ffi.malloc.free(outputs);
+      completer?.complete(tensors);
+    });
+    final nativePtr = FFIExecutor.create(threads, completion.nativeFunction);
+    return AsyncExecutor._(nativePtr, completion, pending);
+  }
+
+  /// Number of submitted requests that have not completed yet.
+  int get pending => _pending.length;
+
+  /// Queues [tape] on [stream]. The tape is copied, so it may be changed,
+  /// submitted again or released right away.
+  AsyncRequest submit(OpTape tape, {int stream = 0}) {
+    if (_closed) throw StateError('AsyncExecutor is closed');
+    final arena = ffi.Arena();
+    try {
+      final errorPtr = arena.allocate<ffi.Pointer<ffi.Utf8>>(
+        ffi.sizeOf<ffi.Pointer<ffi.Utf8>>(),
+      );
+      errorPtr.value = ffi.nullptr;
+      final id = FFIExecutor.submit(
+        _nativePtr,
+        tape.nativePtr,
+        stream,
+        errorPtr,
+      );
+      if (errorPtr.value != ffi.nullptr) {
+        final error = errorPtr.value.toDartString();
+        ffi.malloc.free(errorPtr.value);
+        throw Exception(error);
+      }
+      // The completion is delivered as a message, so it cannot arrive
+      // before the completer is registered.
+      final completer = _pending[id] = Completer<List<Tensor>>();
+      return AsyncRequest._(id, completer.future, this);
+    } finally {
+      arena.releaseAll();
+    }
+  }
+
+  /// Runs the single operator [name] on [stream] and returns its first
+  /// output.
+  Future<Tensor> run(
+    String name,
+    List<Object?> args, {
+    String overload = '',
+    int stream = 0,
+  }) async {
+    final tape = OpTape();
+    try {
+      tape.output(tape.op(name, args, overload: overload));
+      return (await submit(tape, stream: stream).result).single;
+    } finally {
+      tape.release();
+    }
+  }
+
+  ({AsyncRequestStatus status, int done, int total}) _progress(int id) {
+    if (_closed) {
+      return (status: AsyncRequestStatus.finished, done: 0, total: 0);
+    }
+    final arena = ffi.Arena();
+    try {
+      final done = arena.allocate<ffi.Int64>(ffi.sizeOf<ffi.Int64>());
+      final total = arena.allocate<ffi.Int64>(ffi.sizeOf<ffi.Int64>());
+      done.value = 0;
+      total.value = 0;
+      final status = switch (FFIExecutor.progress(
+        _nativePtr,
+        id,
+        done,
+        total,
+      )) {
+        1 => AsyncRequestStatus.queued,
+        2 => AsyncRequestStatus.running,
+        _ => AsyncRequestStatus.finished,
+      };
+      return (status: status, done: done.value, total: total.value);
+    } finally {
+      arena.releaseAll();
+    }
+  }
+
+  /// Waits for the submitted requests and stops the worker threads.
+  Future<void> close() async {
+    if (_closed) return;
+    _closed = true;
+    // Waits for every request, including after one of them failed.
+    await Future.wait([
+      for (final completer in _pending.values) completer.future,
+    ]).catchError((_) => <List<Tensor>>[]);
+    FFIExecutor.delete(_nativePtr);
+    _completion.close();
+  }
+}
@@ -0,0 +1,2 @@
+export 'async_executor.dart';
+export 'op_tape.dart';
@@ -0,0 +1,188 @@
+import 'dart:ffi' as ffi;
+
+import 'package:ffi/ffi.dart' as ffi;
+import 'package:tensor/tensor.dart';
+import 'package:tensor/src/ffi/torch_ffi.dart';
+
+/// A value on an [OpTape]: a captured tensor or an output of a recorded op.
+class TapeValue {
+  final int slot;
+
+  const TapeValue._(this.slot);
+
+  @override
+  String toString() => 'TapeValue($slot)';
+}
+
+/// A sequence of ATen operator calls recorded for later execution, e.g. on
+/// an [AsyncExecutor].
+///
+/// Ops are looked up by their schema name, such as `aten::conv2d`, and
+/// called through the libtorch dispatcher, so any registered operator can
+/// be recorded. Arguments may be [Tensor]s, which are captured by reference
+/// when recorded, [TapeValue]s of earlier ops, `int`, `double`, `bool`,
+/// `String`, [DataType], `List<int>`, lists of tensors and values, and
+/// `null`. Trailing arguments that are left out take their schema
+/// defaults.
+///
+/// ```dart
+/// final tape = OpTape();
+/// final h = tape.op('aten::conv2d', [x, weight, bias, [1, 1], [1, 1]]);
+/// tape.output(tape.op('aten::silu', [h]));
+/// ```
+class OpTape implements ffi.Finalizable {
+  final ffi.Pointer<ffi.Void> nativePtr;
+
+  final Map<Tensor, TapeValue> _captured = Map.identity();
+
+  OpTape._(this.nativePtr) {
+    _finalizer.attach(this, nativePtr, detach: this);
+  }
+
+  factory OpTape() => OpTape._(FFIOpTape.create());
+
+  static final _finalizer = ffi.NativeFinalizer(FFIOpTape.delete);
+
+  void release() {
+    _finalizer.detach(this);
+    FFIOpTape.deleteTape(nativePtr);
+  }
+
+  /// Number of recorded ops.
+  int get length => FFIOpTape.length(nativePtr);
+
+  /// Captures [tensor] on the tape. Each tensor is captured once.
+  TapeValue capture(Tensor tensor) => _captured[tensor] ??= TapeValue._(
+    FFIOpTape.capture(nativePtr, tensor.nativePtr),
+  );
+
+  /// Records a call of the operator [name] with [overload] and returns its
+  /// outputs.
+  List<TapeValue> call(
+    String name,
+    List<Object?> args, {
+    String overload = '',
+  }) {
+    final arena = ffi.Arena();
+    try {
+      // Tensors are captured and arguments checked before any argument is
+      // pushed, so that a bad argument does not leave a partial call.
+      final slots = [for (final arg in args) _slotsOf(arg)];
+      for (int i = 0; i < args.length; i++) {
+        if (slots[i] == null) _checkArg(args[i]);
+      }
+      for (int i = 0; i < args.length; i++) {
+        _pushArg(args[i], slots[i], arena);
+      }
+      final numOutputs = arena.allocate<ffi.Int64>(ffi.sizeOf<ffi.Int64>());
+      final errorPtr = arena.allocate<ffi.Pointer<ffi.Utf8>>(
+        ffi.sizeOf<ffi.Pointer<ffi.Utf8>>(),
+      );
+      errorPtr.value = ffi.nullptr;
+      final first = FFIOpTape.call(
+        nativePtr,
+        name.toNativeUtf8(allocator: arena),
+        overload.toNativeUtf8(allocator: arena),
+        numOutputs,
+        errorPtr,
+      );
+      if (errorPtr.value != ffi.nullptr) {
+        final error = errorPtr.value.toDartString();
+        ffi.malloc.free(errorPtr.value);
+        throw Exception(error);
+      }
+      return [
+        for (int i = 0; i < numOutputs.value; i++) TapeValue._(first + i),
+      ];
+    } finally {
+      arena.releaseAll();
+    }
+  }
+
+  /// Records a call of the operator [name] and returns its first output.
+  TapeValue op(String name, List<Object?> args, {String overload = ''}) =>
+      call(name, args, overload: overload).first;
+
+  /// Marks [value] as an output of the tape, in the order of the calls.
+  void output(Object value) {
+    final slot = switch (value) {
+      TapeValue() => value.slot,
+      Tensor() => capture(value).slot,
+      _ => throw ArgumentError.value(value, 'value', 'Not a tape value'),
+    };
+    final arena = ffi.Arena();
+    try {
+      final errorPtr = arena.allocate<ffi.Pointer<ffi.Utf8>>(
+        ffi.sizeOf<ffi.Pointer<ffi.Utf8>>(),
+      );
+      errorPtr.value = ffi.nullptr;
+      FFIOpTape.output(nativePtr, slot, errorPtr);
+      if (errorPtr.value != ffi.nullptr) {
+        final error = errorPtr.value.toDartString();
+        ffi.malloc.free(errorPtr.value);
+        throw Exception(error);
+      }
+    } finally {
+      arena.releaseAll();
+    }
+  }
+
+  List<int>? _slotsOf(Object? arg) {
+    if (arg is Tensor) return [capture(arg).slot];
+    if (arg is TapeValue) return [arg.slot];
+    if (arg is List && arg.isNotEmpty && arg.first is! int) {
+      return [
+        for (final item in arg)
+          switch (item) {
+            Tensor() => capture(item).slot,
+            TapeValue() => item.slot,
+            _ => throw ArgumentError.value(arg, 'args', 'Mixed list'),
+          },
+      ];
+    }
+    return null;
+  }
+
+  void _pushArg(Object? arg, List<int>? slots, ffi.Arena arena) {
+    if (slots != null && (arg is Tensor || arg is TapeValue)) {
+      FFIOpTape.argSlot(nativePtr, slots.single);
+      return;
+    }
+    if (slots != null) {
+      final pointer = arena.allocate<ffi.Int64>(
+        ffi.sizeOf<ffi.Int64>() * slots.length,
+      );
+      pointer.asTypedList(slots.length).setAll(0, slots);
+      FFIOpTape.argSlotList(nativePtr, pointer, slots.length);
+      return;
+    }
+    switch (arg) {
+      case null:
+        FFIOpTape.argNone(nativePtr);
+      case int():
+        FFIOpTape.argInt(nativePtr, arg);
+      case double():
+        FFIOpTape.argDouble(nativePtr, arg);
+      case bool():
+        FFIOpTape.argBool(nativePtr, arg);
+      case String():
+        FFIOpTape.argString(nativePtr, arg.toNativeUtf8(allocator: arena));
+      case DataType():
+        FFIOpTape.argInt(nativePtr, arg.type);
+      case List():
+        final values = arg.cast<int>();
+        final pointer = arena.allocate<ffi.Int64>(
+          ffi.sizeOf<ffi.Int64>() * (values.isEmpty ? 1 : values.length),
+        );
+        pointer.asTypedList(values.length).setAll(0, values);
+        FFIOpTape.argIntList(nativePtr, pointer, values.length);
+    }
+  }
+
+  static void _checkArg(Object? arg) {
+    if (arg == null || arg is int || arg is double || arg is bool) return;
+    if (arg is String || arg is DataType) return;
+    if (arg is List && arg.every((e) => e is int)) return;
+    throw ArgumentError.value(arg, 'args', 'Unsupported tape argument');
+  }
+}
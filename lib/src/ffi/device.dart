@@ -93,6 +93,8 @@ abstract class Device {
         return MPSDevice(deviceIndex: deviceIndex);
       case DeviceType.xpu:
         return XPUDevice(deviceIndex: deviceIndex);
+      case DeviceType.meta:
+        return meta;
       default:
         return UnknownDevice(deviceType: deviceType, deviceIndex: deviceIndex);
     }
@@ -100,6 +102,9 @@ abstract class Device {
 
   static const cpu = CPUDevice();
 
+  /// Tensors on this device have shape and dtype but no data.
+  static const meta = MetaDevice();
+
   static CudaDevice cuda({int deviceIndex = -1}) =>
       CudaDevice(deviceIndex: deviceIndex);
 
@@ -212,6 +217,25 @@ class CPUDevice extends Device {
   int get reservedMemory => throw UnimplementedError();
 }
 
+class MetaDevice extends Device {
+  const MetaDevice() : super.constant();
+
+  @override
+  DeviceType get deviceType => DeviceType.meta;
+
+  @override
+  int get deviceIndex => -1;
+
+  @override
+  int get totalMemory => 0;
+
+  @override
+  int get allocatedMemory => 0;
+
+  @override
+  int get reservedMemory => 0;
+}
+
 class UnknownDevice extends Device {
   @override
   final DeviceType deviceType;
@@ -0,0 +1,110 @@
+import 'dart:ffi';
+
+import 'package:ffi/ffi.dart';
+import 'package:tensor/src/ffi/torch_ffi.dart';
+
+abstract class FFISampler {
+  static final step_ = nativeLib
+      .lookupFunction<
+        Void Function(
+          CTensor,
+          Double,
+          CTensor,
+          Double,
+          CTensor,
+          Double,
+          Double,
+          CGenerator,
+          Pointer<Pointer<Utf8>>,
+        ),
+        void Function(
+          CTensor x,
+          double a,
+          CTensor t1,
+          double c1,
+          CTensor t2,
+          double c2,
+          double noiseScale,
+          CGenerator generator,
+          Pointer<Pointer<Utf8>> error,
+        )
+      >('torchffi_sampler_step_');
+
+  static final eulerStep_ = nativeLib
+      .lookupFunction<
+        Void Function(
+          CTensor,
+          CTensor,
+          Double,
+          Double,
+          Double,
+          CGenerator,
+          Pointer<Pointer<Utf8>>,
+        ),
+        void Function(
+          CTensor x,
+          CTensor denoised,
+          double sigma,
+          double sigmaNext,
+          double eta,
+          CGenerator generator,
+          Pointer<Pointer<Utf8>> error,
+        )
+      >('torchffi_euler_step_');
+
+  static final ddimStep_ = nativeLib
+      .lookupFunction<
+        Void Function(
+          CTensor,
+          CTensor,
+          Double,
+          Double,
+          Double,
+          CGenerator,
+          Pointer<Pointer<Utf8>>,
+        ),
+        void Function(
+          CTensor x,
+          CTensor noisePrediction,
+          double alphaCumprod,
+          double alphaCumprodPrev,
+          double eta,
+          CGenerator generator,
+          Pointer<Pointer<Utf8>> error,
+        )
+      >('torchffi_ddim_step_');
+
+  static final dpmpp2mStep_ = nativeLib
+      .lookupFunction<
+        Void Function(
+          CTensor,
+          CTensor,
+          CTensor,
+          Double,
+          Double,
+          Double,
+          Pointer<Pointer<Utf8>>,
+        ),
+        void Function(
+          CTensor x,
+          CTensor denoised,
+          CTensor previousDenoised,
+          double sigma,
+          double sigmaNext,
+          double sigmaPrevious,
+          Pointer<Pointer<Utf8>> error,
+        )
+      >('torchffi_dpmpp_2m_step_');
+}
+
+abstract class FFIGuidance {
+  static final combine = nativeLib
+      .lookupFunction<
+        CTensor Function(CTensor, Double, Pointer<Pointer<Utf8>>),
+        CTensor Function(
+          CTensor output,
+          double scale,
+          Pointer<Pointer<Utf8>> error,
+        )
+      >('torchffi_guidance_combine');
+}
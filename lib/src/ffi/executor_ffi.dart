@@ -0,0 +1,154 @@
+import 'dart:ffi';
+
+import 'package:ffi/ffi.dart';
+import 'package:tensor/src/ffi/torch_ffi.dart';
+
+typedef COpTape = Pointer<Void>;
+typedef CExecutor = Pointer<Void>;
+typedef CExecutorCompletion =
+    Void Function(
+      Int64 requestId,
+      Pointer<CTensor> outputs,
+      Int64 count,
+      Pointer<Utf8> error,
+    );
+
+abstract class FFIOpTape {
+  static final create = nativeLib
+      .lookupFunction<COpTape Function(), COpTape Function()>(
+        'torchffi_tape_new',
+      );
+
+  static final delete = nativeLib
+      .lookup<NativeFunction<Void Function(COpTape)>>('torchffi_tape_delete');
+
+  static void deleteTape(COpTape tape) {
+    delete.asFunction<void Function(COpTape)>()(tape);
+  }
+
+  static final length = nativeLib
+      .lookupFunction<Int64 Function(COpTape), int Function(COpTape tape)>(
+        'torchffi_tape_length',
+        isLeaf: true,
+      );
+
+  static final capture = nativeLib
+      .lookupFunction<
+        Int64 Function(COpTape, CTensor),
+        int Function(COpTape tape, CTensor tensor)
+      >('torchffi_tape_capture');
+
+  static final argSlot = nativeLib
+      .lookupFunction<
+        Void Function(COpTape, Int64),
+        void Function(COpTape tape, int slot)
+      >('torchffi_tape_arg_slot', isLeaf: true);
+
+  static final argSlotList = nativeLib
+      .lookupFunction<
+        Void Function(COpTape, Pointer<Int64>, Size),
+        void Function(COpTape tape, Pointer<Int64> slots, int count)
+      >('torchffi_tape_arg_slot_list', isLeaf: true);
+
+  static final argInt = nativeLib
+      .lookupFunction<
+        Void Function(COpTape, Int64),
+        void Function(COpTape tape, int value)
+      >('torchffi_tape_arg_int', isLeaf: true);
+
+  static final argDouble = nativeLib
+      .lookupFunction<
+        Void Function(COpTape, Double),
+        void Function(COpTape tape, double value)
+      >('torchffi_tape_arg_double', isLeaf: true);
+
+  static final argBool = nativeLib
+      .lookupFunction<
+        Void Function(COpTape, Bool),
+        void Function(COpTape tape, bool value)
+      >('torchffi_tape_arg_bool', isLeaf: true);
+
+  static final argIntList = nativeLib
+      .lookupFunction<
+        Void Function(COpTape, Pointer<Int64>, Size),
+        void Function(COpTape tape, Pointer<Int64> values, int count)
+      >('torchffi_tape_arg_int_list', isLeaf: true);
+
+  static final argString = nativeLib
+      .lookupFunction<
+        Void Function(COpTape, Pointer<Utf8>),
+        void Function(COpTape tape, Pointer<Utf8> value)
+      >('torchffi_tape_arg_string', isLeaf: true);
+
+  static final argNone = nativeLib
+      .lookupFunction<Void Function(COpTape), void Function(COpTape tape)>(
+        'torchffi_tape_arg_none',
+        isLeaf: true,
+      );
+
+  static final call = nativeLib
+      .lookupFunction<
+        Int64 Function(
+          COpTape,
+          Pointer<Utf8>,
+          Pointer<Utf8>,
+          Pointer<Int64>,
+          Pointer<Pointer<Utf8>>,
+        ),
+        int Function(
+          COpTape tape,
+          Pointer<Utf8> name,
+          Pointer<Utf8> overload,
+          Pointer<Int64> numOutputs,
+          Pointer<Pointer<Utf8>> error,
+        )
+      >('torchffi_tape_call');
+
+  static final output = nativeLib
+      .lookupFunction<
+        Void Function(COpTape, Int64, Pointer<Pointer<Utf8>>),
+        void Function(COpTape tape, int slot, Pointer<Pointer<Utf8>> error)
+      >('torchffi_tape_output');
+}
+
+abstract class FFIExecutor {
+  static final create = nativeLib
+      .lookupFunction<
+        CExecutor Function(
+          Int64,
+          Pointer<NativeFunction<CExecutorCompletion>>,
+        ),
+        CExecutor Function(
+          int threads,
+          Pointer<NativeFunction<CExecutorCompletion>> completion,
+        )
+      >('torchffi_executor_new');
+
+  static final delete = nativeLib
+      .lookupFunction<
+        Void Function(CExecutor),
+        void Function(CExecutor executor)
+      >('torchffi_executor_delete');
+
+  static final submit = nativeLib
+      .lookupFunction<
+        Int64 Function(CExecutor, COpTape, Int64, Pointer<Pointer<Utf8>>),
+        int Function(
+          CExecutor executor,
+          COpTape tape,
+          int stream,
+          Pointer<Pointer<Utf8>> error,
+        )
+      >('torchffi_executor_submit');
+
+  static final progress = nativeLib
+      .lookupFunction<
+        Int32 Function(CExecutor, Int64, Pointer<Int64>, Pointer<Int64>),
+        int Function(
+          CExecutor executor,
+          int requestId,
+          Pointer<Int64> done,
+          Pointer<Int64> total,
+        )
+      >('torchffi_executor_progress', isLeaf: true);
+}
@@ -0,0 +1,36 @@
+import 'dart:ffi';
+
+import 'package:ffi/ffi.dart';
+import 'package:tensor/src/ffi/torch_ffi.dart';
+
+abstract class FFIFlatParameters {
+  static final flatten = nativeLib
+      .lookupFunction<
+        CTensor Function(Pointer<CTensor>, Size, Pointer<Pointer<Utf8>>),
+        CTensor Function(
+          Pointer<CTensor> parameters,
+          int count,
+          Pointer<Pointer<Utf8>> error,
+        )
+      >('torchffi_flatten_parameters');
+
+  static final to = nativeLib
+      .lookupFunction<
+        Void Function(
+          CTensor,
+          Pointer<CTensor>,
+          Size,
+          CTensorOptions,
+          Bool,
+          Pointer<Pointer<Utf8>>,
+        ),
+        void Function(
+          CTensor flat,
+          Pointer<CTensor> parameters,
+          int count,
+          CTensorOptions options,
+          bool nonBlocking,
+          Pointer<Pointer<Utf8>> error,
+        )
+      >('torchffi_flat_parameters_to');
+}
@@ -0,0 +1,58 @@
+import 'dart:ffi';
+
+import 'package:ffi/ffi.dart';
+import 'package:tensor/src/ffi/torch_ffi.dart';
+
+typedef CTracedGraph = Pointer<Void>;
+typedef CTraceForward = Void Function(Pointer<CTensor> output);
+
+abstract class FFIGraph {
+  static final trace = nativeLib
+      .lookupFunction<
+        CTracedGraph Function(
+          Pointer<CTensor>,
+          Size,
+          Pointer<NativeFunction<CTraceForward>>,
+          Bool,
+          Pointer<Pointer<Utf8>>,
+        ),
+        CTracedGraph Function(
+          Pointer<CTensor> inputs,
+          int ninputs,
+          Pointer<NativeFunction<CTraceForward>> forward,
+          bool optimize,
+          Pointer<Pointer<Utf8>> error,
+        )
+      >('torchffi_graph_trace');
+
+  static final delete = nativeLib
+      .lookup<NativeFunction<Void Function(CTracedGraph)>>(
+        'torchffi_graph_delete',
+      );
+
+  static void deleteGraph(CTracedGraph graph) {
+    delete.asFunction<void Function(CTracedGraph)>()(graph);
+  }
+
+  static final run = nativeLib
+      .lookupFunction<
+        CTensor Function(
+          CTracedGraph,
+          Pointer<CTensor>,
+          Size,
+          Pointer<Pointer<Utf8>>,
+        ),
+        CTensor Function(
+          CTracedGraph graph,
+          Pointer<CTensor> inputs,
+          int ninputs,
+          Pointer<Pointer<Utf8>> error,
+        )
+      >('torchffi_graph_run');
+
+  static final dump = nativeLib
+      .lookupFunction<
+        Pointer<Utf8> Function(CTracedGraph),
+        Pointer<Utf8> Function(CTracedGraph graph)
+      >('torchffi_graph_dump');
+}
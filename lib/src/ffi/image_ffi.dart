@@ -0,0 +1,52 @@
+import 'dart:ffi';
+
+import 'package:ffi/ffi.dart';
+import 'package:tensor/src/ffi/torch_ffi.dart';
+
+/// Leaf calls so that Dart typed data can be passed without a copy. They
+/// only take CPU tensors so that they never wait on a device.
+abstract class FFIImage {
+  static final fromUint8 = nativeLib
+      .lookupFunction<
+        CTensor Function(
+          Pointer<Uint8>,
+          Int64,
+          Int64,
+          Int64,
+          Int64,
+          Pointer<Float>,
+          Pointer<Float>,
+          Bool,
+          Pointer<Pointer<Utf8>>,
+        ),
+        CTensor Function(
+          Pointer<Uint8> data,
+          int batch,
+          int height,
+          int width,
+          int channels,
+          Pointer<Float> mean,
+          Pointer<Float> std,
+          bool channelsLast,
+          Pointer<Pointer<Utf8>> error,
+        )
+      >('torchffi_image_from_uint8', isLeaf: true);
+
+  static final toUint8 = nativeLib
+      .lookupFunction<
+        Void Function(
+          CTensor,
+          Pointer<Uint8>,
+          Double,
+          Double,
+          Pointer<Pointer<Utf8>>,
+        ),
+        void Function(
+          CTensor image,
+          Pointer<Uint8> out,
+          double low,
+          double high,
+          Pointer<Pointer<Utf8>> error,
+        )
+      >('torchffi_image_to_uint8', isLeaf: true);
+}
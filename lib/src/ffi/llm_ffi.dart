@@ -0,0 +1,124 @@
+import 'dart:ffi';
+
+import 'package:ffi/ffi.dart';
+import 'package:tensor/src/ffi/torch_ffi.dart';
+
+typedef CKVCache = Pointer<Void>;
+
+abstract class FFIKVCache {
+  static final constructor = nativeLib
+      .lookupFunction<
+        CKVCache Function(Int64, Pointer<Int64>, Size, Int64, CTensorOptions),
+        CKVCache Function(
+          int numLayers,
+          Pointer<Int64> sizes,
+          int ndims,
+          int seqDim,
+          CTensorOptions options,
+        )
+      >('torchffi_kv_cache_new');
+
+  static final delete = nativeLib
+      .lookup<NativeFunction<Void Function(CKVCache)>>(
+        'torchffi_kv_cache_delete',
+      );
+
+  static void deleteCache(CKVCache cache) {
+    delete.asFunction<void Function(CKVCache)>()(cache);
+  }
+
+  static final length = nativeLib
+      .lookupFunction<
+        Int64 Function(CKVCache, Int64, Pointer<Pointer<Utf8>>),
+        int Function(CKVCache cache, int layer, Pointer<Pointer<Utf8>> error)
+      >('torchffi_kv_cache_length');
+
+  static final capacity = nativeLib
+      .lookupFunction<
+        Int64 Function(CKVCache, Int64, Pointer<Pointer<Utf8>>),
+        int Function(CKVCache cache, int layer, Pointer<Pointer<Utf8>> error)
+      >('torchffi_kv_cache_capacity');
+
+  static final update = nativeLib
+      .lookupFunction<
+        Void Function(
+          CKVCache,
+          Int64,
+          CTensor,
+          CTensor,
+          Pointer<CTensor>,
+          Pointer<CTensor>,
+          Pointer<Pointer<Utf8>>,
+        ),
+        void Function(
+          CKVCache cache,
+          int layer,
+          CTensor key,
+          CTensor value,
+          Pointer<CTensor> keysOut,
+          Pointer<CTensor> valuesOut,
+          Pointer<Pointer<Utf8>> error,
+        )
+      >('torchffi_kv_cache_update');
+
+  static final truncate = nativeLib
+      .lookupFunction<
+        Void Function(CKVCache, Int64),
+        void Function(CKVCache cache, int length)
+      >('torchffi_kv_cache_truncate');
+}
+
+abstract class FFILLM {
+  static final speculativeVerify = nativeLib
+      .lookupFunction<
+        Int64 Function(
+          CTensor,
+          CTensor,
+          CTensor,
+          Bool,
+          CGenerator,
+          Pointer<Int64>,
+          Pointer<Pointer<Utf8>>,
+        ),
+        int Function(
+          CTensor draftProbs,
+          CTensor targetProbs,
+          CTensor draftTokens,
+          bool greedy,
+          CGenerator generator,
+          Pointer<Int64> nextToken,
+          Pointer<Pointer<Utf8>> error,
+        )
+      >('torchffi_speculative_verify');
+
+  static final rotaryEmbedding_ = nativeLib
+      .lookupFunction<
+        Void Function(
+          CTensor,
+          CTensor,
+          Int64,
+          Double,
+          Double,
+          Int64,
+          Int64,
+          Bool,
+          Pointer<Pointer<Utf8>>,
+        ),
+        void Function(
+          CTensor query,
+          CTensor key,
+          int rotaryDim,
+          double base,
+          double scaling,
+          int positionOffset,
+          int seqDim,
+          bool interleaved,
+          Pointer<Pointer<Utf8>> error,
+        )
+      >('torchffi_rotary_embedding_');
+
+  static final rotaryEmbeddingCacheClear = nativeLib
+      .lookupFunction<Void Function(), void Function()>(
+        'torchffi_rotary_embedding_cache_clear',
+      );
+}
@@ -0,0 +1,104 @@
+import 'dart:ffi';
+
+import 'package:ffi/ffi.dart';
+import 'package:tensor/src/ffi/torch_ffi.dart';
+
+typedef CPackedConv2D = Pointer<Void>;
+
+abstract class FFIPackedConv2D {
+  static final prepack = nativeLib
+      .lookupFunction<
+        CPackedConv2D Function(
+          CTensor,
+          CTensor,
+          Pointer<Int64>,
+          Pointer<Int64>,
+          Pointer<Int64>,
+          Int64,
+          Pointer<Int64>,
+          Size,
+          Pointer<Pointer<Utf8>>,
+        ),
+        CPackedConv2D Function(
+          CTensor weight,
+          CTensor bias,
+          Pointer<Int64> stride,
+          Pointer<Int64> padding,
+          Pointer<Int64> dilation,
+          int groups,
+          Pointer<Int64> inputSizes,
+          int ndims,
+          Pointer<Pointer<Utf8>> error,
+        )
+      >('torchffi_conv2d_prepack');
+
+  static final delete = nativeLib
+      .lookup<NativeFunction<Void Function(CPackedConv2D)>>(
+        'torchffi_conv2d_packed_delete',
+      );
+
+  static void deletePacked(CPackedConv2D packed) {
+    delete.asFunction<void Function(CPackedConv2D)>()(packed);
+  }
+
+  static final isMkldnn = nativeLib
+      .lookupFunction<
+        Bool Function(CPackedConv2D),
+        bool Function(CPackedConv2D packed)
+      >('torchffi_conv2d_packed_is_mkldnn');
+
+  static final forward = nativeLib
+      .lookupFunction<
+        CTensor Function(CPackedConv2D, CTensor, Pointer<Pointer<Utf8>>),
+        CTensor Function(
+          CPackedConv2D packed,
+          CTensor input,
+          Pointer<Pointer<Utf8>> error,
+        )
+      >('torchffi_conv2d_packed');
+}
+
+typedef CPackedLinear = Pointer<Void>;
+
+abstract class FFIPackedLinear {
+  static final prepack = nativeLib
+      .lookupFunction<
+        CPackedLinear Function(
+          CTensor,
+          CTensor,
+          Int64,
+          Pointer<Pointer<Utf8>>,
+        ),
+        CPackedLinear Function(
+          CTensor weight,
+          CTensor bias,
+          int batchSize,
+          Pointer<Pointer<Utf8>> error,
+        )
+      >('torchffi_linear_prepack');
+
+  static final delete = nativeLib
+      .lookup<NativeFunction<Void Function(CPackedLinear)>>(
+        'torchffi_linear_packed_delete',
+      );
+
+  static void deletePacked(CPackedLinear packed) {
+    delete.asFunction<void Function(CPackedLinear)>()(packed);
+  }
+
+  static final isMkldnn = nativeLib
+      .lookupFunction<
+        Bool Function(CPackedLinear),
+        bool Function(CPackedLinear packed)
+      >('torchffi_linear_packed_is_mkldnn');
+
+  static final forward = nativeLib
+      .lookupFunction<
+        CTensor Function(CPackedLinear, CTensor, Pointer<Pointer<Utf8>>),
+        CTensor Function(
+          CPackedLinear packed,
+          CTensor input,
+          Pointer<Pointer<Utf8>> error,
+        )
+      >('torchffi_linear_packed');
+}
@@ -0,0 +1,37 @@
+import 'dart:ffi';
+
+import 'package:ffi/ffi.dart';
+import 'package:tensor/src/ffi/torch_ffi.dart';
+
+abstract class FFIProfiler {
+  static final nowNs = nativeLib
+      .lookupFunction<Int64 Function(), int Function()>(
+        'torchffi_profiler_now_ns',
+        isLeaf: true,
+      );
+
+  static final trackMemory = nativeLib
+      .lookupFunction<Void Function(Bool), void Function(bool enabled)>(
+        'torchffi_profiler_track_memory',
+        isLeaf: true,
+      );
+
+  /// Blocks until the accelerator is idle, so not a leaf call.
+  static final synchronize = nativeLib
+      .lookupFunction<
+        Void Function(Pointer<Pointer<Utf8>>),
+        void Function(Pointer<Pointer<Utf8>> error)
+      >('torchffi_profiler_synchronize');
+
+  static final enter = nativeLib
+      .lookupFunction<
+        Void Function(Pointer<Int64>),
+        void Function(Pointer<Int64> record)
+      >('torchffi_profiler_enter', isLeaf: true);
+
+  static final exit = nativeLib
+      .lookupFunction<
+        Void Function(Pointer<Int64>),
+        void Function(Pointer<Int64> record)
+      >('torchffi_profiler_exit', isLeaf: true);
+}
@@ -6,6 +6,8 @@ import 'package:tensor/src/ffi/torch_ffi.dart';
 
 typedef CTensor = Pointer<Void>;
 
+typedef CBlobRelease = Void Function(Pointer<Void> data, Pointer<Void> context);
+
 enum FFIIndexType {
   newDimType,
   ellipsisType,
@@ -177,12 +179,74 @@ abstract class FFITensor {
         )
       >('torchffi_tensor_new_from_blob');
 
+  static final fromBlobOwned = nativeLib
+      .lookupFunction<
+        CTensor Function(
+          Pointer<Void>,
+          Pointer<Int64>,
+          Size dims,
+          CTensorOptions,
+          Pointer<NativeFunction<CBlobRelease>>,
+          Pointer<Void>,
+          Pointer<Pointer<Utf8>>,
+        ),
+        CTensor Function(
+          Pointer<Void>,
+          Pointer<Int64>,
+          int dims,
+          CTensorOptions,
+          Pointer<NativeFunction<CBlobRelease>> release,
+          Pointer<Void> context,
+          Pointer<Pointer<Utf8>> error,
+        )
+      >('torchffi_tensor_new_from_blob_owned');
+
+  static final blobReleaseFree = nativeLib
+      .lookup<NativeFunction<CBlobRelease>>('torchffi_blob_release_free');
+
+  static final blobReleaseMunmap = nativeLib
+      .lookup<NativeFunction<CBlobRelease>>('torchffi_blob_release_munmap');
+
   static final dataPointer = nativeLib
       .lookupFunction<
         Pointer<Void> Function(CTensor),
         Pointer<Void> Function(CTensor tensor)
       >('torchffi_tensor_data_pointer');
 
+  static final impl = nativeLib
+      .lookupFunction<
+        Pointer<Void> Function(CTensor),
+        Pointer<Void> Function(CTensor tensor)
+      >('torchffi_tensor_impl');
+
+  static final share = nativeLib
+      .lookupFunction<CTensor Function(CTensor), CTensor Function(CTensor)>(
+        'torchffi_tensor_share',
+      );
+
+  static final version = nativeLib
+      .lookupFunction<Int64 Function(CTensor), int Function(CTensor)>(
+        'torchffi_tensor_version',
+      );
+
+  static final assign = nativeLib
+      .lookupFunction<
+        Void Function(CTensor, CTensor),
+        void Function(CTensor dst, CTensor src)
+      >('torchffi_tensor_assign');
+
+  static final contentHash = nativeLib
+      .lookupFunction<
+        Uint64 Function(CTensor, Pointer<Pointer<Utf8>>),
+        int Function(CTensor tensor, Pointer<Pointer<Utf8>> error)
+      >('torchffi_tensor_content_hash');
+
+  static final bytesEqual = nativeLib
+      .lookupFunction<
+        Bool Function(CTensor, CTensor, Pointer<Pointer<Utf8>>),
+        bool Function(CTensor a, CTensor b, Pointer<Pointer<Utf8>> error)
+      >('torchffi_tensor_bytes_equal');
+
   static final ones_ = nativeLib
       .lookupFunction<Void Function(CTensor), void Function(CTensor)>(
         'torchffi_tensor_ones_',
@@ -251,6 +315,48 @@ abstract class FFITensor {
         CScalar Function(CTensor, Pointer<Int64>, int, Pointer<Pointer<Utf8>>)
       >('torchffi_tensor_scalar_at');
 
+  static final readInto = nativeLib
+      .lookupFunction<
+        Void Function(CTensor, Pointer<Void>, Int8, Pointer<Pointer<Utf8>>),
+        void Function(
+          CTensor tensor,
+          Pointer<Void> out,
+          int dataType,
+          Pointer<Pointer<Utf8>> error,
+        )
+      >('torchffi_tensor_read_into');
+
+  static final writeFrom = nativeLib
+      .lookupFunction<
+        Void Function(CTensor, Pointer<Void>, Int8, Pointer<Pointer<Utf8>>),
+        void Function(
+          CTensor tensor,
+          Pointer<Void> data,
+          int dataType,
+          Pointer<Pointer<Utf8>> error,
+        )
+      >('torchffi_tensor_write_from');
+
+  static final gatherInto = nativeLib
+      .lookupFunction<
+        Void Function(
+          CTensor,
+          Pointer<Int64>,
+          Int64,
+          Pointer<Void>,
+          Int8,
+          Pointer<Pointer<Utf8>>,
+        ),
+        void Function(
+          CTensor tensor,
+          Pointer<Int64> indices,
+          int count,
+          Pointer<Void> out,
+          int dataType,
+          Pointer<Pointer<Utf8>> error,
+        )
+      >('torchffi_tensor_gather_into');
+
   static final get = nativeLib
       .lookupFunction<
         CTensor Function(CTensor, Int64),
@@ -738,6 +844,70 @@ abstract class FFITensor {
       >('torchffi_tensor_masked_fill');
 }
 
+typedef CSharedTensor = Pointer<Void>;
+
+abstract class FFISharedTensor {
+  static final share = nativeLib
+      .lookupFunction<
+        CSharedTensor Function(CTensor, Int64, Pointer<Pointer<Utf8>>),
+        CSharedTensor Function(
+          CTensor tensor,
+          int importers,
+          Pointer<Pointer<Utf8>> error,
+        )
+      >('torchffi_tensor_share');
+
+  static final import = nativeLib
+      .lookupFunction<
+        CTensor Function(CSharedTensor),
+        CTensor Function(CSharedTensor token)
+      >('torchffi_shared_tensor_import');
+
+  static final release = nativeLib
+      .lookupFunction<
+        Void Function(CSharedTensor, Int64),
+        void Function(CSharedTensor token, int count)
+      >('torchffi_shared_tensor_release');
+
+  static final remaining = nativeLib
+      .lookupFunction<
+        Int64 Function(CSharedTensor),
+        int Function(CSharedTensor token)
+      >('torchffi_shared_tensor_remaining', isLeaf: true);
+}
+
+abstract class FFISharedMemory {
+  static final create = nativeLib
+      .lookupFunction<
+        CTensor Function(
+          Pointer<Utf8>,
+          Pointer<Int64>,
+          Size,
+          Int8,
+          Pointer<Pointer<Utf8>>,
+        ),
+        CTensor Function(
+          Pointer<Utf8> name,
+          Pointer<Int64> dims,
+          int ndims,
+          int dtype,
+          Pointer<Pointer<Utf8>> error,
+        )
+      >('torchffi_shm_tensor_new');
+
+  static final open = nativeLib
+      .lookupFunction<
+        CTensor Function(Pointer<Utf8>, Pointer<Pointer<Utf8>>),
+        CTensor Function(Pointer<Utf8> name, Pointer<Pointer<Utf8>> error)
+      >('torchffi_shm_tensor_open');
+
+  static final refs = nativeLib
+      .lookupFunction<Int64 Function(CTensor), int Function(CTensor tensor)>(
+        'torchffi_shm_tensor_refs',
+        isLeaf: true,
+      );
+}
+
 abstract class FFINN {
   static final linear = nativeLib
       .lookupFunction<
@@ -745,6 +915,84 @@ abstract class FFINN {
         CTensor Function(CTensor input, CTensor weight, CTensor bias)
       >('torchffi_linear');
 
+  static final linearActivation = nativeLib
+      .lookupFunction<
+        CTensor Function(
+          CTensor,
+          CTensor,
+          CTensor,
+          Uint8,
+          Pointer<Pointer<Utf8>>,
+        ),
+        CTensor Function(
+          CTensor input,
+          CTensor weight,
+          CTensor bias,
+          int activation,
+          Pointer<Pointer<Utf8>> error,
+        )
+      >('torchffi_linear_activation');
+
+  static final linearGated = nativeLib
+      .lookupFunction<
+        CTensor Function(
+          CTensor,
+          CTensor,
+          CTensor,
+          Uint8,
+          Pointer<Pointer<Utf8>>,
+        ),
+        CTensor Function(
+          CTensor input,
+          CTensor weight,
+          CTensor bias,
+          int activation,
+          Pointer<Pointer<Utf8>> error,
+        )
+      >('torchffi_linear_gated');
+
+  static final loraAdd_ = nativeLib
+      .lookupFunction<
+        Void Function(
+          CTensor,
+          CTensor,
+          CTensor,
+          CTensor,
+          Double,
+          Pointer<Pointer<Utf8>>,
+        ),
+        void Function(
+          CTensor output,
+          CTensor input,
+          CTensor down,
+          CTensor up,
+          double scale,
+          Pointer<Pointer<Utf8>> error,
+        )
+      >('torchffi_lora_add_');
+
+  static final loraAddBatched_ = nativeLib
+      .lookupFunction<
+        Void Function(
+          CTensor,
+          CTensor,
+          CTensor,
+          CTensor,
+          CTensor,
+          CTensor,
+          Pointer<Pointer<Utf8>>,
+        ),
+        void Function(
+          CTensor output,
+          CTensor input,
+          CTensor down,
+          CTensor up,
+          CTensor scales,
+          CTensor indices,
+          Pointer<Pointer<Utf8>> error,
+        )
+      >('torchffi_lora_add_batched_');
+
   static final layerNorm = nativeLib
       .lookupFunction<
         CTensor Function(
@@ -773,6 +1021,46 @@ abstract class FFINN {
         CTensor Function(CTensor, int, CTensor, CTensor, double)
       >('torchffi_group_norm');
 
+  static final groupNormStats = nativeLib
+      .lookupFunction<
+        Void Function(
+          CTensor,
+          Int64,
+          Pointer<CTensor>,
+          Pointer<CTensor>,
+          Pointer<Pointer<Utf8>>,
+        ),
+        void Function(
+          CTensor input,
+          int numGroups,
+          Pointer<CTensor> sums,
+          Pointer<CTensor> sumSquares,
+          Pointer<Pointer<Utf8>> error,
+        )
+      >('torchffi_group_norm_stats');
+
+  static final groupNormApply = nativeLib
+      .lookupFunction<
+        CTensor Function(
+          CTensor,
+          Int64,
+          CTensor,
+          CTensor,
+          CTensor,
+          CTensor,
+          Pointer<Pointer<Utf8>>,
+        ),
+        CTensor Function(
+          CTensor input,
+          int numGroups,
+          CTensor mean,
+          CTensor rstd,
+          CTensor weight,
+          CTensor bias,
+          Pointer<Pointer<Utf8>> error,
+        )
+      >('torchffi_group_norm_apply');
+
   static final rmsNorm = nativeLib
       .lookupFunction<
         CTensor Function(
@@ -791,6 +1079,30 @@ abstract class FFINN {
         )
       >('torchffi_rms_norm');
 
+  static final addNorm_ = nativeLib
+      .lookupFunction<
+        CTensor Function(
+          CTensor,
+          CTensor,
+          Int64,
+          CTensor,
+          CTensor,
+          Pointer<Double>,
+          Uint8,
+          Pointer<Pointer<Utf8>>,
+        ),
+        CTensor Function(
+          CTensor input,
+          CTensor residual,
+          int normalizedSize,
+          CTensor weight,
+          CTensor bias,
+          Pointer<Double> eps,
+          int normType,
+          Pointer<Pointer<Utf8>> error,
+        )
+      >('torchffi_add_norm_');
+
   static final dropout = nativeLib
       .lookupFunction<
         CTensor Function(CTensor, Double, Bool),
@@ -850,6 +1162,23 @@ abstract class FFINN2D {
         )
       >('torchffi_conv2d');
 
+  static final upsample2xConv2dPhaseWeights = nativeLib
+      .lookupFunction<
+        CTensor Function(CTensor, Pointer<Pointer<Utf8>>),
+        CTensor Function(CTensor weight, Pointer<Pointer<Utf8>> error)
+      >('torchffi_upsample2x_conv2d_phase_weights');
+
+  static final upsample2xConv2d = nativeLib
+      .lookupFunction<
+        CTensor Function(CTensor, CTensor, CTensor, Pointer<Pointer<Utf8>>),
+        CTensor Function(
+          CTensor input,
+          CTensor phaseWeights,
+          CTensor bias,
+          Pointer<Pointer<Utf8>> error,
+        )
+      >('torchffi_upsample2x_conv2d');
+
   static final conv2dTranspose = nativeLib
       .lookupFunction<
         CTensor Function(
@@ -7,7 +7,15 @@ import 'package:universal_io/io.dart';
 import 'device.dart';
 
 export 'device.dart';
+export 'diffusion_ffi.dart';
+export 'executor_ffi.dart';
+export 'flat_parameters_ffi.dart';
 export 'generator_ffi.dart';
+export 'graph_ffi.dart';
+export 'image_ffi.dart';
+export 'llm_ffi.dart';
+export 'packed_ffi.dart';
+export 'profiler_ffi.dart';
 export 'tensor_ffi.dart';
 
 String getLibraryPath() {
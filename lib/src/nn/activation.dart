@@ -9,6 +9,10 @@ abstract class Activation {
 
   Tensor forward(Tensor x, {required Context context});
 
+  /// Native epilogue equivalent of this activation, if there is one. Lets
+  /// [LinearLayer.forwardActivated] fuse it into the matrix multiply.
+  FusedActivation? get fused => null;
+
   static const ReLU relu = ReLU();
   static const QuickGeluActivation quickGelu = QuickGeluActivation();
   static const GeluActivation gelu = GeluActivation();
@@ -34,6 +38,9 @@ class ReLU implements Activation {
 
   const ReLU();
 
+  @override
+  FusedActivation? get fused => FusedActivation.relu;
+
   @override
   Tensor forward(Tensor x, {required Context context}) {
     return x.relu();
@@ -46,6 +53,9 @@ class QuickGeluActivation implements Activation {
 
   const QuickGeluActivation();
 
+  @override
+  FusedActivation? get fused => FusedActivation.quickGelu;
+
   @override
   Tensor forward(Tensor x, {required Context context}) {
     return x * (x * 1.702).sigmoid();
@@ -58,6 +68,9 @@ class GeluActivation implements Activation {
 
   const GeluActivation();
 
+  @override
+  FusedActivation? get fused => FusedActivation.gelu;
+
   @override
   Tensor forward(Tensor x, {required Context context}) {
     return x.gelu(GeluApporimate.none);
@@ -76,8 +89,87 @@ class SiLU implements Activation {
 
   const SiLU();
 
+  @override
+  FusedActivation? get fused => FusedActivation.silu;
+
   @override
   Tensor forward(Tensor x, {required Context context}) {
     return x.silu();
   }
 }
+
+/// Gated GeLU feed-forward projection.
+///
+/// [proj] maps to twice the output width; the first half is multiplied by
+/// the GeLU of the second half. See [LinearLayer.forwardGated] for when the
+/// gate is fused into the projection.
+///
+/// References:
+///   https://arxiv.org/abs/2002.05202
+class GEGLU extends Module implements SimpleModule {
+  final LinearLayer proj;
+  final Activation activation;
+
+  GEGLU({
+    super.name = 'geglu',
+    required this.proj,
+    this.activation = Activation.gelu,
+  });
+
+  int get inFeatures => proj.inFeatures;
+
+  int get outFeatures => proj.outFeatures ~/ 2;
+
+  @override
+  Tensor forward(Tensor x, {required Context context}) {
+    return context.runForward(this, () {
+      return proj.forwardGated(x, activation, context: context);
+    });
+  }
+
+  @override
+  void resetParameters() {
+    proj.resetParameters();
+  }
+
+  @override
+  Map<String, dynamic> get meta => {
+    "inFeatures": inFeatures,
+    "outFeatures": outFeatures,
+    "activation": activation.name,
+  };
+
+  @override
+  final Iterable<Tensor> parameters = const [];
+
+  @override
+  late final Iterable<Module> submodules = [proj];
+
+  static Future<GEGLU> loadFromSafeTensor(
+    SafeTensorLoader loader, {
+    String prefix = '',
+    String name = 'geglu',
+  }) async {
+    final proj = await LinearLayer.loadFromSafeTensor(
+      loader,
+      prefix: '${prefix}proj.',
+      name: 'proj',
+    );
+    return GEGLU(name: name, proj: proj);
+  }
+
+  static GEGLU make({
+    String name = 'geglu',
+    required int inFeatures,
+    required int outFeatures,
+    bool hasBias = true,
+  }) {
+    final proj = LinearLayer.make(
+      name: 'proj',
+      inFeatures: inFeatures,
+      outFeatures: outFeatures * 2,
+      hasBias: hasBias,
+    );
+    return GEGLU(name: name, proj: proj);
+  }
+}
@@ -100,34 +100,125 @@ class Conv2D extends Module implements SimpleModule, Conv2DInterface {
     );
   }
 
-  @override
-  Tensor forward(Tensor input, {required Context context}) {
-    context.onloadModule(this);
-    if (customPad == null) {
-      return NN2DUtil.conv2d(
-        input,
-        weight,
-        bias: bias,
-        stride: stride,
-        padding: padding!,
-        dilation: dilation,
-        groups: groups,
+  /// Whether inference on CPU uses a weight prepacked for oneDNN. The
+  /// packing is redone when the input shape changes or the weight or bias
+  /// are replaced or modified in place.
+  ///
+  /// Off by default until benchmark/conv2d_prepacked.dart shows it ahead on
+  /// the target machine.
+  bool usePrepacked = false;
+
+  PackedConv2D? _packed;
+
+  LoRAAdapter? _lora;
+
+  /// Low-rank adapter added to the output. Swapping adapters only replaces
+  /// this reference; [weight] is never modified. Grouped convolutions have
+  /// no adapter layout and reject one.
+  LoRAAdapter? get lora => _lora;
+
+  set lora(LoRAAdapter? adapter) {
+    if (adapter != null && groups != 1) {
+      throw ArgumentError.value(
+        adapter,
+        'lora',
+        'Grouped convolutions do not support adapters',
       );
     }
+    _lora = adapter;
+  }
 
-    input = input.pad(customPad!.padding.to4List(), mode: customPad!.padMode);
-    return NN2DUtil.conv2d(
-      input,
+  @override
+  Tensor forward(Tensor input, {required Context context}) {
+    return context.runForward(this, () {
+      context.onloadModule(this);
+      final SymmetricPadding2D convPadding;
+      if (customPad != null) {
+        input = input.pad(
+          customPad!.padding.to4List(),
+          mode: customPad!.padMode,
+        );
+        convPadding = const SymmetricPadding2D.same(0);
+      } else {
+        convPadding = padding!;
+      }
+      input = context.toPreferredFormat(input);
+
+      Tensor output;
+      if (usePrepacked &&
+          !context.isTraining &&
+          context.device == Device.cpu &&
+          !hasImportedParameters) {
+        output = _prepacked(input, convPadding).forward(input);
+      } else {
+        output = NN2DUtil.conv2d(
+          input,
+          weight,
+          bias: bias,
+          stride: stride,
+          padding: convPadding,
+          dilation: dilation,
+          groups: groups,
+        );
+      }
+      final adapter = _lora;
+      if (adapter != null) {
+        final hidden = NN2DUtil.conv2d(
+          input,
+          adapter.down,
+          stride: stride,
+          padding: convPadding,
+          dilation: dilation,
+        );
+        output = output + NN2DUtil.conv2d(hidden, adapter.up) * adapter.scale;
+      }
+      return context.checkLayout('conv2d', output);
+    });
+  }
+
+  PackedConv2D _prepacked(Tensor input, SymmetricPadding2D convPadding) {
+    final packed = _packed;
+    if (packed != null && packed.matches(input, weight, bias)) return packed;
+    invalidatePacked();
+    return _packed = PackedConv2D.pack(
       weight,
       bias: bias,
+      inputShape: input.shape,
       stride: stride,
+      padding: convPadding,
       dilation: dilation,
       groups: groups,
     );
   }
 
+  /// Drops the prepacked weight. Must be called after modifying [weight] or
+  /// [bias] in place.
+  void invalidatePacked() {
+    _packed?.release();
+    _packed = null;
+  }
+
+  @override
+  void invalidateCaches() => invalidatePacked();
+
+  @override
+  void to_(Device device, {bool cascade = false}) {
+    super.to_(device, cascade: cascade);
+    _lora?.to_(device);
+    if (_packed != null && _packed!.device != device) invalidatePacked();
+  }
+
+  @override
+  void memoryFormat_(MemoryFormat format) {
+    if (!weight.isContiguous(memoryFormat: format)) {
+      weight.to_(memoryFormat: format);
+      invalidatePacked();
+    }
+  }
+
   @override
   void resetParameters({Generator? generator}) {
+    invalidatePacked();
     Init.kaimingUniform_(weight, a: sqrt(5), generator: generator);
     if (bias != null) {
       final fan = Init.calculateKaimingFan(weight);
@@ -214,19 +305,32 @@ class Conv2D extends Module implements SimpleModule, Conv2DInterface {
     bool padToSame = false,
     Generator? generator,
     DataType? dataType,
+
+    /// With [Device.meta] the parameters are left uninitialized, to be
+    /// filled by [materializeFromSafeTensor_].
     Device? device,
   }) {
-    Tensor weights = Tensor.empty([
-      numOutChannels,
-      numInChannels,
-      kernelSize.vertical,
-      kernelSize.horizontal,
-    ]);
+    Tensor weights = Tensor.empty(
+      [
+        numOutChannels,
+        numInChannels,
+        kernelSize.vertical,
+        kernelSize.horizontal,
+      ],
+      name: 'weight',
+      datatype: dataType,
+      device: device,
+    );
     Tensor? bias;
     if (hasBias) {
-      bias = Tensor.empty([numOutChannels]);
+      bias = Tensor.empty(
+        [numOutChannels],
+        name: 'bias',
+        datatype: dataType,
+        device: device,
+      );
     }
-    return Conv2D._(
+    final conv = Conv2D._(
       weights,
       name: name,
       bias: bias,
@@ -235,7 +339,9 @@ class Conv2D extends Module implements SimpleModule, Conv2DInterface {
       padding: padding,
       dilation: dilation,
       padMode: padMode,
-    )..resetParameters(generator: generator);
+    );
+    if (device != Device.meta) conv.resetParameters(generator: generator);
+    return conv;
   }
 }
 
@@ -283,21 +389,31 @@ class ConvTranspose2D extends Module implements Conv2DInterface {
     required Context context,
     List<int>? outputSize,
   }) {
-    context.onloadModule(this);
-    SymmetricPadding2D outputPadding = _outputPadding(
-      input,
-      outputSize: outputSize,
-    );
-    return NN2DUtil.conv2dTranspose(
-      input,
-      weight,
-      bias: bias,
-      stride: stride,
-      padding: padding,
-      outputPadding: outputPadding,
-      dilation: dilation,
-      groups: groups,
-    );
+    return context.runForward(this, () {
+      context.onloadModule(this);
+      SymmetricPadding2D outputPadding = _outputPadding(
+        input,
+        outputSize: outputSize,
+      );
+      final output = NN2DUtil.conv2dTranspose(
+        context.toPreferredFormat(input),
+        weight,
+        bias: bias,
+        stride: stride,
+        padding: padding,
+        outputPadding: outputPadding,
+        dilation: dilation,
+        groups: groups,
+      );
+      return context.checkLayout('conv_transpose2d', output);
+    });
+  }
+
+  @override
+  void memoryFormat_(MemoryFormat format) {
+    if (!weight.isContiguous(memoryFormat: format)) {
+      weight.to_(memoryFormat: format);
+    }
   }
 
   SymmetricPadding2D _outputPadding(Tensor input, {List<int>? outputSize}) {
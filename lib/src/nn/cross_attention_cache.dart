@@ -0,0 +1,170 @@
+import 'package:tensor/tensor.dart';
+
+/// Caches the key/value projections of a constant conditioning tensor, such
+/// as text encoder output, across the steps of a diffusion run.
+///
+/// Entries are keyed by the cross-attention module and are reused as long as
+/// the conditioning and the projection weights, biases and adapters are the
+/// same tensors (see [Tensor.implPointer]) and have not been modified in
+/// place since (see [Tensor.version]), and the same adapters apply with the
+/// same scales. Anything else recomputes and replaces the entry.
+///
+/// An entry keeps the tensors it was computed from alive, so that their
+/// addresses are not reused, until it is replaced or the cache cleared.
+///
+/// Set on [Context.crossAttentionCache] for the duration of a run and
+/// [clear] it afterwards.
+class CrossAttentionKVCache {
+  final Map<Object, _CrossAttentionEntry> _entries = Map.identity();
+
+  int _hits = 0;
+
+  int _misses = 0;
+
+  int get hits => _hits;
+
+  int get misses => _misses;
+
+  int get length => _entries.length;
+
+  /// Returns the key and value projections of [conditioning] for [owner],
+  /// calling [project] only if they are not cached or are stale. The
+  /// projections are also stale once any of [dependencies] is replaced or
+  /// modified, or [tags] change.
+  (Tensor key, Tensor value) keyValue(
+    Object owner,
+    Tensor conditioning,
+    (Tensor key, Tensor value) Function() project, {
+    List<Tensor> dependencies = const [],
+    List<Object?> tags = const [],
+  }) {
+    final tensors = [conditioning, ...dependencies];
+    final entry = _entries[owner];
+    if (entry != null && entry.matches(tensors, tags)) {
+      _hits++;
+      return (entry.key, entry.value);
+    }
+    _misses++;
+    entry?.release();
+    final (key, value) = project();
+    _entries[owner] = _CrossAttentionEntry(tensors, tags, key, value);
+    return (key, value);
+  }
+
+  /// Projects [conditioning] with [toKey] and [toValue] for the
+  /// cross-attention module [owner], through [Context.crossAttentionCache]
+  /// when it is set.
+  static (Tensor key, Tensor value) project(
+    Object owner,
+    Tensor conditioning, {
+    required LinearLayer toKey,
+    required LinearLayer toValue,
+    required Context context,
+  }) {
+    (Tensor, Tensor) compute() => (
+      toKey.forward(conditioning, context: context),
+      toValue.forward(conditioning, context: context),
+    );
+    final cache = context.crossAttentionCache;
+    if (cache == null) return compute();
+    final dependencies = <Tensor>[];
+    final tags = <Object?>[];
+    for (final layer in [toKey, toValue]) {
+      _describe(layer, context, dependencies, tags);
+    }
+    return cache.keyValue(
+      owner,
+      conditioning,
+      compute,
+      dependencies: dependencies,
+      tags: tags,
+    );
+  }
+
+  /// Adds what the output of [layer] depends on besides its input.
+  static void _describe(
+    LinearLayer layer,
+    Context context,
+    List<Tensor> dependencies,
+    List<Object?> tags,
+  ) {
+    dependencies.add(layer.weight);
+    final bias = layer.bias;
+    if (bias != null) dependencies.add(bias);
+
+    final lora = layer.lora;
+    tags
+      ..add(lora)
+      ..add(lora?.scale);
+    if (lora != null) {
+      dependencies
+        ..add(lora.down)
+        ..add(lora.up);
+    }
+
+    final bank = layer.loraBank;
+    final indices = context.loraIndices;
+    if (bank != null && indices != null) {
+      tags.add(bank);
+      dependencies
+        ..add(bank.down)
+        ..add(bank.up)
+        ..add(bank.scales)
+        ..add(indices);
+    } else {
+      tags.add(null);
+    }
+  }
+
+  void remove(Object owner) => _entries.remove(owner)?.release();
+
+  void clear() {
+    for (final entry in _entries.values) {
+      entry.release();
+    }
+    _entries.clear();
+    _hits = 0;
+    _misses = 0;
+  }
+}
+
+class _CrossAttentionEntry {
+  /// Handles to the implementations the projections were computed from.
+  /// They keep them alive so that their addresses are not reused by other
+  /// tensors while the entry exists.
+  final List<Tensor> _tensors;
+
+  final List<int> _versions;
+
+  final List<Object?> _tags;
+
+  final Tensor key;
+
+  final Tensor value;
+
+  _CrossAttentionEntry(List<Tensor> tensors, this._tags, this.key, this.value)
+    : _tensors = [for (final tensor in tensors) tensor.share()],
+      _versions = [for (final tensor in tensors) tensor.version];
+
+  bool matches(List<Tensor> tensors, List<Object?> tags) {
+    if (tensors.length != _tensors.length || tags.length != _tags.length) {
+      return false;
+    }
+    for (int i = 0; i < tensors.length; i++) {
+      if (tensors[i].implPointer != _tensors[i].implPointer ||
+          tensors[i].version != _versions[i]) {
+        return false;
+      }
+    }
+    for (int i = 0; i < tags.length; i++) {
+      if (tags[i] != _tags[i]) return false;
+    }
+    return true;
+  }
+
+  void release() {
+    for (final tensor in _tensors) {
+      tensor.release();
+    }
+  }
+}
@@ -32,17 +32,19 @@ class EmbeddingLayer extends Module implements SimpleModule {
 
   @override
   Tensor forward(Tensor x, {required Context context}) {
-    context.onloadModule(this);
-    // Ensure input is on the same device as the weights
-    final inputs = x.to(device: context.device); // TODO remove if possible
-    return NNUtil.embedding(
-      weights,
-      inputs,
-      paddingIdx: paddingIdx,
-      scaleGradByFreq: scaleGradByFreq,
-      sparse: sparse,
-      norm: norm,
-    );
+    return context.runForward(this, () {
+      context.onloadModule(this);
+      // Ensure input is on the same device as the weights
+      final inputs = x.to(device: context.device); // TODO remove if possible
+      return NNUtil.embedding(
+        weights,
+        inputs,
+        paddingIdx: paddingIdx,
+        scaleGradByFreq: scaleGradByFreq,
+        sparse: sparse,
+        norm: norm,
+      );
+    });
   }
 
   @override
@@ -122,15 +124,19 @@ class Dropout extends Module implements SimpleModule, InplaceModule {
 
   @override
   Tensor forward(Tensor x, {required Context context}) {
-    context.onloadModule(this);
-    if (p == 0.0 || !context.isTraining) return x;
-    return NNUtil.dropout(x, p, training: context.isTraining);
+    return context.runForward(this, () {
+      context.onloadModule(this);
+      if (p == 0.0 || !context.isTraining) return x;
+      return NNUtil.dropout(x, p, training: context.isTraining);
+    });
   }
 
   @override
   void forward_(Tensor x, {required Context context}) {
-    if (p == 0.0 || !context.isTraining) return;
-    NNUtil.dropout_(x, p, training: context.isTraining);
+    context.runForward<void>(this, () {
+      if (p == 0.0 || !context.isTraining) return;
+      NNUtil.dropout_(x, p, training: context.isTraining);
+    });
   }
 
   @override
@@ -0,0 +1,99 @@
+import 'dart:ffi' as ffi;
+
+import 'package:ffi/ffi.dart' as ffi;
+import 'package:tensor/tensor.dart';
+import 'package:tensor/src/ffi/torch_ffi.dart';
+
+/// Parameters coalesced into one contiguous buffer, each parameter being a
+/// view into [flat] with its original sizes and strides.
+///
+/// Moving the group is a single allocation and copy instead of one per
+/// parameter, and ops on [flat] act on all the parameters at once.
+///
+/// Like views, the parameters share the [Tensor.version] counter of [flat],
+/// so a write through [flat] or any parameter bumps the version of all of
+/// them and caches keyed on it, e.g. [CrossAttentionKVCache], are
+/// rebuilt.
+class FlatParameters {
+  /// The flat buffer. Includes alignment padding between parameters.
+  final Tensor flat;
+
+  final List<Tensor> parameters;
+
+  FlatParameters._(this.flat, this.parameters);
+
+  Device get device => flat.device;
+
+  DataType get dataType => flat.dataType;
+
+  /// Flattens [parameters], which must share their dtype and device.
+  static FlatParameters flatten(Iterable<Tensor> parameters) {
+    final list = parameters.toList();
+    final arena = ffi.Arena();
+    try {
+      final pointers = _pointers(list, arena);
+      final errorPtr = arena.allocate<ffi.Pointer<ffi.Utf8>>(
+        ffi.sizeOf<ffi.Pointer<ffi.Utf8>>(),
+      );
+      errorPtr.value = ffi.nullptr;
+      final flat = FFIFlatParameters.flatten(pointers, list.length, errorPtr);
+      _throwIfError(errorPtr);
+      return FlatParameters._(Tensor(flat), list);
+    } finally {
+      arena.releaseAll();
+    }
+  }
+
+  /// Moves all the parameters to [device] and/or [dataType] at once.
+  void to_({Device? device, DataType? dataType, bool nonBlocking = false}) {
+    final arena = ffi.Arena();
+    try {
+      final options = CTensorOptions.make(
+        dataType: dataType,
+        device: device,
+        layout: null,
+        memoryFormat: null,
+        requiresGrad: null,
+        pinnedMemory: null,
+        allocator: arena,
+      );
+      final pointers = _pointers(parameters, arena);
+      final errorPtr = arena.allocate<ffi.Pointer<ffi.Utf8>>(
+        ffi.sizeOf<ffi.Pointer<ffi.Utf8>>(),
+      );
+      errorPtr.value = ffi.nullptr;
+      FFIFlatParameters.to(
+        flat.nativePtr,
+        pointers,
+        parameters.length,
+        options.ref,
+        nonBlocking,
+        errorPtr,
+      );
+      _throwIfError(errorPtr);
+    } finally {
+      arena.releaseAll();
+    }
+  }
+
+  static ffi.Pointer<CTensor> _pointers(
+    List<Tensor> parameters,
+    ffi.Allocator allocator,
+  ) {
+    final pointers = allocator.allocate<CTensor>(
+      parameters.length * ffi.sizeOf<CTensor>(),
+    );
+    for (int i = 0; i < parameters.length; i++) {
+      pointers[i] = parameters[i].nativePtr;
+    }
+    return pointers;
+  }
+
+  static void _throwIfError(ffi.Pointer<ffi.Pointer<ffi.Utf8>> errorPtr) {
+    if (errorPtr.value != ffi.nullptr) {
+      final error = errorPtr.value.toDartString();
+      ffi.malloc.free(errorPtr.value);
+      throw Exception(error);
+    }
+  }
+}
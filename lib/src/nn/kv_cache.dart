@@ -0,0 +1,142 @@
+import 'dart:ffi' as ffi;
+
+import 'package:ffi/ffi.dart' as ffi;
+import 'package:tensor/tensor.dart';
+import 'package:tensor/src/ffi/torch_ffi.dart';
+
+/// Key/value cache for autoregressive decoding.
+///
+/// Storage is preallocated per layer and new entries are written in place
+/// along [seqDim]. [truncate] only moves the valid length back, so rolling
+/// back rejected speculative tokens is O(1) and does not touch the tensors.
+class KVCache implements ffi.Finalizable {
+  final ffi.Pointer<ffi.Void> nativePtr;
+
+  final int numLayers;
+
+  final int seqDim;
+
+  KVCache._(this.nativePtr, {required this.numLayers, required this.seqDim}) {
+    _finalizer.attach(this, nativePtr, detach: this);
+  }
+
+  static final _finalizer = ffi.NativeFinalizer(FFIKVCache.delete);
+
+  void release() {
+    _finalizer.detach(this);
+    FFIKVCache.deleteCache(nativePtr);
+  }
+
+  /// Number of valid entries stored for [layer].
+  int lengthOf(int layer) => _layerCall(FFIKVCache.length, layer);
+
+  /// Number of valid entries stored for the first layer.
+  int get length => lengthOf(0);
+
+  int capacityOf(int layer) => _layerCall(FFIKVCache.capacity, layer);
+
+  int _layerCall(
+    int Function(
+      ffi.Pointer<ffi.Void> cache,
+      int layer,
+      ffi.Pointer<ffi.Pointer<ffi.Utf8>> error,
+    )
+    function,
+    int layer,
+  ) {
+    final arena = ffi.Arena();
+    try {
+      final errorPtr = arena.allocate<ffi.Pointer<ffi.Utf8>>(
+        ffi.sizeOf<ffi.Pointer<ffi.Utf8>>(),
+      );
+      errorPtr.value = ffi.nullptr;
+      final result = function(nativePtr, layer, errorPtr);
+      if (errorPtr.value != ffi.nullptr) {
+        final error = errorPtr.value.toDartString();
+        ffi.malloc.free(errorPtr.value);
+        throw Exception(error);
+      }
+      return result;
+    } finally {
+      arena.releaseAll();
+    }
+  }
+
+  /// Appends [key] and [value] to [layer] and returns views over all the
+  /// valid keys and values of that layer. They must have the shape of the
+  /// storage in every dimension but [seqDim].
+  (Tensor keys, Tensor values) update(int layer, Tensor key, Tensor value) {
+    final arena = ffi.Arena();
+    try {
+      final keysOut = arena.allocate<CTensor>(ffi.sizeOf<CTensor>());
+      final valuesOut = arena.allocate<CTensor>(ffi.sizeOf<CTensor>());
+      final errorPtr = arena.allocate<ffi.Pointer<ffi.Utf8>>(
+        ffi.sizeOf<ffi.Pointer<ffi.Utf8>>(),
+      );
+      errorPtr.value = ffi.nullptr;
+      FFIKVCache.update(
+        nativePtr,
+        layer,
+        key.nativePtr,
+        value.nativePtr,
+        keysOut,
+        valuesOut,
+        errorPtr,
+      );
+      if (errorPtr.value != ffi.nullptr) {
+        final error = errorPtr.value.toDartString();
+        ffi.malloc.free(errorPtr.value);
+        throw Exception(error);
+      }
+      return (Tensor(keysOut.value), Tensor(valuesOut.value));
+    } finally {
+      arena.releaseAll();
+    }
+  }
+
+  /// Rolls every layer back to at most [length] entries.
+  void truncate(int length) {
+    FFIKVCache.truncate(nativePtr, length);
+  }
+
+  /// [shape] is the shape of the preallocated storage of a single layer. Its
+  /// size along [seqDim] is the initial capacity; the cache grows on demand.
+  static KVCache make({
+    required int numLayers,
+    required List<int> shape,
+    int seqDim = -2,
+    DataType? dataType,
+    Device? device,
+  }) {
+    final arena = ffi.Arena();
+    try {
+      final options = CTensorOptions.make(
+        dataType: dataType,
+        device: device,
+        layout: null,
+        memoryFormat: null,
+        requiresGrad: null,
+        pinnedMemory: null,
+        allocator: arena,
+      );
+      final sizesPointer = arena.allocate<ffi.Int64>(
+        ffi.sizeOf<ffi.Int64>() * shape.length,
+      );
+      sizesPointer.asTypedList(shape.length).setAll(0, shape);
+      final cache = FFIKVCache.constructor(
+        numLayers,
+        sizesPointer,
+        shape.length,
+        seqDim,
+        options.ref,
+      );
+      return KVCache._(
+        cache,
+        numLayers: numLayers,
+        seqDim: seqDim < 0 ? seqDim + shape.length : seqDim,
+      );
+    } finally {
+      arena.releaseAll();
+    }
+  }
+}
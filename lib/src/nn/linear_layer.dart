@@ -12,16 +12,158 @@ class LinearLayer extends Module implements SimpleModule {
 
   int get outFeatures => weight.shape[0];
 
+  /// Whether inference on CPU uses a weight prepacked for oneDNN, sized for
+  /// the row count of the first input. The packing is rebuilt when the
+  /// weight or bias is replaced or modified in place, and dropped when the
+  /// weight moves to another device or data type.
+  ///
+  /// Off by default: benchmark/linear_decode_prepacked.dart has not yet
+  /// shown it ahead of the plain linear, in float32 and bfloat16, on the
+  /// target machines.
+  bool usePrepacked = false;
+
+  PackedLinear? _packed;
+
+  /// Low-rank adapter added to the output of every row. Swapping adapters
+  /// only replaces this reference; [weight] is never modified.
+  LoRAAdapter? lora;
+
+  /// Per-row adapters selected by [Context.loraIndices]. Takes precedence
+  /// over [lora] when the context has indices.
+  LoRAAdapterBank? loraBank;
+
+  bool _hasLora(Context context) =>
+      lora != null || (loraBank != null && context.loraIndices != null);
+
   @override
   Tensor forward(Tensor x, {required Context context}) {
-    context.onloadModule(this);
-    // Ensure input is on the same device as the weights
-    final inputs = x.to(device: context.device); // TODO remove if possible
-    return NNUtil.linear(inputs, weight, bias: bias);
+    return context.runForward(this, () {
+      context.onloadModule(this);
+      // Ensure input is on the same device as the weights
+      final inputs = x.to(device: context.device); // TODO remove if possible
+      final Tensor output;
+      if (usePrepacked &&
+          !context.isTraining &&
+          context.device == Device.cpu &&
+          !hasImportedParameters) {
+        output = _prepacked(inputs).forward(inputs);
+      } else {
+        output = NNUtil.linear(inputs, weight, bias: bias);
+      }
+      if (_hasLora(context)) _addLora(output, inputs, context);
+      return output;
+    });
+  }
+
+  void _addLora(Tensor output, Tensor inputs, Context context) {
+    final bank = loraBank;
+    final indices = context.loraIndices;
+    if (bank != null && indices != null) {
+      NNUtil.loraAddBatched_(
+        output,
+        inputs,
+        bank.down,
+        bank.up,
+        scales: bank.scales,
+        indices: indices,
+      );
+      return;
+    }
+    final adapter = lora!;
+    NNUtil.loraAdd_(
+      output,
+      inputs,
+      adapter.down,
+      adapter.up,
+      scale: adapter.scale,
+    );
+  }
+
+  PackedLinear _prepacked(Tensor inputs) {
+    final packed = _packed;
+    if (packed != null && packed.matches(weight, bias)) return packed;
+    invalidatePacked();
+    return _packed = PackedLinear.pack(
+      weight,
+      bias: bias,
+      batchSize: inputs.numel ~/ inFeatures,
+    );
+  }
+
+  /// Drops the prepacked weight.
+  void invalidatePacked() {
+    _packed?.release();
+    _packed = null;
+  }
+
+  @override
+  void invalidateCaches() => invalidatePacked();
+
+  @override
+  void to_(Device device, {bool cascade = false}) {
+    super.to_(device, cascade: cascade);
+    lora?.to_(device);
+    loraBank?.to_(device);
+    if (_packed != null && _packed!.device != device) invalidatePacked();
+  }
+
+  /// Computes `activation(forward(x))`, fusing the activation into the
+  /// matrix multiply when it has a native equivalent.
+  Tensor forwardActivated(
+    Tensor x,
+    Activation activation, {
+    required Context context,
+  }) {
+    final fused = activation.fused;
+    if (fused == null || _hasLora(context)) {
+      return activation.forward(forward(x, context: context), context: context);
+    }
+    return context.runForward(this, () {
+      context.onloadModule(this);
+      final inputs = x.to(device: context.device); // TODO remove if possible
+      return NNUtil.linearActivation(
+        inputs,
+        weight,
+        bias: bias,
+        activation: fused,
+      );
+    });
+  }
+
+  /// Computes `hidden * activation(gate)` where [hidden] and [gate] are the
+  /// two halves of `forward(x)`, as in GEGLU and SwiGLU.
+  ///
+  /// When the activation has a native equivalent and no adapter applies,
+  /// the gate is fused into the matrix multiply so that the double-width
+  /// projection is not materialized on CPU.
+  Tensor forwardGated(
+    Tensor x,
+    Activation activation, {
+    required Context context,
+  }) {
+    final fused = activation.fused;
+    if (fused == null || _hasLora(context)) {
+      final projected = forward(x, context: context);
+      final features = outFeatures ~/ 2;
+      final hidden = projected.slice(-1, 0, end: features);
+      final gate = projected.slice(-1, features);
+      return hidden * activation.forward(gate, context: context);
+    }
+    return context.runForward(this, () {
+      context.onloadModule(this);
+      final inputs = x.to(device: context.device); // TODO remove if possible
+      return NNUtil.linearGated(
+        inputs,
+        weight,
+        bias: bias,
+        activation: fused,
+      );
+    });
   }
 
   @override
   void resetParameters() {
+    invalidatePacked();
     Init.kaimingUniform_(weight, a: sqrt(5));
     if (bias != null) {
       final fan = Init.calculateKaimingFan(weight);
@@ -47,6 +189,7 @@ class LinearLayer extends Module implements SimpleModule {
     SafeTensorLoader loader, {
     String prefix = '',
   }) async {
+    invalidatePacked();
     if (loader.hasTensor('${prefix}weight')) {
       final newWeight = await loader.loadByName('${prefix}weight');
       weight.copy_(newWeight);
@@ -75,10 +218,28 @@ class LinearLayer extends Module implements SimpleModule {
     required int inFeatures,
     required int outFeatures,
     bool hasBias = true,
+    DataType? dataType,
+
+    /// With [Device.meta] the parameters are left uninitialized, to be
+    /// filled by [materializeFromSafeTensor_].
+    Device? device,
   }) {
-    final weight = Tensor.empty([outFeatures, inFeatures]);
-    final bias = hasBias ? Tensor.empty([outFeatures]) : null;
-    return LinearLayer(name: name, weight: weight, bias: bias)
-      ..resetParameters();
+    final weight = Tensor.empty(
+      [outFeatures, inFeatures],
+      name: 'weight',
+      datatype: dataType,
+      device: device,
+    );
+    final bias = hasBias
+        ? Tensor.empty(
+            [outFeatures],
+            name: 'bias',
+            datatype: dataType,
+            device: device,
+          )
+        : null;
+    final linear = LinearLayer(name: name, weight: weight, bias: bias);
+    if (device != Device.meta) linear.resetParameters();
+    return linear;
   }
 }
@@ -0,0 +1,128 @@
+import 'package:tensor/tensor.dart';
+
+/// Low-rank adapter adding `scale * up(down(x))` to the output of a
+/// [LinearLayer] or [Conv2D] without touching its weight.
+///
+/// For a linear layer [down] is `[rank, in]` and [up] is `[out, rank]`. For a
+/// convolution [down] is `[rank, in, kh, kw]`, applied with the layer's
+/// stride, padding and dilation, and [up] is `[out, rank, 1, 1]`.
+class LoRAAdapter {
+  final Tensor down;
+
+  final Tensor up;
+
+  /// Multiplier of the low-rank update, `strength * alpha / rank`.
+  double scale;
+
+  LoRAAdapter({
+    required this.down,
+    required this.up,
+    double? alpha,
+    double strength = 1,
+  }) : scale = strength * (alpha ?? down.shape[0]) / down.shape[0];
+
+  int get rank => down.shape[0];
+
+  Device get device => down.device;
+
+  void to_(Device device) {
+    if (down.device != device) down.to_(device: device);
+    if (up.device != device) up.to_(device: device);
+  }
+
+  /// Loads the adapter of the layer at [prefix], in either the kohya
+  /// (`lora_down`, `lora_up`, `alpha`) or the PEFT (`lora_A`, `lora_B`)
+  /// naming. Returns null if [loader] has no adapter for the layer.
+  static Future<LoRAAdapter?> loadFromSafeTensor(
+    SafeTensorLoader loader, {
+    String prefix = '',
+    double strength = 1,
+    Device device = Device.cpu,
+  }) async {
+    final String downName, upName;
+    if (loader.hasTensor('${prefix}lora_down.weight')) {
+      downName = '${prefix}lora_down.weight';
+      upName = '${prefix}lora_up.weight';
+    } else if (loader.hasTensor('${prefix}lora_A.weight')) {
+      downName = '${prefix}lora_A.weight';
+      upName = '${prefix}lora_B.weight';
+    } else {
+      return null;
+    }
+    final down = await loader.loadByName(downName, device: device);
+    final up = await loader.loadByName(upName, device: device);
+    double? alpha;
+    if (loader.hasTensor('${prefix}alpha')) {
+      alpha = ((await loader.loadByName('${prefix}alpha')).scalar as num)
+          .toDouble();
+    }
+    return LoRAAdapter(
+      down: down.clone(),
+      up: up.clone(),
+      alpha: alpha,
+      strength: strength,
+    );
+  }
+}
+
+/// Linear [LoRAAdapter]s of one layer stacked so that every batch row can
+/// use a different one, selected by [Context.loraIndices].
+///
+/// Adapters of lower rank are zero-padded to the largest rank, which leaves
+/// their update unchanged.
+class LoRAAdapterBank {
+  /// `[adapters, rank, in]`
+  final Tensor down;
+
+  /// `[adapters, out, rank]`
+  final Tensor up;
+
+  /// `[adapters]`
+  final Tensor scales;
+
+  LoRAAdapterBank._(this.down, this.up, this.scales);
+
+  int get length => down.shape[0];
+
+  Device get device => down.device;
+
+  void to_(Device device) {
+    if (down.device != device) down.to_(device: device);
+    if (up.device != device) up.to_(device: device);
+    if (scales.device != device) scales.to_(device: device);
+  }
+
+  static LoRAAdapterBank stack(List<LoRAAdapter> adapters) {
+    if (adapters.isEmpty) {
+      throw ArgumentError.value(adapters, 'adapters', 'must not be empty');
+    }
+    final first = adapters.first;
+    final rank = adapters.map((a) => a.rank).reduce((a, b) => a > b ? a : b);
+    final inFeatures = first.down.shape[1];
+    final outFeatures = first.up.shape[0];
+    final dataType = first.down.dataType;
+    final device = first.device;
+    final down = Tensor.zeros(
+      [adapters.length, rank, inFeatures],
+      datatype: dataType,
+      device: device,
+    );
+    final up = Tensor.zeros(
+      [adapters.length, outFeatures, rank],
+      datatype: dataType,
+      device: device,
+    );
+    for (int i = 0; i < adapters.length; i++) {
+      final adapter = adapters[i];
+      down[i].slice(0, 0, end: adapter.rank).copy_(adapter.down);
+      up[i].slice(1, 0, end: adapter.rank).copy_(adapter.up);
+    }
+    final scales = Tensor.from(
+      [for (final adapter in adapters) adapter.scale],
+      [adapters.length],
+      datatype: DataType.float32,
+      device: device,
+    );
+    return LoRAAdapterBank._(down, up, scales);
+  }
+}
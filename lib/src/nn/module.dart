@@ -1,5 +1,10 @@
+import 'package:collection/collection.dart';
 import 'package:tensor/tensor.dart';
 
+/// Parameters replaced by [ModuleExtension.importStateDict_] with tensors
+/// shared with another isolate.
+final Expando<bool> _imported = Expando('imported');
+
 abstract class Module {
   String name;
 
@@ -7,6 +12,17 @@ abstract class Module {
 
   void resetParameters();
 
+  /// Drops anything derived from the parameters, such as prepacked weights.
+  /// Must be called after parameters are replaced or modified in place.
+  void invalidateCaches() {}
+
+  /// Whether any parameter of this module itself was imported from another
+  /// isolate by [ModuleExtension.importStateDict_]. Such modules do not
+  /// build private copies of their weights, such as prepacked ones, which
+  /// would defeat sharing them.
+  bool get hasImportedParameters =>
+      parameters.any((p) => _imported[p] ?? false);
+
   Map<String, dynamic> get meta;
 
   Iterable<Tensor> get parameters;
@@ -16,7 +32,63 @@ abstract class Module {
 
   Iterable<Module> get submodules;
 
+  /// Groups of parameters of this module and its submodules coalesced by
+  /// [flattenParameters_], one per dtype and device.
+  List<FlatParameters> flatParameters = const [];
+
+  bool _isFlattened = false;
+
+  Module? _flatRoot;
+
+  /// The module that owns the flat buffers holding this module's
+  /// parameters, which is moved and offloaded as one unit with its whole
+  /// subtree. This module itself when it is not flattened.
+  Module get offloadUnit => _flatRoot ?? this;
+
+  /// Coalesces the parameters of this module and all its submodules into
+  /// flat buffers so that [to_] moves each group with a single copy.
+  /// Does nothing if this module is already part of a flattened group.
+  void flattenParameters_() {
+    if (_isFlattened) return;
+    final all = <Tensor>[];
+    final seen = Set<Tensor>.identity();
+    void collect(Module module) {
+      module._isFlattened = true;
+      module._flatRoot = this;
+      // Groups of submodules flattened before are copied into this one.
+      if (module != this) module.flatParameters = const [];
+      // Imported parameters stay shared instead of being copied into a
+      // buffer of this isolate.
+      all.addAll(
+        module.parameters.where((p) => !(_imported[p] ?? false) && seen.add(p)),
+      );
+      for (final submodule in module.submodules) {
+        collect(submodule);
+      }
+    }
+
+    collect(this);
+    final groups = groupBy(all, (Tensor p) => (p.dataType.type, p.device));
+    flatParameters = [
+      for (final group in groups.values) FlatParameters.flatten(group),
+    ];
+  }
+
+  /// Moves the parameters to [device]. Flattened groups are moved as a
+  /// whole, including the parameters of submodules; moving a flattened
+  /// submodule moves its [offloadUnit], since its parameters cannot leave
+  /// the shared buffer on their own.
   void to_(Device device, {bool cascade = false}) {
+    final unit = offloadUnit;
+    if (unit != this) {
+      if (unit.flatParameters.any((group) => group.device != device)) {
+        unit.to_(device);
+      }
+    }
+    for (final group in flatParameters) {
+      if (group.device == device) continue;
+      group.to_(device: device);
+    }
     for (final parameter in parameters) {
       if (parameter.device == device) continue;
       parameter.to_(device: device);
@@ -28,6 +100,70 @@ abstract class Module {
     }
   }
 
+  /// Whether any parameter of this module or its submodules is still on
+  /// [Device.meta].
+  bool get isMeta =>
+      parameters.any((p) => p.isMeta) || submodules.any((m) => m.isMeta);
+
+  /// Loads every parameter of this module and its submodules that is on
+  /// [Device.meta] from [loader] onto [device] and as [dataType], with a
+  /// single copy from the file.
+  ///
+  /// Parameters are looked up by [prefix], the submodule names and the
+  /// parameter name, as in [ModuleExtension.stateDict] without the module's
+  /// own name. Each parameter is assigned in place, so references to it
+  /// stay valid.
+  Future<void> materializeFromSafeTensor_(
+    SafeTensorLoader loader, {
+    String prefix = '',
+    Device device = Device.cpu,
+    DataType? dataType,
+  }) async {
+    for (final parameter in parameters) {
+      if (!parameter.isMeta) continue;
+      if (parameter.name == null) {
+        throw Exception('Parameter of module ${this.name} has no name');
+      }
+      final name = '$prefix${parameter.name}';
+      if (!loader.hasTensor(name)) {
+        throw Exception('Tensor $name of module ${this.name} not found');
+      }
+      // The CPU view of the file is copied once, to the device and data
+      // type together.
+      var loaded = await loader.loadByName(name);
+      if (!const ListEquality<int>().equals(loaded.shape, parameter.shape)) {
+        throw Exception(
+          'Shape mismatch for $name: expected ${parameter.shape}, '
+          'got ${loaded.shape}',
+        );
+      }
+      final target = dataType ?? parameter.dataType;
+      if (device.deviceType == DeviceType.cpu && loaded.dataType == target) {
+        // The CPU loader may return a view of the file mapping.
+        loaded = loaded.clone();
+      } else {
+        loaded = loaded.to(device: device, dataType: target);
+      }
+      parameter.assign_(loaded);
+    }
+    for (final submodule in submodules) {
+      await submodule.materializeFromSafeTensor_(
+        loader,
+        prefix: '$prefix${submodule.name}.',
+        device: device,
+        dataType: dataType,
+      );
+    }
+  }
+
+  /// Converts the parameters that have a spatial layout to [format]. Called
+  /// once per module by [Context] when it has a preferred memory format.
+  void memoryFormat_(MemoryFormat format) {
+    for (final submodule in submodules) {
+      submodule.memoryFormat_(format);
+    }
+  }
+
   @override
   String toString() {
     return '$runtimeType(${meta.entries.map((e) => '${e.key}: ${e.value}').join(', ')})';
@@ -69,6 +205,60 @@ extension ModuleExtension on Module {
     }
     return ret;
   }
+
+  /// Exports every parameter of this module and its submodules, keyed as in
+  /// [stateDict] without the module's own name, for [importers] other
+  /// isolates to load with [importStateDict_].
+  Map<String, TensorToken> shareStateDict({int importers = 1}) =>
+      stateDict(withName: false).map(
+        (name, tensor) => MapEntry(
+          name,
+          TensorToken.export(tensor, importers: importers),
+        ),
+      );
+
+  /// Replaces the parameters of this module and its submodules with the
+  /// tensors exported by [shareStateDict] in another isolate, so that both
+  /// isolates use one copy of the weights. Build the module on
+  /// [Device.meta] to not allocate weights that are replaced anyway.
+  ///
+  /// Imported parameters are left out of [Module.flattenParameters_] and
+  /// modules holding them do not prepack their weights, since both would
+  /// copy them. Caches derived from the old parameters are dropped with
+  /// [Module.invalidateCaches].
+  ///
+  /// Every token takes one import, including those that have no matching
+  /// parameter.
+  void importStateDict_(Map<String, TensorToken> tokens) {
+    final state = stateDict(withName: false);
+    final imported = Map<Tensor, Tensor>.identity();
+    for (final MapEntry(key: name, value: token) in tokens.entries) {
+      final parameter = state[name];
+      if (parameter == null) {
+        token.release();
+        continue;
+      }
+      imported[parameter] = token.import();
+    }
+    for (final MapEntry(key: parameter, value: tensor) in imported.entries) {
+      if (!const ListEquality<int>().equals(tensor.shape, parameter.shape)) {
+        throw Exception(
+          'Shape mismatch for ${parameter.name}: expected '
+          '${parameter.shape}, got ${tensor.shape}',
+        );
+      }
+    }
+    for (final MapEntry(key: parameter, value: tensor) in imported.entries) {
+      parameter.assign_(tensor);
+      _imported[parameter] = true;
+    }
+    void invalidate(Module module) {
+      module.invalidateCaches();
+      module.submodules.forEach(invalidate);
+    }
+
+    invalidate(this);
+  }
 }
 
 abstract class SimpleModule implements Module {
@@ -83,6 +273,15 @@ abstract class InplaceModule implements Module {
   void forward_(Tensor x, {required Context context});
 }
 
+/// Called around the forward of each module run through
+/// [Context.runForward], see [Context.forwardHooks].
+abstract class ForwardHook {
+  void before(Module module);
+
+  /// [output] is null if the forward threw.
+  void after(Module module, Object? output);
+}
+
 class Context {
   bool isTraining;
 
@@ -90,13 +289,102 @@ class Context {
 
   final Offloader offloader = Offloader();
 
-  Context({required this.isTraining, required this.device});
+  /// Memory format that 4D activations and conv weights are kept in, e.g.
+  /// [MemoryFormat.channelsLast]. Null keeps whatever layout tensors have.
+  MemoryFormat? preferredMemoryFormat;
+
+  /// Number of times each op produced an output that is not in
+  /// [preferredMemoryFormat] and had to be converted back.
+  final Map<String, int> layoutFallbacks = {};
+
+  /// Called when an op falls back out of [preferredMemoryFormat].
+  void Function(String op, Tensor output)? onLayoutFallback;
+
+  final Set<Module> _formattedModules = Set.identity();
+
+  /// Set while a [TiledExecutor] runs so that [GroupNorm] uses statistics
+  /// of the whole image instead of those of the current tile.
+  GroupNormTiling? groupNormTiling;
+
+  /// Whether [onloadModule] flattens the parameters of each module it loads
+  /// into per-module flat buffers, see [Module.flattenParameters_].
+  bool flattenParameters;
+
+  /// Reuses cross-attention key/value projections of the conditioning across
+  /// the steps of a diffusion run. Null projects on every call.
+  CrossAttentionKVCache? crossAttentionCache;
+
+  /// Index of the [LoRAAdapterBank] entry used by each batch row, or -1 for
+  /// none. Layers without a bank ignore it.
+  Tensor? loraIndices;
+
+  /// Hooks run around the forward of every module, e.g. a [ModuleProfiler].
+  /// Empty by default, in which case [runForward] only calls the forward.
+  final List<ForwardHook> forwardHooks = [];
 
-  factory Context.best({bool isTraining = false}) {
-    return Context(isTraining: isTraining, device: Device.best());
+  Context({
+    required this.isTraining,
+    required this.device,
+    this.preferredMemoryFormat,
+    this.flattenParameters = false,
+  });
+
+  factory Context.best({
+    bool isTraining = false,
+    MemoryFormat? preferredMemoryFormat,
+  }) {
+    return Context(
+      isTraining: isTraining,
+      device: Device.best(),
+      preferredMemoryFormat: preferredMemoryFormat,
+    );
+  }
+
+  /// Converts 4D [x] to [preferredMemoryFormat] if it is not already in it.
+  Tensor toPreferredFormat(Tensor x) {
+    final format = preferredMemoryFormat;
+    if (format == null || x.dim != 4) return x;
+    if (x.isContiguous(memoryFormat: format)) return x;
+    return x.contiguous(format: format);
+  }
+
+  /// Reports and fixes up [output] of [op] if it fell out of
+  /// [preferredMemoryFormat].
+  Tensor checkLayout(String op, Tensor output) {
+    final format = preferredMemoryFormat;
+    if (format == null || output.dim != 4) return output;
+    if (output.isContiguous(memoryFormat: format)) return output;
+    layoutFallbacks[op] = (layoutFallbacks[op] ?? 0) + 1;
+    onLayoutFallback?.call(op, output);
+    return output.contiguous(format: format);
+  }
+
+  /// Runs [forward] for [module] between the [forwardHooks].
+  T runForward<T>(Module module, T Function() forward) {
+    if (forwardHooks.isEmpty) return forward();
+    for (final hook in forwardHooks) {
+      hook.before(module);
+    }
+    Object? output;
+    try {
+      final result = forward();
+      output = result;
+      return result;
+    } finally {
+      for (final hook in forwardHooks.reversed) {
+        hook.after(module, output);
+      }
+    }
   }
 
   void onloadModule(Module module) {
+    final format = preferredMemoryFormat;
+    if (format != null && _formattedModules.add(module)) {
+      module.memoryFormat_(format);
+    }
+    if (flattenParameters) {
+      module.flattenParameters_();
+    }
     if (device == Device.cpu) {
       // TODO handle low RAM situations
       return;
@@ -112,38 +400,63 @@ class Offloader {
 
   Offloader();
 
+  /// Loads [module] on [device]. A flattened module is loaded and tracked
+  /// as its [Module.offloadUnit], together with its whole subtree.
   void freeAndLoadModule(Module module, Device device) {
-    if (modules.contains(module)) return;
+    final unit = module.offloadUnit;
+    if (modules.contains(unit)) return;
 
-    int requiredMemory = module.parameters.fold(0, (previousValue, element) {
-      if (element.device == device) return previousValue;
-      return previousValue + element.elementSize;
-    });
+    final flattened = unit.flatParameters.isNotEmpty;
+    int requiredMemory;
+    if (flattened) {
+      requiredMemory = unit.flatParameters.fold(0, (previousValue, group) {
+        if (group.device == device) return previousValue;
+        return previousValue + group.flat.memorySize;
+      });
+    } else {
+      requiredMemory = unit.parameters.fold(0, (previousValue, element) {
+        if (element.device == device) return previousValue;
+        return previousValue + element.elementSize;
+      });
+    }
     if (requiredMemory > device.freeMemory) {
       if (!freeMemory(requiredMemory, device)) {
         throw Exception('Not enough memory');
       }
     }
-    module.to_(device);
-    modules.add(module);
+    // Cascades so that submodules move what is not in the flat buffers,
+    // such as adapters, and drop their device-specific caches.
+    unit.to_(device, cascade: flattened);
+    if (flattened) _forgetSubmodules(unit);
+    modules.add(unit);
   }
 
   void offloadModule(Module module) {
-    if (!modules.contains(module)) return;
-    for (final parameter in module.parameters) {
-      final device = parameter.device;
-      if (device == Device.cpu) continue;
-      // TODO pin tensor?
-      parameter.to_(device: Device.cpu);
+    final unit = module.offloadUnit;
+    if (!modules.contains(unit)) return;
+    // TODO pin tensor?
+    unit.to_(Device.cpu, cascade: unit.flatParameters.isNotEmpty);
+    modules.remove(unit);
+    keep.remove(unit);
+  }
+
+  /// Submodules tracked before [unit] was flattened now move with it.
+  void _forgetSubmodules(Module unit) {
+    void forget(Module module) {
+      for (final submodule in module.submodules) {
+        modules.remove(submodule);
+        if (keep.remove(submodule)) keep.add(unit);
+        forget(submodule);
+      }
     }
-    modules.remove(module);
-    keep.remove(module);
+
+    forget(unit);
   }
 
   bool freeMemory(int requiredMemory, Device device) {
     // TODO implement an intelligent algorithm to decide which modules to offload
     // TODO better to offload lowest memory modules first?
-    for (final module in modules) {
+    for (final module in modules.toList()) {
       if (keep.contains(module)) continue;
       offloadModule(module);
       if (device.freeMemory >= requiredMemory) return true;
@@ -152,7 +465,7 @@ class Offloader {
   }
 
   void offloadAll() {
-    for (final module in modules) {
+    for (final module in modules.toList()) {
       offloadModule(module);
     }
     modules.clear();
@@ -1,6 +1,17 @@
 export 'activation.dart';
 export 'embedding_layer.dart';
+export 'flat_parameters.dart';
+export 'kv_cache.dart';
 export 'module.dart';
 export 'normalization.dart';
+export 'prepacked.dart';
+export 'profiler.dart';
 export 'conv2d.dart';
+export 'cross_attention_cache.dart';
 export 'linear_layer.dart';
+export 'lora.dart';
+export 'rotary_embedding.dart';
+export 'speculative_decoding.dart';
+export 'tiled.dart';
+export 'traced.dart';
+export 'upsample.dart';
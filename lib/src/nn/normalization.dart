@@ -5,7 +5,18 @@ abstract class Normalization implements SimpleModule {}
 
 abstract class EmbeddableNormalizer implements EmbeddableModule {}
 
-class LayerNorm extends Module implements Normalization {
+/// Normalization that can fold the residual connection preceding it.
+abstract class ResidualNormalization implements Normalization {
+  /// Adds [residual] to [x] in place and returns the normalized [x] in a
+  /// single pass over the hidden state.
+  Tensor forwardAddResidual_(
+    Tensor x,
+    Tensor residual, {
+    required Context context,
+  });
+}
+
+class LayerNorm extends Module implements ResidualNormalization {
   final Tensor? weight;
   final Tensor? bias;
   final double eps;
@@ -30,15 +41,36 @@ class LayerNorm extends Module implements Normalization {
 
   @override
   Tensor forward(Tensor x, {Tensor? embeds, required Context context}) {
-    context.onloadModule(this);
-    final inputs = x.to(device: context.device); // TODO remove if possible
-    return NNUtil.layerNorm(
-      inputs,
-      normalizedShape,
-      weight: weight,
-      bias: bias,
-      eps: eps,
-    );
+    return context.runForward(this, () {
+      context.onloadModule(this);
+      final inputs = x.to(device: context.device); // TODO remove if possible
+      return NNUtil.layerNorm(
+        inputs,
+        normalizedShape,
+        weight: weight,
+        bias: bias,
+        eps: eps,
+      );
+    });
+  }
+
+  @override
+  Tensor forwardAddResidual_(
+    Tensor x,
+    Tensor residual, {
+    required Context context,
+  }) {
+    return context.runForward(this, () {
+      context.onloadModule(this);
+      return NNUtil.addLayerNorm_(
+        x,
+        residual,
+        normalizedShape,
+        weight: weight,
+        bias: bias,
+        eps: eps,
+      );
+    });
   }
 
   @override
@@ -171,15 +203,21 @@ class GroupNorm extends Module implements Normalization {
 
   @override
   Tensor forward(Tensor x, {required Context context}) {
-    context.onloadModule(this);
-    final inputs = x.to(device: context.device); // TODO remove if possible
-    return NNUtil.groupNorm(
-      inputs,
-      numGroups,
-      weight: weight,
-      bias: bias,
-      eps: eps,
-    );
+    return context.runForward(this, () {
+      context.onloadModule(this);
+      final inputs = x.to(device: context.device); // TODO remove if possible
+      final tiling = context.groupNormTiling;
+      final output = tiling != null
+          ? tiling.forward(this, context.toPreferredFormat(inputs))
+          : NNUtil.groupNorm(
+              context.toPreferredFormat(inputs),
+              numGroups,
+              weight: weight,
+              bias: bias,
+              eps: eps,
+            );
+      return context.checkLayout('group_norm', output);
+    });
   }
 
   @override
@@ -254,29 +292,33 @@ class GroupNorm extends Module implements Normalization {
     if (isElementwiseAffine) {
       weight = Tensor.empty(
         [numChannels],
+        name: 'weight',
         datatype: dataType ?? DataType.float32,
         device: device ?? Device.cpu,
       );
       if (hasBias) {
         bias = Tensor.empty(
           [numChannels],
+          name: 'bias',
           datatype: dataType ?? DataType.float32,
           device: device ?? Device.cpu,
         );
       }
     }
-    return GroupNorm(
+    final norm = GroupNorm(
       name: name,
       eps: eps,
       weight: weight,
       bias: bias,
       numGroups: numGroups,
-    )..resetParameters();
+    );
+    if (device != Device.meta) norm.resetParameters();
+    return norm;
   }
 }
 
 /// Applies Root Mean Square Layer Normalization over a mini-batch of inputs.
-class RMSNorm extends Module implements Normalization {
+class RMSNorm extends Module implements ResidualNormalization {
   final Tensor? weight;
   final List<int> normalizedShape;
   final double? eps;
@@ -285,10 +327,30 @@ class RMSNorm extends Module implements Normalization {
 
   @override
   Tensor forward(Tensor x, {required Context context}) {
-    context.onloadModule(this);
-    // TODO remove if possible
-    final inputs = x.to(device: context.device);
-    return NNUtil.rmsNorm(inputs, normalizedShape, weight: weight, eps: eps);
+    return context.runForward(this, () {
+      context.onloadModule(this);
+      // TODO remove if possible
+      final inputs = x.to(device: context.device);
+      return NNUtil.rmsNorm(inputs, normalizedShape, weight: weight, eps: eps);
+    });
+  }
+
+  @override
+  Tensor forwardAddResidual_(
+    Tensor x,
+    Tensor residual, {
+    required Context context,
+  }) {
+    return context.runForward(this, () {
+      context.onloadModule(this);
+      return NNUtil.addRmsNorm_(
+        x,
+        residual,
+        normalizedShape,
+        weight: weight,
+        eps: eps,
+      );
+    });
   }
 
   @override
@@ -346,7 +408,7 @@ class RMSNorm extends Module implements Normalization {
 }
 
 /// Root Mean Square layer normalization as described by https://huggingface.co/papers/1910.07467
-class RMSNormWithBias extends Module implements Normalization {
+class RMSNormWithBias extends Module implements ResidualNormalization {
   final Tensor? weight;
   final Tensor? bias;
   final double eps;
@@ -360,20 +422,41 @@ class RMSNormWithBias extends Module implements Normalization {
 
   @override
   Tensor forward(Tensor x, {required Context context}) {
-    context.onloadModule(this);
-    // TOD= remove if possible
-    final inputs = x.to(device: context.device);
-    Tensor variance = inputs.pow(2).mean(dim: [-1], keepDim: true);
-    x = inputs * (variance + eps).rsqrt();
-
-    if (weight != null) {
-      x = x * weight!;
-      if (bias != null) {
-        x = x + bias!;
+    return context.runForward(this, () {
+      context.onloadModule(this);
+      // TOD= remove if possible
+      final inputs = x.to(device: context.device);
+      Tensor variance = inputs.pow(2).mean(dim: [-1], keepDim: true);
+      x = inputs * (variance + eps).rsqrt();
+
+      if (weight != null) {
+        x = x * weight!;
+        if (bias != null) {
+          x = x + bias!;
+        }
       }
-    }
 
-    return x;
+      return x;
+    });
+  }
+
+  @override
+  Tensor forwardAddResidual_(
+    Tensor x,
+    Tensor residual, {
+    required Context context,
+  }) {
+    return context.runForward(this, () {
+      context.onloadModule(this);
+      return NNUtil.addRmsNorm_(
+        x,
+        residual,
+        [x.shape.last],
+        weight: weight,
+        bias: weight != null ? bias : null,
+        eps: eps,
+      );
+    });
   }
 
   @override
@@ -463,28 +546,37 @@ class SpatialNorm extends Module implements Normalization {
     required this.convB,
   });
 
+  /// [embeds] is the quantized latent the normalization is conditioned on.
+  /// It is resized to the spatial size of [x].
   @override
-  Tensor forward(Tensor x, {required Context context}) {
-    context.onloadModule(this);
-    // TODO
-    throw UnimplementedError();
+  Tensor forward(Tensor x, {Tensor? embeds, required Context context}) {
+    return context.runForward(this, () {
+      context.onloadModule(this);
+      if (embeds == null) {
+        throw ArgumentError.notNull('embeds');
+      }
+      final zq = interpolateNearest(embeds, [x.shape[2], x.shape[3]]);
+      final normalized = norm.forward(x, context: context);
+      return normalized * convY.forward(zq, context: context) +
+          convB.forward(zq, context: context);
+    });
   }
 
   @override
   void resetParameters() {
-    // TODO
-    throw UnimplementedError();
+    norm.resetParameters();
+    convY.resetParameters();
+    convB.resetParameters();
   }
 
   @override
   Map<String, dynamic> get meta => {
-    // TODO
+    "numGroups": norm.numGroups,
+    "eps": norm.eps,
   };
 
   @override
-  late final Iterable<Tensor> parameters = [
-    // TODO
-  ];
+  final Iterable<Tensor> parameters = const [];
 
   @override
   late final Iterable<Module> submodules = [norm, convY, convB];
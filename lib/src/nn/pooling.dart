@@ -20,15 +20,18 @@ class AvgPool2D extends Module implements SimpleModule {
 
   @override
   Tensor forward(Tensor x, {required Context context}) {
-    return NN2DUtil.avgPool2D(
-      x,
-      kernelSize,
-      stride: stride,
-      padding: padding,
-      ceilMode: ceilMode,
-      countIncludePad: countIncludePad,
-      divisorOverride: divisorOverride,
-    );
+    return context.runForward(this, () {
+      final output = NN2DUtil.avgPool2D(
+        context.toPreferredFormat(x),
+        kernelSize,
+        stride: stride,
+        padding: padding,
+        ceilMode: ceilMode,
+        countIncludePad: countIncludePad,
+        divisorOverride: divisorOverride,
+      );
+      return context.checkLayout('avg_pool2d', output);
+    });
   }
 
   @override
@@ -0,0 +1,250 @@
+import 'dart:ffi' as ffi;
+
+import 'package:collection/collection.dart';
+import 'package:ffi/ffi.dart' as ffi;
+import 'package:tensor/tensor.dart';
+import 'package:tensor/src/ffi/torch_ffi.dart';
+
+/// Convolution weight reordered once into the oneDNN blocked layout for a
+/// given input shape.
+///
+/// The packing snapshots the weight and bias: it must be rebuilt when they
+/// are replaced or modified in place, which [matches] detects through
+/// [Tensor.implPointer] and [Tensor.version].
+class PackedConv2D implements ffi.Finalizable {
+  final ffi.Pointer<ffi.Void> nativePtr;
+
+  /// Input shape the weight was packed for.
+  final List<int> inputShape;
+
+  final Device device;
+
+  final DataType dataType;
+
+  final _PackedSource _source;
+
+  PackedConv2D._(
+    this.nativePtr,
+    this._source, {
+    required this.inputShape,
+    required this.device,
+    required this.dataType,
+  }) {
+    _finalizer.attach(this, nativePtr, detach: this);
+  }
+
+  static final _finalizer = ffi.NativeFinalizer(FFIPackedConv2D.delete);
+
+  void release() {
+    _finalizer.detach(this);
+    FFIPackedConv2D.deletePacked(nativePtr);
+  }
+
+  /// Whether the weight is held in the oneDNN layout. False when oneDNN is
+  /// not available for the weight, in which case the regular convolution is
+  /// used.
+  bool get isMkldnn => FFIPackedConv2D.isMkldnn(nativePtr);
+
+  /// Whether this packing can serve [input] convolved with [weight] and
+  /// [bias].
+  bool matches(Tensor input, Tensor weight, Tensor? bias) =>
+      _source.matches(weight, bias) &&
+      const ListEquality<int>().equals(inputShape, input.shape);
+
+  Tensor forward(Tensor input) {
+    final arena = ffi.Arena();
+    try {
+      final errorPtr = arena.allocate<ffi.Pointer<ffi.Utf8>>(
+        ffi.sizeOf<ffi.Pointer<ffi.Utf8>>(),
+      );
+      errorPtr.value = ffi.nullptr;
+      final tensorPtr = FFIPackedConv2D.forward(
+        nativePtr,
+        input.nativePtr,
+        errorPtr,
+      );
+      if (errorPtr.value != ffi.nullptr) {
+        final error = errorPtr.value.toDartString();
+        ffi.malloc.free(errorPtr.value);
+        throw Exception(error);
+      }
+      return Tensor(tensorPtr);
+    } finally {
+      arena.releaseAll();
+    }
+  }
+
+  static PackedConv2D pack(
+    Tensor weight, {
+    Tensor? bias,
+    required List<int> inputShape,
+    SymmetricPadding2D stride = const SymmetricPadding2D.same(1),
+    SymmetricPadding2D padding = const SymmetricPadding2D.same(0),
+    SymmetricPadding2D dilation = const SymmetricPadding2D.same(1),
+    int groups = 1,
+  }) {
+    final arena = ffi.Arena();
+    try {
+      final stridePointer = arena.allocate<ffi.Int64>(
+        ffi.sizeOf<ffi.Int64>() * 2,
+      );
+      stridePointer.asTypedList(2).setAll(0, stride.to2List());
+      final paddingPointer = arena.allocate<ffi.Int64>(
+        ffi.sizeOf<ffi.Int64>() * 2,
+      );
+      paddingPointer.asTypedList(2).setAll(0, padding.to2List());
+      final dilationPointer = arena.allocate<ffi.Int64>(
+        ffi.sizeOf<ffi.Int64>() * 2,
+      );
+      dilationPointer.asTypedList(2).setAll(0, dilation.to2List());
+      final inputSizesPointer = arena.allocate<ffi.Int64>(
+        ffi.sizeOf<ffi.Int64>() * inputShape.length,
+      );
+      inputSizesPointer.asTypedList(inputShape.length).setAll(0, inputShape);
+      final errorPtr = arena.allocate<ffi.Pointer<ffi.Utf8>>(
+        ffi.sizeOf<ffi.Pointer<ffi.Utf8>>(),
+      );
+      errorPtr.value = ffi.nullptr;
+
+      final packed = FFIPackedConv2D.prepack(
+        weight.nativePtr,
+        bias?.nativePtr ?? ffi.nullptr,
+        stridePointer,
+        paddingPointer,
+        dilationPointer,
+        groups,
+        inputSizesPointer,
+        inputShape.length,
+        errorPtr,
+      );
+      if (errorPtr.value != ffi.nullptr) {
+        final error = errorPtr.value.toDartString();
+        ffi.malloc.free(errorPtr.value);
+        throw Exception(error);
+      }
+      return PackedConv2D._(
+        packed,
+        _PackedSource(weight, bias),
+        inputShape: List.unmodifiable(inputShape),
+        device: weight.device,
+        dataType: weight.dataType,
+      );
+    } finally {
+      arena.releaseAll();
+    }
+  }
+}
+
+/// Linear weight converted once into the oneDNN layout so that the GEMM
+/// does not repack it on every call.
+///
+/// Like [PackedConv2D] this snapshots the weight and bias and must be
+/// rebuilt when they are replaced or modified in place, see [matches].
+class PackedLinear implements ffi.Finalizable {
+  final ffi.Pointer<ffi.Void> nativePtr;
+
+  final Device device;
+
+  final DataType dataType;
+
+  final _PackedSource _source;
+
+  PackedLinear._(
+    this.nativePtr,
+    this._source, {
+    required this.device,
+    required this.dataType,
+  }) {
+    _finalizer.attach(this, nativePtr, detach: this);
+  }
+
+  static final _finalizer = ffi.NativeFinalizer(FFIPackedLinear.delete);
+
+  void release() {
+    _finalizer.detach(this);
+    FFIPackedLinear.deletePacked(nativePtr);
+  }
+
+  bool get isMkldnn => FFIPackedLinear.isMkldnn(nativePtr);
+
+  /// Whether this packing still holds [weight] and [bias]: neither was
+  /// replaced, e.g. with [Tensor.assign_], nor modified in place.
+  bool matches(Tensor weight, Tensor? bias) => _source.matches(weight, bias);
+
+  Tensor forward(Tensor input) {
+    final arena = ffi.Arena();
+    try {
+      final errorPtr = arena.allocate<ffi.Pointer<ffi.Utf8>>(
+        ffi.sizeOf<ffi.Pointer<ffi.Utf8>>(),
+      );
+      errorPtr.value = ffi.nullptr;
+      final tensorPtr = FFIPackedLinear.forward(
+        nativePtr,
+        input.nativePtr,
+        errorPtr,
+      );
+      if (errorPtr.value != ffi.nullptr) {
+        final error = errorPtr.value.toDartString();
+        ffi.malloc.free(errorPtr.value);
+        throw Exception(error);
+      }
+      return Tensor(tensorPtr);
+    } finally {
+      arena.releaseAll();
+    }
+  }
+
+  /// Packs [weight] for inputs of [batchSize] rows; other batch sizes work
+  /// but may be slower. 0 lets oneDNN pick the layout.
+  static PackedLinear pack(Tensor weight, {Tensor? bias, int batchSize = 0}) {
+    final arena = ffi.Arena();
+    try {
+      final errorPtr = arena.allocate<ffi.Pointer<ffi.Utf8>>(
+        ffi.sizeOf<ffi.Pointer<ffi.Utf8>>(),
+      );
+      errorPtr.value = ffi.nullptr;
+      final packed = FFIPackedLinear.prepack(
+        weight.nativePtr,
+        bias?.nativePtr ?? ffi.nullptr,
+        batchSize,
+        errorPtr,
+      );
+      if (errorPtr.value != ffi.nullptr) {
+        final error = errorPtr.value.toDartString();
+        ffi.malloc.free(errorPtr.value);
+        throw Exception(error);
+      }
+      return PackedLinear._(
+        packed,
+        _PackedSource(weight, bias),
+        device: weight.device,
+        dataType: weight.dataType,
+      );
+    } finally {
+      arena.releaseAll();
+    }
+  }
+}
+
+/// Identity and in-place version of the tensors a packing was built from.
+class _PackedSource {
+  final int weightImpl;
+
+  final int weightVersion;
+
+  final int? biasImpl;
+
+  final int? biasVersion;
+
+  _PackedSource(Tensor weight, Tensor? bias)
+    : weightImpl = weight.implPointer.address,
+      weightVersion = weight.version,
+      biasImpl = bias?.implPointer.address,
+      biasVersion = bias?.version;
+
+  bool matches(Tensor weight, Tensor? bias) =>
+      weight.implPointer.address == weightImpl &&
+      weight.version == weightVersion &&
+      bias?.implPointer.address == biasImpl &&
+      bias?.version == biasVersion;
+}
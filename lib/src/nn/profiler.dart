@@ -0,0 +1,250 @@
+import 'dart:convert';
+import 'dart:ffi' as ffi;
+import 'dart:math';
+
+import 'package:ffi/ffi.dart' as ffi;
+import 'package:tensor/tensor.dart';
+import 'package:tensor/src/ffi/torch_ffi.dart';
+
+/// Aggregated measurements of one module, or of a name prefix that groups
+/// modules, in a [ModuleProfiler] tree.
+class ModuleProfile {
+  /// Last segment of [path].
+  final String name;
+
+  /// Dotted name of the module as in [ModuleExtension.stateDict].
+  final String path;
+
+  final Map<String, ModuleProfile> children = {};
+
+  /// Number of forwards recorded for this module itself.
+  int calls = 0;
+
+  int _totalNs = 0;
+
+  /// Bytes still allocated after the forward that were not before it,
+  /// summed over [calls].
+  int allocatedBytes = 0;
+
+  int _peakBytes = 0;
+
+  /// Shapes of the tensors returned by the last recorded forward.
+  List<List<int>> outputShapes = const [];
+
+  ModuleProfile(this.name, this.path);
+
+  /// Wall time including children. Nodes that were not recorded themselves
+  /// report the sum of their children.
+  int get totalNs {
+    if (calls > 0) return _totalNs;
+    return children.values.fold(0, (sum, child) => sum + child.totalNs);
+  }
+
+  /// Wall time not spent in recorded children.
+  int get selfNs {
+    final childNs = children.values.fold(0, (sum, c) => sum + c.totalNs);
+    return max(totalNs - childNs, 0);
+  }
+
+  /// Highest allocation above what was allocated on entry, over all calls
+  /// of this module and its children.
+  int get peakBytes =>
+      children.values.fold(_peakBytes, (m, child) => max(m, child.peakBytes));
+
+  Map<String, dynamic> toJson() => {
+    'name': path,
+    'calls': calls,
+    'totalNs': totalNs,
+    'selfNs': selfNs,
+    'allocatedBytes': allocatedBytes,
+    'peakBytes': peakBytes,
+    if (outputShapes.isNotEmpty) 'outputShapes': outputShapes,
+    if (children.isNotEmpty)
+      'children': [for (final child in children.values) child.toJson()],
+  };
+}
+
+/// Records wall time, allocator bytes and output shapes of every module
+/// forward run with a [Context] it is attached to.
+///
+/// Timestamps and allocator counters are read natively in a single leaf
+/// call on entry and one on exit. Allocations are counted through the
+/// libtorch allocator reporting hooks, which the CPU and CUDA allocators
+/// call on the thread that allocates. The hook is installed on a thread only
+/// while its outermost profiled forward runs, and allocations are not
+/// counted while the autograd profiler is active.
+///
+/// Accelerators such as CUDA run kernels asynchronously, so by default a
+/// module is charged for launching its kernels, and for any earlier ones it
+/// waits on, rather than for running them. With [synchronize] the current
+/// accelerator is synchronized before each timestamp, which attributes
+/// device time to the module that queued it at the cost of serializing the
+/// host with the device. It has no effect on CPU.
+///
+/// Modules are named by their position under the model given to
+/// [addModel], so that the tree matches [ModuleExtension.stateDict].
+/// Modules that were not added are named by the modules running around
+/// them.
+///
+/// ```dart
+/// final profiler = ModuleProfiler(model: unet)..attach(context);
+/// unet.forward(latent, context: context);
+/// profiler.detach(context);
+/// File('unet.folded').writeAsStringSync(profiler.toFoldedStacks());
+/// ```
+class ModuleProfiler implements ForwardHook {
+  static const int _fields = 6;
+
+  final bool trackMemory;
+
+  final bool recordShapes;
+
+  /// Waits for the accelerator before each timestamp, see [ModuleProfiler].
+  final bool synchronize;
+
+  /// Deepest nesting of module forwards that can be recorded.
+  final int maxDepth;
+
+  final ModuleProfile root = ModuleProfile('', '');
+
+  final Map<Module, String> _paths = Map.identity();
+
+  final Map<String, ModuleProfile> _nodes = {};
+
+  final List<String> _stack = [];
+
+  ffi.Pointer<ffi.Int64> _records;
+
+  ModuleProfiler({
+    Module? model,
+    this.trackMemory = true,
+    this.recordShapes = true,
+    this.synchronize = false,
+    this.maxDepth = 256,
+  }) : _records = ffi.malloc<ffi.Int64>(maxDepth * _fields) {
+    if (model != null) addModel(model);
+  }
+
+  /// Names [model] and all its submodules by their dotted path.
+  void addModel(Module model, {String? prefix}) {
+    void visit(Module module, String path) {
+      _paths[module] = path;
+      for (final submodule in module.submodules) {
+        visit(submodule, '$path.${submodule.name}');
+      }
+    }
+
+    visit(model, prefix == null ? model.name : '$prefix.${model.name}');
+  }
+
+  void attach(Context context) {
+    if (context.forwardHooks.contains(this)) return;
+    context.forwardHooks.add(this);
+    if (trackMemory) FFIProfiler.trackMemory(true);
+  }
+
+  /// Memory tracking stays on while other profilers still track memory.
+  void detach(Context context) {
+    if (!context.forwardHooks.remove(this)) return;
+    if (trackMemory) FFIProfiler.trackMemory(false);
+  }
+
+  @override
+  void before(Module module) {
+    final depth = _stack.length;
+    if (depth >= maxDepth) {
+      throw StateError('Module nesting deeper than $maxDepth');
+    }
+    final parent = depth == 0 ? null : _stack.last;
+    final path =
+        _paths[module] ??
+        (parent == null ? module.name : '$parent.${module.name}');
+    _stack.add(path);
+    if (synchronize) _synchronize();
+    FFIProfiler.enter(_records + depth * _fields);
+  }
+
+  @override
+  void after(Module module, Object? output) {
+    final depth = _stack.length - 1;
+    final record = _records + depth * _fields;
+    if (synchronize) _synchronize();
+    FFIProfiler.exit(record);
+    final node = _node(_stack.removeLast());
+    node.calls++;
+    node._totalNs += record[3] - record[0];
+    node.allocatedBytes += record[4] - record[1];
+    node._peakBytes = max(node._peakBytes, record[5] - record[1]);
+    if (recordShapes && output != null) {
+      node.outputShapes = [
+        if (output is Tensor) output.shape,
+        if (output is Iterable)
+          for (final tensor in output.whereType<Tensor>()) tensor.shape,
+      ];
+    }
+  }
+
+  void _synchronize() {
+    final errorPtr = ffi.malloc.allocate<ffi.Pointer<ffi.Utf8>>(
+      ffi.sizeOf<ffi.Pointer<ffi.Utf8>>(),
+    );
+    try {
+      errorPtr.value = ffi.nullptr;
+      FFIProfiler.synchronize(errorPtr);
+      if (errorPtr.value != ffi.nullptr) {
+        final error = errorPtr.value.toDartString();
+        ffi.malloc.free(errorPtr.value);
+        throw Exception(error);
+      }
+    } finally {
+      ffi.malloc.free(errorPtr);
+    }
+  }
+
+  ModuleProfile _node(String path) {
+    final existing = _nodes[path];
+    if (existing != null) return existing;
+    final dot = path.lastIndexOf('.');
+    final parent = dot < 0 ? root : _node(path.substring(0, dot));
+    final node = parent.children[path.substring(dot + 1)] ??= ModuleProfile(
+      path.substring(dot + 1),
+      path,
+    );
+    return _nodes[path] = node;
+  }
+
+  /// Forgets everything recorded so far.
+  void reset() {
+    root.children.clear();
+    _nodes.clear();
+  }
+
+  String toJson() => jsonEncode([
+    for (final node in root.children.values) node.toJson(),
+  ]);
+
+  /// Self times in microseconds in the folded stack format read by
+  /// flamegraph.pl, speedscope and similar tools.
+  String toFoldedStacks() {
+    final sb = StringBuffer();
+    void visit(ModuleProfile node, String stack) {
+      final frames = stack.isEmpty ? node.name : '$stack;${node.name}';
+      final micros = node.selfNs ~/ 1000;
+      if (micros > 0) sb.writeln('$frames $micros');
+      for (final child in node.children.values) {
+        visit(child, frames);
+      }
+    }
+
+    for (final node in root.children.values) {
+      visit(node, '');
+    }
+    return sb.toString();
+  }
+
+  void dispose() {
+    if (_records == ffi.nullptr) return;
+    ffi.malloc.free(_records);
+    _records = ffi.nullptr;
+  }
+}
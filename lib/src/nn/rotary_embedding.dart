@@ -0,0 +1,117 @@
+import 'dart:ffi' as ffi;
+
+import 'package:ffi/ffi.dart' as ffi;
+import 'package:tensor/tensor.dart';
+import 'package:tensor/src/ffi/torch_ffi.dart';
+
+/// Rotary position embedding (RoPE) applied in place to queries and keys.
+///
+/// The cos/sin tables are computed once per device, [rotaryDim], [base] and
+/// [scaling] and shared natively; they grow lazily as longer positions are
+/// requested. Only the first [rotaryDim] features of every head are rotated.
+///
+/// [interleaved] selects the GPT-J layout that rotates adjacent feature
+/// pairs instead of the two halves of the head (GPT-NeoX/Llama layout).
+///
+/// References:
+///   https://arxiv.org/abs/2104.09864
+class RotaryEmbedding extends Module {
+  final int rotaryDim;
+  final double base;
+
+  /// Linear position interpolation factor. Positions are divided by it.
+  final double scaling;
+  final bool interleaved;
+
+  /// Dimension of the query/key tensors that indexes the sequence.
+  final int seqDim;
+
+  RotaryEmbedding({
+    super.name = 'rotary_emb',
+    required this.rotaryDim,
+    this.base = 10000,
+    this.scaling = 1,
+    this.interleaved = false,
+    this.seqDim = -2,
+  }) : assert(rotaryDim.isEven, 'rotaryDim must be even');
+
+  /// Rotates [query] and [key] in place. The first entry along [seqDim] is at
+  /// [positionOffset], which is typically the length of the KV cache.
+  void forward_(
+    Tensor query,
+    Tensor? key, {
+    int positionOffset = 0,
+    required Context context,
+  }) {
+    context.runForward<void>(this, () {
+      apply_(
+        query,
+        key,
+        rotaryDim: rotaryDim,
+        base: base,
+        scaling: scaling,
+        positionOffset: positionOffset,
+        seqDim: seqDim,
+        interleaved: interleaved,
+      );
+    });
+  }
+
+  @override
+  void resetParameters() {}
+
+  @override
+  late final Map<String, dynamic> meta = {
+    'rotaryDim': rotaryDim,
+    'base': base,
+    'scaling': scaling,
+    'interleaved': interleaved,
+    'seqDim': seqDim,
+  };
+
+  @override
+  final Iterable<Tensor> parameters = const [];
+
+  @override
+  final Iterable<Module> submodules = const [];
+
+  static void apply_(
+    Tensor query,
+    Tensor? key, {
+    required int rotaryDim,
+    double base = 10000,
+    double scaling = 1,
+    int positionOffset = 0,
+    int seqDim = -2,
+    bool interleaved = false,
+  }) {
+    final arena = ffi.Arena();
+    try {
+      final errorPtr = arena.allocate<ffi.Pointer<ffi.Utf8>>(
+        ffi.sizeOf<ffi.Pointer<ffi.Utf8>>(),
+      );
+      errorPtr.value = ffi.nullptr;
+      FFILLM.rotaryEmbedding_(
+        query.nativePtr,
+        key?.nativePtr ?? ffi.nullptr,
+        rotaryDim,
+        base,
+        scaling,
+        positionOffset,
+        seqDim,
+        interleaved,
+        errorPtr,
+      );
+      if (errorPtr.value != ffi.nullptr) {
+        final error = errorPtr.value.toDartString();
+        ffi.malloc.free(errorPtr.value);
+        throw Exception(error);
+      }
+    } finally {
+      arena.releaseAll();
+    }
+  }
+
+  /// Releases the cached cos/sin tables of every configuration.
+  static void clearCache() => FFILLM.rotaryEmbeddingCacheClear();
+}
@@ -0,0 +1,299 @@
+import 'dart:ffi' as ffi;
+import 'dart:math';
+
+import 'package:ffi/ffi.dart' as ffi;
+import 'package:tensor/tensor.dart';
+import 'package:tensor/src/ffi/torch_ffi.dart';
+
+/// A decoder-only language model that appends to a [KVCache] on every
+/// forward.
+abstract class CausalLanguageModel {
+  /// Runs [inputIds] of shape [1, T] through the model, appending their keys
+  /// and values to [cache], and returns logits of shape [1, T, vocabSize].
+  Tensor forward(
+    Tensor inputIds, {
+    required KVCache cache,
+    required Context context,
+  });
+
+  KVCache makeCache({required Context context});
+}
+
+class SpeculativeDecodingStats {
+  int steps = 0;
+  int drafted = 0;
+  int accepted = 0;
+  int generated = 0;
+  int draftForwards = 0;
+  int targetForwards = 0;
+  Duration draftTime = Duration.zero;
+  Duration targetTime = Duration.zero;
+
+  /// Wall time of one plain single-token target forward, the cost per token
+  /// of decoding without a draft. Set by
+  /// [SpeculativeDecoder.measureTargetStep] or by the caller.
+  Duration? targetStepTime;
+
+  /// Fraction of drafted tokens accepted by the target model.
+  double get acceptanceRate => drafted == 0 ? 0 : accepted / drafted;
+
+  double get tokensPerTargetForward =>
+      targetForwards == 0 ? 0 : generated / targetForwards;
+
+  /// Cost of one draft forward relative to one target forward.
+  double get costRatio {
+    if (draftForwards == 0 || targetForwards == 0) return 0;
+    final draft = draftTime.inMicroseconds / draftForwards;
+    final target = targetTime.inMicroseconds / targetForwards;
+    return target == 0 ? 0 : draft / target;
+  }
+
+  /// Wall time the target alone would need for [generated] tokens, one
+  /// [targetStepTime] per token, divided by the wall time actually spent.
+  /// Null without a [targetStepTime]; the verify forwards score
+  /// [SpeculativeDecoder.numDraftTokens] + 1 tokens and cost more than a
+  /// single-token step.
+  double? get effectiveSpeedup {
+    final step = targetStepTime;
+    if (step == null) return null;
+    final spent = draftTime.inMicroseconds + targetTime.inMicroseconds;
+    if (spent == 0) return 0;
+    return generated * step.inMicroseconds / spent;
+  }
+
+  /// Expected speedup for [numDraftTokens] drafts per step at the measured
+  /// [acceptanceRate] and [costRatio], per https://arxiv.org/abs/2211.17192
+  double expectedSpeedup(int numDraftTokens) {
+    final alpha = acceptanceRate;
+    final denominator = numDraftTokens * costRatio + 1;
+    if (alpha >= 1) return (numDraftTokens + 1) / denominator;
+    return (1 - pow(alpha, numDraftTokens + 1)) / ((1 - alpha) * denominator);
+  }
+
+  Map<String, dynamic> toJson() => {
+    'steps': steps,
+    'drafted': drafted,
+    'accepted': accepted,
+    'generated': generated,
+    'acceptanceRate': acceptanceRate,
+    'tokensPerTargetForward': tokensPerTargetForward,
+    'costRatio': costRatio,
+    if (effectiveSpeedup != null) 'effectiveSpeedup': effectiveSpeedup,
+  };
+}
+
+/// Speculative decoding as described in https://arxiv.org/abs/2211.17192
+///
+/// A cheap [draft] model proposes [numDraftTokens] tokens which the [target]
+/// model scores in a single forward. Rejected tokens are rolled back from both
+/// caches with [KVCache.truncate]. Only batch size 1 is supported.
+class SpeculativeDecoder {
+  final CausalLanguageModel draft;
+  final CausalLanguageModel target;
+  final int numDraftTokens;
+
+  /// Sampling temperature. 0 selects greedy decoding.
+  final double temperature;
+
+  final Generator? generator;
+
+  final SpeculativeDecodingStats stats = SpeculativeDecodingStats();
+
+  SpeculativeDecoder({
+    required this.draft,
+    required this.target,
+    this.numDraftTokens = 4,
+    this.temperature = 1.0,
+    this.generator,
+  }) : assert(numDraftTokens > 0),
+       assert(temperature >= 0);
+
+  bool get isGreedy => temperature == 0;
+
+  List<int> generate(
+    List<int> prompt, {
+    required int maxNewTokens,
+    required Context context,
+    int? eosToken,
+  }) {
+    final draftCache = draft.makeCache(context: context);
+    final targetCache = target.makeCache(context: context);
+    final tokens = List<int>.of(prompt);
+    try {
+      while (tokens.length - prompt.length < maxNewTokens) {
+        final committed = step(
+          tokens,
+          draftCache: draftCache,
+          targetCache: targetCache,
+          context: context,
+        );
+        for (final token in committed) {
+          tokens.add(token);
+          if (token == eosToken ||
+              tokens.length - prompt.length == maxNewTokens) {
+            return tokens.sublist(prompt.length);
+          }
+        }
+      }
+      return tokens.sublist(prompt.length);
+    } finally {
+      draftCache.release();
+      targetCache.release();
+    }
+  }
+
+  /// Times [steps] greedy single-token target forwards after [prompt] and
+  /// stores the mean in [SpeculativeDecodingStats.targetStepTime], the
+  /// baseline of [SpeculativeDecodingStats.effectiveSpeedup]. The prompt
+  /// itself is not timed.
+  Duration measureTargetStep(
+    List<int> prompt, {
+    required Context context,
+    int steps = 8,
+  }) {
+    assert(prompt.isNotEmpty && steps > 0);
+    final cache = target.makeCache(context: context);
+    try {
+      Tensor logits = target.forward(
+        _inputIds(prompt, context),
+        cache: cache,
+        context: context,
+      );
+      int token =
+          _probs(logits.select(0, 0)).select(0, -1).argmax().scalar as int;
+      final stopwatch = Stopwatch()..start();
+      for (int i = 0; i < steps; i++) {
+        logits = target.forward(
+          _inputIds([token], context),
+          cache: cache,
+          context: context,
+        );
+        token =
+            _probs(logits.select(0, 0)).select(0, 0).argmax().scalar as int;
+      }
+      stopwatch.stop();
+      return stats.targetStepTime = stopwatch.elapsed ~/ steps;
+    } finally {
+      cache.release();
+    }
+  }
+
+  /// Drafts, verifies and commits one round of tokens. [tokens] are all the
+  /// tokens so far; the caches may lag behind them. Returns the new tokens.
+  List<int> step(
+    List<int> tokens, {
+    required KVCache draftCache,
+    required KVCache targetCache,
+    required Context context,
+  }) {
+    final draftTokens = <int>[];
+    final draftProbs = <Tensor>[];
+    List<int> pending = tokens.sublist(draftCache.length);
+    final stopwatch = Stopwatch();
+    for (int i = 0; i < numDraftTokens; i++) {
+      stopwatch
+        ..reset()
+        ..start();
+      final logits = draft.forward(
+        _inputIds(pending, context),
+        cache: draftCache,
+        context: context,
+      );
+      final probs = _probs(logits.select(0, 0)).select(0, pending.length - 1);
+      final token = isGreedy
+          ? probs.argmax().scalar as int
+          : probs.multinomial(1, generator: generator).toList().first.toInt();
+      stopwatch.stop();
+      stats.draftTime += stopwatch.elapsed;
+      stats.draftForwards++;
+      draftTokens.add(token);
+      draftProbs.add(probs);
+      pending = [token];
+    }
+
+    stopwatch
+      ..reset()
+      ..start();
+    final targetInput = [
+      ...tokens.sublist(targetCache.length),
+      ...draftTokens,
+    ];
+    final logits = target.forward(
+      _inputIds(targetInput, context),
+      cache: targetCache,
+      context: context,
+    );
+    final targetProbs = _probs(
+      logits.select(0, 0),
+    ).slice(0, targetInput.length - numDraftTokens - 1);
+    final (accepted, nextToken) = verify(
+      Tensor.stack(draftProbs),
+      targetProbs,
+      Tensor.from(draftTokens, [numDraftTokens], datatype: DataType.int64),
+      greedy: isGreedy,
+      generator: generator,
+    );
+    stopwatch.stop();
+    stats.targetTime += stopwatch.elapsed;
+    stats.targetForwards++;
+
+    final committedLength = tokens.length + accepted;
+    targetCache.truncate(committedLength);
+    draftCache.truncate(committedLength);
+
+    stats.steps++;
+    stats.drafted += numDraftTokens;
+    stats.accepted += accepted;
+    stats.generated += accepted + 1;
+    return [...draftTokens.sublist(0, accepted), nextToken];
+  }
+
+  Tensor _inputIds(List<int> ids, Context context) => Tensor.from(
+    ids,
+    [1, ids.length],
+    datatype: DataType.int64,
+    device: context.device,
+  );
+
+  Tensor _probs(Tensor logits) {
+    if (isGreedy || temperature == 1.0) return logits.softmax(-1);
+    return (logits / temperature).softmax(-1);
+  }
+
+  /// Accepts a prefix of [draftTokens] ([k]) given the draft probabilities
+  /// [k, vocabSize] and target probabilities [k + 1, vocabSize]. Returns the
+  /// number of accepted tokens and the token that follows them.
+  static (int accepted, int nextToken) verify(
+    Tensor draftProbs,
+    Tensor targetProbs,
+    Tensor draftTokens, {
+    bool greedy = false,
+    Generator? generator,
+  }) {
+    final arena = ffi.Arena();
+    try {
+      final nextToken = arena.allocate<ffi.Int64>(ffi.sizeOf<ffi.Int64>());
+      final errorPtr = arena.allocate<ffi.Pointer<ffi.Utf8>>(
+        ffi.sizeOf<ffi.Pointer<ffi.Utf8>>(),
+      );
+      errorPtr.value = ffi.nullptr;
+      final accepted = FFILLM.speculativeVerify(
+        draftProbs.nativePtr,
+        targetProbs.nativePtr,
+        draftTokens.nativePtr,
+        greedy,
+        generator?.nativePtr ?? ffi.nullptr,
+        nextToken,
+        errorPtr,
+      );
+      if (errorPtr.value != ffi.nullptr) {
+        final error = errorPtr.value.toDartString();
+        ffi.malloc.free(errorPtr.value);
+        throw Exception(error);
+      }
+      return (accepted, nextToken.value);
+    } finally {
+      arena.releaseAll();
+    }
+  }
+}
@@ -0,0 +1,365 @@
+import 'dart:math';
+
+import 'package:tensor/tensor.dart';
+
+/// Runs a 2D conv stack (e.g. a VAE encoder or decoder) over overlapping
+/// spatial tiles so that peak activation memory scales with [tileSize]
+/// instead of the image size.
+///
+/// Every output pixel is owned by the tile whose core contains it; the core
+/// boundaries sit in the middle of the overlaps. Seams are cross-faded over
+/// [blendWidth] input pixels around each boundary. [overlap] should cover
+/// the receptive field of the local ops for the blend to be exact.
+///
+/// [GroupNorm] needs statistics over the whole image, and those of each
+/// norm depend on the outputs of the norms before it. They are accumulated
+/// over the tile cores in up to [statsPasses] passes over every tile before
+/// the final one, see [GroupNormTiling]. Each pass runs the tiles to
+/// completion, with every norm using the statistics of the previous pass,
+/// or those of the tile itself in the first one. The first `k` norms are
+/// exact after `k` passes, so the default single pass makes the first norm
+/// exact and the others approximate, and `statsPasses` equal to the number
+/// of norms makes every norm exact. Passing stops early once every norm is
+/// exact, and stacks without norms run a single pass. Peak memory stays
+/// that of one tile.
+///
+/// Tiles run one after another, each using all intra-op threads. Running
+/// them concurrently would multiply peak memory by the number of tiles in
+/// flight.
+class TiledExecutor {
+  /// Tile size in input pixels.
+  final int tileSize;
+
+  /// Number of input pixels shared by neighbouring tiles.
+  final int overlap;
+
+  /// Width, in input pixels, of the cross-fade at tile seams.
+  final int blendWidth;
+
+  /// Maximum number of passes over the tiles that collect [GroupNorm]
+  /// statistics before the final one. With 0 every tile is normalized with
+  /// its own statistics.
+  final int statsPasses;
+
+  TiledExecutor({
+    required this.tileSize,
+    required this.overlap,
+    int? blendWidth,
+    this.statsPasses = 1,
+  }) : blendWidth = blendWidth ?? overlap ~/ 2,
+       assert(overlap >= 0 && overlap < tileSize),
+       assert(blendWidth == null || blendWidth <= overlap),
+       assert(statsPasses >= 0);
+
+  /// Applies [forward] to 4D [input] tile by tile. [forward] may change the
+  /// spatial size by a constant factor, e.g. 8 for a VAE decoder.
+  Tensor run(
+    Tensor input,
+    Tensor Function(Tensor tile, Context context) forward, {
+    required Context context,
+  }) {
+    final height = input.shape[2];
+    final width = input.shape[3];
+    if (height <= tileSize && width <= tileSize) {
+      return forward(input, context);
+    }
+
+    final rows = _tiles(height);
+    final columns = _tiles(width);
+    final previous = context.groupNormTiling;
+    final tiling = GroupNormTiling()..isCollecting = statsPasses > 0;
+    context.groupNormTiling = tiling;
+    try {
+      int passes = 0;
+      while (true) {
+        final output = _pass(input, rows, columns, forward, context);
+        if (output != null) return output;
+        tiling.endPass();
+        if (tiling.isExact || ++passes == statsPasses) {
+          tiling.isCollecting = false;
+        }
+      }
+    } finally {
+      context.groupNormTiling = previous;
+    }
+  }
+
+  /// Runs every tile once. Returns the blended output, or null if the pass
+  /// collected statistics.
+  Tensor? _pass(
+    Tensor input,
+    List<_Tile> rows,
+    List<_Tile> columns,
+    Tensor Function(Tensor tile, Context context) forward,
+    Context context,
+  ) {
+    final tiling = context.groupNormTiling!;
+    final height = input.shape[2];
+    final width = input.shape[3];
+    Tensor? output;
+    Tensor? weights;
+    double scale = 1;
+    for (final row in rows) {
+      for (final column in columns) {
+        tiling.beginTile(row.coreFraction, column.coreFraction);
+        final tileOutput = forward(_crop(input, row, column), context);
+        tiling.endTile();
+        if (tiling.isCollecting) continue;
+        if (output == null) {
+          scale = tileOutput.shape[2] / row.length;
+          output = Tensor.zeros(
+            [
+              tileOutput.shape[0],
+              tileOutput.shape[1],
+              (height * scale).round(),
+              (width * scale).round(),
+            ],
+            datatype: tileOutput.dataType,
+            device: tileOutput.device,
+          );
+          weights = Tensor.zeros(
+            [1, 1, output.shape[2], output.shape[3]],
+            datatype: tileOutput.dataType,
+            device: tileOutput.device,
+          );
+        }
+        final outHeight = tileOutput.shape[2];
+        final outWidth = tileOutput.shape[3];
+        final mask =
+            _ramp(row, outHeight, scale, tileOutput).view([1, 1, -1, 1]) *
+            _ramp(column, outWidth, scale, tileOutput).view([1, 1, 1, -1]);
+        final top = (row.start * scale).round();
+        final left = (column.start * scale).round();
+        final region = output
+            .slice(2, top, end: top + outHeight)
+            .slice(3, left, end: left + outWidth);
+        region.copy_(region + tileOutput * mask);
+        final weightRegion = weights!
+            .slice(2, top, end: top + outHeight)
+            .slice(3, left, end: left + outWidth);
+        weightRegion.copy_(weightRegion + mask);
+      }
+    }
+    return output == null ? null : output / weights!;
+  }
+
+  List<_Tile> _tiles(int size) {
+    if (size <= tileSize) {
+      return [_Tile(0, size, 0, size, isFirst: true, isLast: true)];
+    }
+    final stride = tileSize - overlap;
+    final starts = <int>[];
+    for (int start = 0; start + tileSize < size; start += stride) {
+      starts.add(start);
+    }
+    if (starts.last != size - tileSize) starts.add(size - tileSize);
+
+    final tiles = <_Tile>[];
+    for (int i = 0; i < starts.length; i++) {
+      final start = starts[i];
+      // Core boundaries are in the middle of the overlap with each neighbour
+      final coreStart = i == 0 ? 0 : (starts[i - 1] + tileSize + start) ~/ 2;
+      final coreEnd = i == starts.length - 1
+          ? size
+          : (start + tileSize + starts[i + 1]) ~/ 2;
+      tiles.add(
+        _Tile(
+          start,
+          tileSize,
+          coreStart,
+          coreEnd,
+          isFirst: i == 0,
+          isLast: i == starts.length - 1,
+        ),
+      );
+    }
+    return tiles;
+  }
+
+  Tensor _crop(Tensor input, _Tile row, _Tile column) => input
+      .slice(2, row.start, end: row.start + row.length)
+      .slice(3, column.start, end: column.start + column.length);
+
+  /// Blend weights along one dimension of a tile output with [outLength]
+  /// pixels. Ramps of neighbouring tiles sum to one.
+  Tensor _ramp(_Tile tile, int outLength, double scale, Tensor like) {
+    final values = List<double>.generate(outLength, (i) {
+      // Pixel centre in input coordinates
+      final position = tile.start + (i + 0.5) / scale;
+      double weight = 1;
+      if (!tile.isFirst) {
+        weight = min(weight, _fade(position - tile.coreStart));
+      }
+      if (!tile.isLast) {
+        weight = min(weight, _fade(tile.coreEnd - position));
+      }
+      return weight;
+    });
+    return Tensor.from(
+      values,
+      [outLength],
+      datatype: DataType.float32,
+    ).to(dataType: like.dataType, device: like.device);
+  }
+
+  /// 0.5 at a core boundary, reaching 1 at [blendWidth] / 2 inside the core
+  /// and 0 at [blendWidth] / 2 outside of it.
+  double _fade(double distanceInsideCore) {
+    if (blendWidth == 0) return distanceInsideCore >= 0 ? 1 : 0;
+    return (distanceInsideCore / blendWidth + 0.5).clamp(0.0, 1.0);
+  }
+}
+
+class _Tile {
+  final int start;
+  final int length;
+  final int coreStart;
+  final int coreEnd;
+  final bool isFirst;
+  final bool isLast;
+
+  _Tile(
+    this.start,
+    this.length,
+    this.coreStart,
+    this.coreEnd, {
+    required this.isFirst,
+    required this.isLast,
+  });
+
+  (double, double) get coreFraction =>
+      ((coreStart - start) / length, (coreEnd - start) / length);
+}
+
+/// Global [GroupNorm] statistics accumulated over the cores of spatial
+/// tiles. Set on [Context.groupNormTiling] while a [TiledExecutor] runs.
+///
+/// Norms are identified by the order in which they run within a tile, so a
+/// module used several times in a forward gets separate statistics for each
+/// use. Every norm uses the statistics of the previous pass, or those of
+/// the tile in the first pass. While collecting, norms that are not yet
+/// exact also accumulate the statistics of the tile core.
+class GroupNormTiling {
+  bool isCollecting = true;
+
+  (double, double) _rowCore = (0, 1);
+  (double, double) _columnCore = (0, 1);
+
+  int _index = 0;
+  bool _knowsNorms = false;
+  final List<GroupNorm> _norms = [];
+  final List<(Tensor mean, Tensor rstd)> _global = [];
+  final List<_GroupNormSums?> _collecting = [];
+
+  /// Number of leading norms whose statistics are exact.
+  int _exact = 0;
+
+  /// Whether every norm has exact statistics.
+  bool get isExact => _knowsNorms && _exact == _norms.length;
+
+  /// Starts a tile whose core spans the given fractions of its rows and
+  /// columns.
+  void beginTile((double, double) rowCore, (double, double) columnCore) {
+    _rowCore = rowCore;
+    _columnCore = columnCore;
+    _index = 0;
+  }
+
+  /// Checks that the tile ran every norm. A stack without norms needs no
+  /// statistics, so the first tile ends collection.
+  void endTile() {
+    if (!_knowsNorms) {
+      _knowsNorms = true;
+      if (_norms.isEmpty) isCollecting = false;
+    } else if (_index != _norms.length) {
+      throw StateError('Tiles ran different numbers of GroupNorms');
+    }
+  }
+
+  /// Turns the statistics collected over all tiles into the global
+  /// statistics of the next pass. The first norm that was not exact has
+  /// seen exact inputs, so it is exact from now on.
+  void endPass() {
+    for (int i = _exact; i < _norms.length; i++) {
+      final stats = _collecting[i]!.finish(_norms[i]);
+      if (i < _global.length) {
+        _global[i] = stats;
+      } else {
+        _global.add(stats);
+      }
+      _collecting[i] = null;
+    }
+    if (_exact < _norms.length) _exact++;
+  }
+
+  Tensor forward(GroupNorm norm, Tensor x) {
+    final index = _index++;
+    if (!_knowsNorms) {
+      _norms.add(norm);
+      _collecting.add(null);
+    } else if (index >= _norms.length || !identical(_norms[index], norm)) {
+      throw StateError('Tiles ran GroupNorms in different orders');
+    }
+    if (isCollecting && index >= _exact) _collect(index, norm, x);
+    if (index >= _global.length) {
+      return NNUtil.groupNorm(
+        x,
+        norm.numGroups,
+        weight: norm.weight,
+        bias: norm.bias,
+        eps: norm.eps,
+      );
+    }
+    final (mean, rstd) = _global[index];
+    return NNUtil.groupNormApply(
+      x,
+      norm.numGroups,
+      mean: mean,
+      rstd: rstd,
+      weight: norm.weight,
+      bias: norm.bias,
+    );
+  }
+
+  void _collect(int index, GroupNorm norm, Tensor x) {
+    final height = x.shape[2];
+    final width = x.shape[3];
+    final top = (_rowCore.$1 * height).round();
+    final bottom = (_rowCore.$2 * height).round();
+    final left = (_columnCore.$1 * width).round();
+    final right = (_columnCore.$2 * width).round();
+    if (bottom <= top || right <= left) return;
+
+    final core = x.slice(2, top, end: bottom).slice(3, left, end: right);
+    final (sums, sumSquares) = NNUtil.groupNormStats(core, norm.numGroups);
+    final count =
+        (x.shape[1] ~/ norm.numGroups) * (bottom - top) * (right - left);
+
+    final collecting = _collecting[index];
+    if (collecting == null) {
+      _collecting[index] = _GroupNormSums(sums, sumSquares, count);
+    } else {
+      collecting.add(sums, sumSquares, count);
+    }
+  }
+}
+
+class _GroupNormSums {
+  Tensor sums;
+  Tensor sumSquares;
+  int count;
+
+  _GroupNormSums(this.sums, this.sumSquares, this.count);
+
+  void add(Tensor sums, Tensor sumSquares, int count) {
+    this.sums = this.sums + sums;
+    this.sumSquares = this.sumSquares + sumSquares;
+    this.count += count;
+  }
+
+  (Tensor mean, Tensor rstd) finish(GroupNorm norm) {
+    final mean = sums / count;
+    final variance = (sumSquares / count - mean * mean).relu();
+    return (mean, (variance + norm.eps).rsqrt());
+  }
+}
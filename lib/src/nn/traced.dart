@@ -0,0 +1,225 @@
+import 'dart:ffi' as ffi;
+
+import 'package:ffi/ffi.dart' as ffi;
+import 'package:tensor/tensor.dart';
+import 'package:tensor/src/ffi/torch_ffi.dart';
+
+/// A forward recorded by the libtorch tracer as a TorchScript graph, then
+/// optionally frozen and optimized for inference, that replays with a single
+/// native call.
+///
+/// The graph is specialized to the sizes, data types and devices of the
+/// inputs it was traced with. Tensors the forward uses that are not inputs,
+/// such as weights, are baked in as constants, and any branch the forward
+/// takes on tensor values or sizes is fixed at tracing time.
+class TracedGraph implements ffi.Finalizable {
+  final ffi.Pointer<ffi.Void> nativePtr;
+
+  TracedGraph._(this.nativePtr) {
+    _finalizer.attach(this, nativePtr, detach: this);
+  }
+
+  static final _finalizer = ffi.NativeFinalizer(FFIGraph.delete);
+
+  /// Traces [forward] with [inputs], which it must read its inputs from,
+  /// and returns the graph along with the output of the traced run.
+  ///
+  /// With [optimize], the graph is frozen, which folds constants and
+  /// conv-batchnorm pairs, and optimized for inference, which fuses ops
+  /// such as convolutions with oneDNN where available.
+  static (TracedGraph, Tensor) trace(
+    List<Tensor> inputs,
+    Tensor Function() forward, {
+    bool optimize = true,
+  }) {
+    Tensor? output;
+    Object? failure;
+    StackTrace? failureStack;
+    // Runs synchronously on this isolate's thread from inside the native
+    // call, so the ops of the forward are dispatched while tracing.
+    final callable = ffi.NativeCallable<CTraceForward>.isolateLocal((
+      ffi.Pointer<CTensor> result,
+    ) {
+      try {
+        final tensor = forward();
+        output = tensor;
+        result.value = tensor.nativePtr;
+      } catch (e, stackTrace) {
+        failure = e;
+        failureStack = stackTrace;
+      }
+    });
+    final arena = ffi.Arena();
+    try {
+      final inputsPtr = arena.allocate<CTensor>(
+        ffi.sizeOf<CTensor>() * (inputs.isEmpty ? 1 : inputs.length),
+      );
+      for (int i = 0; i < inputs.length; i++) {
+        inputsPtr[i] = inputs[i].nativePtr;
+      }
+      final errorPtr = arena.allocate<ffi.Pointer<ffi.Utf8>>(
+        ffi.sizeOf<ffi.Pointer<ffi.Utf8>>(),
+      );
+      errorPtr.value = ffi.nullptr;
+      final graph = FFIGraph.trace(
+        inputsPtr,
+        inputs.length,
+        callable.nativeFunction,
+        optimize,
+        errorPtr,
+      );
+      if (errorPtr.value != ffi.nullptr) {
+        final error = errorPtr.value.toDartString();
+        ffi.malloc.free(errorPtr.value);
+        if (failure != null) {
+          Error.throwWithStackTrace(failure!, failureStack!);
+        }
+        throw Exception(error);
+      }
+      // Read after the native call so that the output, whose handle the
+      // tracer dereferences, cannot be finalized while tracing.
+      return (TracedGraph._(graph), output!);
+    } finally {
+      arena.releaseAll();
+      callable.close();
+    }
+  }
+
+  void release() {
+    _finalizer.detach(this);
+    FFIGraph.deleteGraph(nativePtr);
+  }
+
+  /// Runs the graph on [inputs], which must match those it was traced with.
+  Tensor run(List<Tensor> inputs) {
+    final arena = ffi.Arena();
+    try {
+      final inputsPtr = arena.allocate<CTensor>(
+        ffi.sizeOf<CTensor>() * (inputs.isEmpty ? 1 : inputs.length),
+      );
+      for (int i = 0; i < inputs.length; i++) {
+        inputsPtr[i] = inputs[i].nativePtr;
+      }
+      final errorPtr = arena.allocate<ffi.Pointer<ffi.Utf8>>(
+        ffi.sizeOf<ffi.Pointer<ffi.Utf8>>(),
+      );
+      errorPtr.value = ffi.nullptr;
+      final tensor = FFIGraph.run(
+        nativePtr,
+        inputsPtr,
+        inputs.length,
+        errorPtr,
+      );
+      if (errorPtr.value != ffi.nullptr) {
+        final error = errorPtr.value.toDartString();
+        ffi.malloc.free(errorPtr.value);
+        throw Exception(error);
+      }
+      return Tensor(tensor);
+    } finally {
+      arena.releaseAll();
+    }
+  }
+
+  /// The TorchScript IR of the graph, for inspection.
+  String dump() {
+    final text = FFIGraph.dump(nativePtr);
+    try {
+      return text.toDartString();
+    } finally {
+      ffi.malloc.free(text);
+    }
+  }
+}
+
+/// Replays a forward as [TracedGraph]s, one per input signature, instead of
+/// issuing its ops one by one from Dart.
+///
+/// The first call with a new combination of input sizes, data types and
+/// devices traces the forward. Later calls with the same signature replay
+/// the graph. Once [maxGraphs] graphs are cached, and for signatures that
+/// failed to trace, the forward runs eagerly.
+///
+/// Tracing fixes everything but the input tensors, so the forward must not
+/// branch on tensor values, and weights or the [Context] must not change
+/// between calls; [clear] drops the graphs after they do.
+///
+/// ```dart
+/// final unet = TracedForward.module(block, context: context);
+/// for (final t in timesteps) {
+///   x = unet([x]);
+/// }
+/// ```
+class TracedForward {
+  final Tensor Function(List<Tensor> inputs) forward;
+
+  final int maxGraphs;
+
+  final bool optimize;
+
+  final Map<String, TracedGraph> _graphs = {};
+
+  final Set<String> _eager = {};
+
+  int traces = 0;
+
+  int replays = 0;
+
+  int eagerRuns = 0;
+
+  TracedForward(this.forward, {this.maxGraphs = 4, this.optimize = true});
+
+  /// Traces the forward of [module] on its single input.
+  factory TracedForward.module(
+    SimpleModule module, {
+    required Context context,
+    int maxGraphs = 4,
+    bool optimize = true,
+  }) => TracedForward(
+    (inputs) => module.forward(inputs.single, context: context),
+    maxGraphs: maxGraphs,
+    optimize: optimize,
+  );
+
+  /// The cached graphs by input signature.
+  Map<String, TracedGraph> get graphs => Map.unmodifiable(_graphs);
+
+  Tensor call(List<Tensor> inputs) {
+    final key = signature(inputs);
+    final graph = _graphs[key];
+    if (graph != null) {
+      replays++;
+      return graph.run(inputs);
+    }
+    if (_graphs.length < maxGraphs && !_eager.contains(key)) {
+      try {
+        final (traced, output) = TracedGraph.trace(
+          inputs,
+          () => forward(inputs),
+          optimize: optimize,
+        );
+        _graphs[key] = traced;
+        traces++;
+        return output;
+      } on Exception {
+        _eager.add(key);
+      }
+    }
+    eagerRuns++;
+    return forward(inputs);
+  }
+
+  /// Releases the cached graphs so that the next calls trace again.
+  void clear() {
+    for (final graph in _graphs.values) {
+      graph.release();
+    }
+    _graphs.clear();
+    _eager.clear();
+  }
+
+  static String signature(List<Tensor> inputs) => [
+    for (final input in inputs)
+      '${input.dataType.name}@${input.device}${input.sizes}',
+  ].join(';');
+}
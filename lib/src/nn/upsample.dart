@@ -0,0 +1,153 @@
+import 'package:tensor/tensor.dart';
+
+/// 2x nearest-neighbour upsampling optionally followed by a convolution, as
+/// used by the UNet and VAE decoder up blocks.
+///
+/// A 3x3, padding 1 [conv] without an adapter is fused with the upsampling
+/// so that the 4x larger upsampled tensor is never allocated.
+class Upsample2D extends Module implements SimpleModule {
+  final int channels;
+  final Conv2D? conv;
+
+  Upsample2D({super.name = 'upsample', required this.channels, this.conv});
+
+  int get outChannels => conv?.numOutChannels ?? channels;
+
+  /// Whether [conv] can be computed together with the upsampling.
+  bool get isFusable {
+    final conv = this.conv;
+    if (conv == null) return false;
+    return conv.customPad == null &&
+        conv.kernelSize == const SymmetricPadding2D.same(3) &&
+        conv.padding == const SymmetricPadding2D.same(1) &&
+        conv.stride == const SymmetricPadding2D.same(1) &&
+        conv.dilation == const SymmetricPadding2D.same(1) &&
+        conv.groups == 1;
+  }
+
+  Tensor? _phaseWeights;
+
+  /// Handle to the conv weight implementation the phase kernels were
+  /// computed from. It keeps it alive so that its address is not reused by
+  /// another tensor while the kernels are cached.
+  Tensor? _phaseWeightsOf;
+
+  int _phaseWeightsVersion = 0;
+
+  @override
+  Tensor forward(
+    Tensor x, {
+    List<int>? outputSize,
+    required Context context,
+  }) {
+    return context.runForward(this, () {
+      context.onloadModule(this);
+      final conv = this.conv;
+      // The fused path reads the conv weights directly, so an adapter on
+      // the conv needs its own forward.
+      if (outputSize == null && isFusable && conv!.lora == null) {
+        context.onloadModule(conv);
+        final output = NN2DUtil.upsample2xConv2d(
+          context.toPreferredFormat(x),
+          _phaseWeightsFor(conv.weight),
+          bias: conv.bias,
+        );
+        return context.checkLayout('upsample2x_conv2d', output);
+      }
+
+      if (outputSize == null) {
+        x = interpolateNearestScale(x, [2.0, 2.0]);
+      } else {
+        x = interpolateNearest(x, outputSize);
+      }
+      x = context.checkLayout('upsample_nearest2d', x);
+      if (conv == null) return x;
+      return conv.forward(x, context: context);
+    });
+  }
+
+  Tensor _phaseWeightsFor(Tensor weight) {
+    final cached = _phaseWeights;
+    // The conv weight implementation is replaced when it changes device,
+    // dtype or memory format, and its version bumps when it is modified in
+    // place.
+    if (cached != null &&
+        _phaseWeightsOf!.implPointer == weight.implPointer &&
+        _phaseWeightsVersion == weight.version) {
+      return cached;
+    }
+    invalidatePhaseWeights();
+    _phaseWeightsOf = weight.share();
+    _phaseWeightsVersion = weight.version;
+    return _phaseWeights = NN2DUtil.upsample2xConv2dPhaseWeights(weight);
+  }
+
+  /// Drops the cached phase kernels.
+  void invalidatePhaseWeights() {
+    _phaseWeightsOf?.release();
+    _phaseWeights = null;
+    _phaseWeightsOf = null;
+  }
+
+  @override
+  void invalidateCaches() => invalidatePhaseWeights();
+
+  @override
+  void resetParameters() {
+    invalidatePhaseWeights();
+    conv?.resetParameters();
+  }
+
+  @override
+  Map<String, dynamic> get meta => {
+    "channels": channels,
+    "outChannels": outChannels,
+    "useConv": conv != null,
+  };
+
+  @override
+  final Iterable<Tensor> parameters = const [];
+
+  @override
+  late final Iterable<Module> submodules = [if (conv != null) conv!];
+
+  static Future<Upsample2D> loadFromSafeTensor(
+    SafeTensorLoader loader, {
+    String prefix = '',
+    String name = 'upsample',
+    required int channels,
+    SymmetricPadding2D padding = const SymmetricPadding2D.same(1),
+  }) async {
+    Conv2D? conv;
+    if (loader.hasTensor('${prefix}conv.weight')) {
+      conv = await Conv2D.loadFromSafeTensor(
+        loader,
+        prefix: '${prefix}conv.',
+        name: 'conv',
+        padding: padding,
+      );
+    }
+    return Upsample2D(name: name, channels: channels, conv: conv);
+  }
+
+  static Upsample2D make({
+    String name = 'upsample',
+    required int channels,
+    bool useConv = false,
+    int? outChannels,
+    SymmetricPadding2D kernelSize = const SymmetricPadding2D.same(3),
+    SymmetricPadding2D padding = const SymmetricPadding2D.same(1),
+  }) {
+    Conv2D? conv;
+    if (useConv) {
+      conv = Conv2D.make(
+        name: 'conv',
+        numInChannels: channels,
+        numOutChannels: outChannels ?? channels,
+        kernelSize: kernelSize,
+        padding: padding,
+      );
+    }
+    return Upsample2D(name: name, channels: channels, conv: conv);
+  }
+}
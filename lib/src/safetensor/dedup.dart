@@ -0,0 +1,296 @@
+import 'dart:async';
+import 'dart:convert';
+
+import 'package:tensor/tensor.dart';
+import 'package:universal_io/io.dart';
+
+/// Process-wide cache that resolves byte-identical tensors loaded from
+/// different checkpoints to one shared storage.
+///
+/// Entries are keyed by content hash and device and are refcounted: every
+/// successful [acquire] must be paired with a [release]. Since the hash is
+/// not collision-proof, the bytes of each new source are compared with the
+/// shared tensor before it is shared. The shared tensors must be treated as
+/// read-only since all holders see writes to them.
+class TensorDedupCache {
+  static final instance = TensorDedupCache();
+
+  final Map<String, Future<_SharedTensor>> _entries = {};
+
+  int _hits = 0;
+
+  int _misses = 0;
+
+  int _collisions = 0;
+
+  int _bytesSaved = 0;
+
+  int _bytesResident = 0;
+
+  /// Returns a handle to the tensor for [key], calling [load] only if no
+  /// live entry exists. [bytes] is the size of the tensor for the stats.
+  ///
+  /// [source] identifies where the tensor comes from, e.g. a tensor of a
+  /// checkpoint. The first time a live entry is acquired for a source,
+  /// [verify] compares the shared tensor with the one of the source; if
+  /// they differ, nothing is acquired and null is returned. Later
+  /// acquisitions for the same source are trusted and save no bytes.
+  Future<Tensor?> acquire(
+    String key,
+    int bytes,
+    FutureOr<Tensor> Function() load, {
+    required String source,
+    required FutureOr<bool> Function(Tensor shared) verify,
+  }) async {
+    var entry = _entries[key];
+    final isNew = entry == null;
+    if (entry == null) {
+      _misses++;
+      entry = _entries[key] = Future(() async {
+        final tensor = await load();
+        _bytesResident += bytes;
+        return _SharedTensor(tensor, bytes)..sources.add(source);
+      });
+      entry.ignore();
+    }
+    final _SharedTensor shared;
+    try {
+      shared = await entry;
+    } catch (_) {
+      if (identical(_entries[key], entry)) _entries.remove(key);
+      rethrow;
+    }
+    // Held while verifying so that a concurrent release cannot free it.
+    shared.references++;
+    if (!isNew && !shared.sources.contains(source)) {
+      final bool matches;
+      try {
+        matches = await verify(shared.tensor);
+      } catch (_) {
+        _drop(key, shared);
+        rethrow;
+      }
+      if (!matches) {
+        _collisions++;
+        _drop(key, shared);
+        return null;
+      }
+      if (shared.sources.add(source)) _bytesSaved += bytes;
+    }
+    if (!isNew) _hits++;
+    return shared.tensor.view(shared.tensor.shape);
+  }
+
+  /// Drops one reference to [key]. The cache forgets the entry with the last
+  /// reference; its storage is freed once no handle uses it any more.
+  Future<void> release(String key) async {
+    final entry = _entries[key];
+    if (entry == null) return;
+    _drop(key, await entry);
+  }
+
+  void _drop(String key, _SharedTensor shared) {
+    if (--shared.references > 0) return;
+    _entries.remove(key);
+    _bytesResident -= shared.bytes;
+    shared.tensor.release();
+  }
+
+  int get length => _entries.length;
+
+  TensorDedupStats get stats => TensorDedupStats(
+    tensors: _entries.length,
+    hits: _hits,
+    misses: _misses,
+    collisions: _collisions,
+    bytesSaved: _bytesSaved,
+    bytesResident: _bytesResident,
+  );
+}
+
+class _SharedTensor {
+  final Tensor tensor;
+
+  final int bytes;
+
+  int references = 0;
+
+  /// Sources verified to hold the same bytes.
+  final Set<String> sources = {};
+
+  _SharedTensor(this.tensor, this.bytes);
+}
+
+class TensorDedupStats {
+  /// Number of live shared tensors.
+  final int tensors;
+
+  /// Loads resolved to an existing shared tensor.
+  final int hits;
+
+  /// Loads that created a shared tensor.
+  final int misses;
+
+  /// Loads whose hash matched a shared tensor with different bytes. These
+  /// are loaded without sharing.
+  final int collisions;
+
+  /// Bytes not allocated thanks to the hits from other sources.
+  final int bytesSaved;
+
+  /// Bytes held by the live shared tensors.
+  final int bytesResident;
+
+  const TensorDedupStats({
+    required this.tensors,
+    required this.hits,
+    required this.misses,
+    required this.collisions,
+    required this.bytesSaved,
+    required this.bytesResident,
+  });
+
+  @override
+  String toString() =>
+      'TensorDedupStats(tensors: $tensors, hits: $hits, misses: $misses, '
+      'collisions: $collisions, bytesSaved: $bytesSaved, '
+      'bytesResident: $bytesResident)';
+}
+
+/// Content hashes of the tensors of a safetensors checkpoint, kept in a
+/// `.hashes.json` sidecar next to it so that each tensor is hashed once.
+///
+/// The sidecar is ignored when the checkpoint's length or modification time
+/// no longer match the ones it was written for.
+class SafeTensorHashes {
+  final String path;
+
+  final int fileLength;
+
+  final DateTime modified;
+
+  final Map<String, String> _hashes;
+
+  bool _isDirty = false;
+
+  SafeTensorHashes._(this.path, this.fileLength, this.modified, this._hashes);
+
+  static String sidecarPath(String checkpointPath) =>
+      '$checkpointPath.hashes.json';
+
+  String? operator [](String name) => _hashes[name];
+
+  void operator []=(String name, String hash) {
+    if (_hashes[name] == hash) return;
+    _hashes[name] = hash;
+    _isDirty = true;
+  }
+
+  static Future<SafeTensorHashes> load(String checkpointPath) async {
+    final stat = await File(checkpointPath).stat();
+    final hashes = <String, String>{};
+    final sidecar = File(sidecarPath(checkpointPath));
+    if (await sidecar.exists()) {
+      try {
+        final Map map = json.decode(await sidecar.readAsString());
+        if (map['fileLength'] == stat.size &&
+            map['modified'] == stat.modified.millisecondsSinceEpoch) {
+          hashes.addAll((map['hashes'] as Map).cast<String, String>());
+        }
+      } on FormatException {
+        // Rewritten on the next save.
+      }
+    }
+    return SafeTensorHashes._(checkpointPath, stat.size, stat.modified, hashes);
+  }
+
+  /// Writes the sidecar if hashes were added since it was loaded.
+  Future<void> save() async {
+    if (!_isDirty) return;
+    final sidecar = File(sidecarPath(path));
+    await sidecar.writeAsString(
+      json.encode({
+        'fileLength': fileLength,
+        'modified': modified.millisecondsSinceEpoch,
+        'hashes': _hashes,
+      }),
+    );
+    _isDirty = false;
+  }
+
+  static String format(int hash) =>
+      hash.toUnsigned(64).toRadixString(16).padLeft(16, '0');
+}
+
+/// Loads tensors of a checkpoint through a [TensorDedupCache] so that
+/// tensors identical to ones of already loaded checkpoints are shared.
+class DedupSafeTensorLoader extends SafeTensorLoader {
+  final SafeTensorLoader base;
+
+  final SafeTensorHashes hashes;
+
+  final TensorDedupCache cache;
+
+  final List<String> _acquired = [];
+
+  DedupSafeTensorLoader(this.base, this.hashes, {TensorDedupCache? cache})
+    : cache = cache ?? TensorDedupCache.instance;
+
+  @override
+  SafeTensorHeader get header => base.header;
+
+  Future<String> hashOf(String name) async {
+    final known = hashes[name];
+    if (known != null) return known;
+    final tensor = await base.loadByName(name);
+    final hash = SafeTensorHashes.format(tensor.contentHash);
+    hashes[name] = hash;
+    return hash;
+  }
+
+  @override
+  Future<Tensor?> tryLoadByName(
+    String name, {
+    Device device = Device.cpu,
+  }) async {
+    final info = tensorInfos[name];
+    if (info == null) return null;
+    final key = '${await hashOf(name)}@$device';
+    final tensor = await cache.acquire(
+      key,
+      info.bytes,
+      () => _load(name, device),
+      source: '${hashes.path}:$name',
+      verify: (shared) async =>
+          (await base.loadByName(name)).bytesEqual(shared),
+    );
+    if (tensor == null) return _load(name, device);
+    _acquired.add(key);
+    return tensor;
+  }
+
+  Future<Tensor> _load(String name, Device device) async {
+    final tensor = await base.loadByName(name, device: device);
+    // The CPU loader may return a view of its file mapping.
+    return device.deviceType == DeviceType.cpu ? tensor.clone() : tensor;
+  }
+
+  @override
+  Future<Tensor> loadByName(String name, {Device device = Device.cpu}) async {
+    final tensor = await tryLoadByName(name, device: device);
+    if (tensor == null) {
+      throw Exception('Tensor $name not found');
+    }
+    return tensor;
+  }
+
+  /// Persists newly computed hashes and drops the references to the shared
+  /// tensors loaded through this loader.
+  Future<void> release() async {
+    await hashes.save();
+    for (final key in _acquired) {
+      await cache.release(key);
+    }
+    _acquired.clear();
+  }
+}
@@ -2,6 +2,7 @@ import 'package:tensor/tensor.dart';
 import 'package:universal_io/io.dart';
 
 export 'metadata.dart';
+export 'dedup.dart';
 export 'storage.dart';
 
 abstract class SafeTensors {
@@ -54,6 +55,13 @@ class SafeTensorsFile {
     fileLength: fileLength,
   );
 
+  /// A [cpuLoader] whose tensors are shared through [cache] with identical
+  /// tensors of other checkpoints.
+  Future<DedupSafeTensorLoader> dedupLoader({TensorDedupCache? cache}) async {
+    final hashes = await SafeTensorHashes.load(path);
+    return DedupSafeTensorLoader(cpuLoader(), hashes, cache: cache);
+  }
+
   Tensor getTensor(String name) {
     // TODO read tensor
     throw UnimplementedError();
@@ -0,0 +1,115 @@
+import 'dart:ffi' as ffi;
+import 'dart:typed_data';
+
+import 'package:ffi/ffi.dart' as ffi;
+import 'package:tensor/tensor.dart';
+import 'package:tensor/src/ffi/torch_ffi.dart';
+
+/// Single-pass conversions between interleaved uint8 images and float
+/// tensors, replacing the fromBlob, permute, to, division, subtraction and
+/// contiguous chain.
+abstract class ImageUtil {
+  /// Converts uint8 [data] laid out as [batch, height, width, channels] to a
+  /// float32 [batch, channels, height, width] tensor with
+  /// `(v / 255 - mean[c]) / std[c]`. Without [mean] and [std] the values are
+  /// in [0, 1]. With [channelsLast] the result is in
+  /// [MemoryFormat.channelsLast].
+  static Tensor fromUint8(
+    Uint8List data, {
+    int batch = 1,
+    required int height,
+    required int width,
+    int channels = 3,
+    List<double>? mean,
+    List<double>? std,
+    bool channelsLast = false,
+  }) {
+    if (data.length != batch * height * width * channels) {
+      throw ArgumentError.value(
+        data.length,
+        'data',
+        'expected ${batch * height * width * channels} bytes',
+      );
+    }
+    final arena = ffi.Arena();
+    try {
+      ffi.Pointer<ffi.Float> channelValues(List<double>? values) {
+        if (values == null) return ffi.nullptr;
+        if (values.length != channels) {
+          throw ArgumentError('expected $channels values, got $values');
+        }
+        final ptr = arena.allocate<ffi.Float>(
+          channels * ffi.sizeOf<ffi.Float>(),
+        );
+        ptr.asTypedList(channels).setAll(0, values);
+        return ptr;
+      }
+
+      final meanPtr = channelValues(mean);
+      final stdPtr = channelValues(std);
+      final errorPtr = arena.allocate<ffi.Pointer<ffi.Utf8>>(
+        ffi.sizeOf<ffi.Pointer<ffi.Utf8>>(),
+      );
+      errorPtr.value = ffi.nullptr;
+      final tensor = FFIImage.fromUint8(
+        data.address,
+        batch,
+        height,
+        width,
+        channels,
+        meanPtr,
+        stdPtr,
+        channelsLast,
+        errorPtr,
+      );
+      _throwIfError(errorPtr);
+      return Tensor(tensor);
+    } finally {
+      arena.releaseAll();
+    }
+  }
+
+  /// Writes float [image] of shape [batch, channels, height, width] with
+  /// values in [[low], [high]] into [out] as clamped, rounded uint8
+  /// [batch, height, width, channels]. Allocates [out] if it is not given.
+  /// Images on other devices are copied to the CPU first.
+  static Uint8List toUint8(
+    Tensor image, {
+    Uint8List? out,
+    double low = -1,
+    double high = 1,
+  }) {
+    out ??= Uint8List(image.numel);
+    if (out.length != image.numel) {
+      throw ArgumentError.value(
+        out.length,
+        'out',
+        'expected ${image.numel} bytes',
+      );
+    }
+    // The conversion is a leaf call, which must not wait on a device.
+    if (image.device.deviceType != DeviceType.cpu) {
+      image = image.to(device: Device.cpu, dataType: DataType.float32);
+    }
+    final arena = ffi.Arena();
+    try {
+      final errorPtr = arena.allocate<ffi.Pointer<ffi.Utf8>>(
+        ffi.sizeOf<ffi.Pointer<ffi.Utf8>>(),
+      );
+      errorPtr.value = ffi.nullptr;
+      FFIImage.toUint8(image.nativePtr, out.address, low, high, errorPtr);
+      _throwIfError(errorPtr);
+      return out;
+    } finally {
+      arena.releaseAll();
+    }
+  }
+
+  static void _throwIfError(ffi.Pointer<ffi.Pointer<ffi.Utf8>> errorPtr) {
+    if (errorPtr.value != ffi.nullptr) {
+      final error = errorPtr.value.toDartString();
+      ffi.malloc.free(errorPtr.value);
+      throw Exception(error);
+    }
+  }
+}
@@ -53,6 +53,74 @@ abstract class NNUtil {
     return Tensor(tensorPtr);
   }
 
+  /// Per (batch, group) sum and sum of squares of [input] in double
+  /// precision, each of shape `[N, numGroups]`.
+  static (Tensor sums, Tensor sumSquares) groupNormStats(
+    Tensor input,
+    int numGroups,
+  ) {
+    final arena = ffi.Arena();
+    try {
+      final sumsPtr = arena.allocate<CTensor>(ffi.sizeOf<CTensor>());
+      final sumSquaresPtr = arena.allocate<CTensor>(ffi.sizeOf<CTensor>());
+      final errorPtr = arena.allocate<ffi.Pointer<ffi.Utf8>>(
+        ffi.sizeOf<ffi.Pointer<ffi.Utf8>>(),
+      );
+      errorPtr.value = ffi.nullptr;
+      FFINN.groupNormStats(
+        input.nativePtr,
+        numGroups,
+        sumsPtr,
+        sumSquaresPtr,
+        errorPtr,
+      );
+      if (errorPtr.value != ffi.nullptr) {
+        final error = errorPtr.value.toDartString();
+        ffi.malloc.free(errorPtr.value);
+        throw Exception(error);
+      }
+      return (Tensor(sumsPtr.value), Tensor(sumSquaresPtr.value));
+    } finally {
+      arena.releaseAll();
+    }
+  }
+
+  /// Group normalization of [input] with precomputed `[N, numGroups]`
+  /// [mean] and reciprocal standard deviation [rstd].
+  static Tensor groupNormApply(
+    Tensor input,
+    int numGroups, {
+    required Tensor mean,
+    required Tensor rstd,
+    Tensor? weight,
+    Tensor? bias,
+  }) {
+    final arena = ffi.Arena();
+    try {
+      final errorPtr = arena.allocate<ffi.Pointer<ffi.Utf8>>(
+        ffi.sizeOf<ffi.Pointer<ffi.Utf8>>(),
+      );
+      errorPtr.value = ffi.nullptr;
+      final tensorPtr = FFINN.groupNormApply(
+        input.nativePtr,
+        numGroups,
+        mean.nativePtr,
+        rstd.nativePtr,
+        weight?.nativePtr ?? ffi.nullptr,
+        bias?.nativePtr ?? ffi.nullptr,
+        errorPtr,
+      );
+      if (errorPtr.value != ffi.nullptr) {
+        final error = errorPtr.value.toDartString();
+        ffi.malloc.free(errorPtr.value);
+        throw Exception(error);
+      }
+      return Tensor(tensorPtr);
+    } finally {
+      arena.releaseAll();
+    }
+  }
+
   static Tensor rmsNorm(
     Tensor input,
     List<int> normalizedShape, {
@@ -87,6 +155,90 @@ abstract class NNUtil {
     }
   }
 
+  /// Adds [residual] to [input] in place and returns [input] normalized with
+  /// layer normalization over the trailing [normalizedShape] dimensions.
+  static Tensor addLayerNorm_(
+    Tensor input,
+    Tensor residual,
+    List<int> normalizedShape, {
+    Tensor? weight,
+    Tensor? bias,
+    double eps = 1e-5,
+  }) => _addNorm_(
+    input,
+    residual,
+    normalizedShape.fold(1, (a, b) => a * b),
+    weight: weight,
+    bias: bias,
+    eps: eps,
+    normType: _normTypeLayer,
+  );
+
+  /// Adds [residual] to [input] in place and returns [input] normalized with
+  /// RMS normalization over the trailing [normalizedShape] dimensions.
+  ///
+  /// [bias], if given, is added after scaling by [weight].
+  static Tensor addRmsNorm_(
+    Tensor input,
+    Tensor residual,
+    List<int> normalizedShape, {
+    Tensor? weight,
+    Tensor? bias,
+    double? eps,
+  }) => _addNorm_(
+    input,
+    residual,
+    normalizedShape.fold(1, (a, b) => a * b),
+    weight: weight,
+    bias: bias,
+    eps: eps,
+    normType: _normTypeRMS,
+  );
+
+  static const _normTypeLayer = 0;
+  static const _normTypeRMS = 1;
+
+  static Tensor _addNorm_(
+    Tensor input,
+    Tensor residual,
+    int normalizedSize, {
+    Tensor? weight,
+    Tensor? bias,
+    double? eps,
+    required int normType,
+  }) {
+    final arena = ffi.Arena();
+    try {
+      ffi.Pointer<ffi.Double> epsPointer = ffi.nullptr;
+      if (eps != null) {
+        epsPointer = arena.allocate<ffi.Double>(ffi.sizeOf<ffi.Double>())
+          ..value = eps;
+      }
+      final errorPtr = arena.allocate<ffi.Pointer<ffi.Utf8>>(
+        ffi.sizeOf<ffi.Pointer<ffi.Utf8>>(),
+      );
+      errorPtr.value = ffi.nullptr;
+      final tensorPtr = FFINN.addNorm_(
+        input.nativePtr,
+        residual.nativePtr,
+        normalizedSize,
+        weight?.nativePtr ?? ffi.nullptr,
+        bias?.nativePtr ?? ffi.nullptr,
+        epsPointer,
+        normType,
+        errorPtr,
+      );
+      if (errorPtr.value != ffi.nullptr) {
+        final error = errorPtr.value.toDartString();
+        ffi.malloc.free(errorPtr.value);
+        throw Exception(error);
+      }
+      return Tensor(tensorPtr);
+    } finally {
+      arena.releaseAll();
+    }
+  }
+
   static Tensor dropout(Tensor input, double p, {bool training = true}) {
     final output = FFINN.dropout(input.nativePtr, p, training);
     return Tensor(output);
@@ -105,6 +257,139 @@ abstract class NNUtil {
     return Tensor(tensorPtr);
   }
 
+  /// Computes `activation(linear(input, weight, bias))` with the activation
+  /// applied as an epilogue of the matrix multiply.
+  static Tensor linearActivation(
+    Tensor input,
+    Tensor weight, {
+    Tensor? bias,
+    required FusedActivation activation,
+  }) => _linearFused(
+    FFINN.linearActivation,
+    input,
+    weight,
+    bias: bias,
+    activation: activation,
+  );
+
+  /// Gated linear unit. [weight] projects to `[hidden, gate]` halves and the
+  /// result is `hidden * activation(gate)`. With [FusedActivation.gelu] this
+  /// is GEGLU.
+  static Tensor linearGated(
+    Tensor input,
+    Tensor weight, {
+    Tensor? bias,
+    required FusedActivation activation,
+  }) => _linearFused(
+    FFINN.linearGated,
+    input,
+    weight,
+    bias: bias,
+    activation: activation,
+  );
+
+  /// Adds the low-rank update `scale * (input @ down^T) @ up^T` to [output]
+  /// in place, where [down] is `[rank, in]` and [up] is `[out, rank]`.
+  static void loraAdd_(
+    Tensor output,
+    Tensor input,
+    Tensor down,
+    Tensor up, {
+    double scale = 1,
+  }) {
+    _call(
+      (error) => FFINN.loraAdd_(
+        output.nativePtr,
+        input.nativePtr,
+        down.nativePtr,
+        up.nativePtr,
+        scale,
+        error,
+      ),
+    );
+  }
+
+  /// Like [loraAdd_] with one adapter per batch row: [down] is
+  /// `[adapters, rank, in]`, [up] is `[adapters, out, rank]`, [scales] is
+  /// `[adapters]` and row `b` uses adapter `indices[b]`, or none if it is
+  /// negative.
+  static void loraAddBatched_(
+    Tensor output,
+    Tensor input,
+    Tensor down,
+    Tensor up, {
+    required Tensor scales,
+    required Tensor indices,
+  }) {
+    _call(
+      (error) => FFINN.loraAddBatched_(
+        output.nativePtr,
+        input.nativePtr,
+        down.nativePtr,
+        up.nativePtr,
+        scales.nativePtr,
+        indices.nativePtr,
+        error,
+      ),
+    );
+  }
+
+  static void _call(void Function(ffi.Pointer<ffi.Pointer<ffi.Utf8>>) op) {
+    final arena = ffi.Arena();
+    try {
+      final errorPtr = arena.allocate<ffi.Pointer<ffi.Utf8>>(
+        ffi.sizeOf<ffi.Pointer<ffi.Utf8>>(),
+      );
+      errorPtr.value = ffi.nullptr;
+      op(errorPtr);
+      if (errorPtr.value != ffi.nullptr) {
+        final error = errorPtr.value.toDartString();
+        ffi.malloc.free(errorPtr.value);
+        throw Exception(error);
+      }
+    } finally {
+      arena.releaseAll();
+    }
+  }
+
+  static Tensor _linearFused(
+    CTensor Function(
+      CTensor input,
+      CTensor weight,
+      CTensor bias,
+      int activation,
+      ffi.Pointer<ffi.Pointer<ffi.Utf8>> error,
+    )
+    op,
+    Tensor input,
+    Tensor weight, {
+    Tensor? bias,
+    required FusedActivation activation,
+  }) {
+    final arena = ffi.Arena();
+    try {
+      final errorPtr = arena.allocate<ffi.Pointer<ffi.Utf8>>(
+        ffi.sizeOf<ffi.Pointer<ffi.Utf8>>(),
+      );
+      errorPtr.value = ffi.nullptr;
+      final tensorPtr = op(
+        input.nativePtr,
+        weight.nativePtr,
+        bias?.nativePtr ?? ffi.nullptr,
+        activation.index,
+        errorPtr,
+      );
+      if (errorPtr.value != ffi.nullptr) {
+        final error = errorPtr.value.toDartString();
+        ffi.malloc.free(errorPtr.value);
+        throw Exception(error);
+      }
+      return Tensor(tensorPtr);
+    } finally {
+      arena.releaseAll();
+    }
+  }
+
   static Tensor embeddingRenorm_(
     Tensor weights,
     Tensor indices,
@@ -198,6 +483,61 @@ abstract class NN2DUtil {
     }
   }
 
+  /// Folds a 3x3 [weight] into the four 2x2 phase kernels used by
+  /// [upsample2xConv2d].
+  static Tensor upsample2xConv2dPhaseWeights(Tensor weight) {
+    final arena = ffi.Arena();
+    try {
+      final errorPtr = arena.allocate<ffi.Pointer<ffi.Utf8>>(
+        ffi.sizeOf<ffi.Pointer<ffi.Utf8>>(),
+      );
+      errorPtr.value = ffi.nullptr;
+      final tensorPtr = FFINN2D.upsample2xConv2dPhaseWeights(
+        weight.nativePtr,
+        errorPtr,
+      );
+      if (errorPtr.value != ffi.nullptr) {
+        final error = errorPtr.value.toDartString();
+        ffi.malloc.free(errorPtr.value);
+        throw Exception(error);
+      }
+      return Tensor(tensorPtr);
+    } finally {
+      arena.releaseAll();
+    }
+  }
+
+  /// Computes a 3x3, padding 1 convolution of the 2x nearest upsampled
+  /// [input] without materializing the upsampled tensor. [phaseWeights] come
+  /// from [upsample2xConv2dPhaseWeights].
+  static Tensor upsample2xConv2d(
+    Tensor input,
+    Tensor phaseWeights, {
+    Tensor? bias,
+  }) {
+    final arena = ffi.Arena();
+    try {
+      final errorPtr = arena.allocate<ffi.Pointer<ffi.Utf8>>(
+        ffi.sizeOf<ffi.Pointer<ffi.Utf8>>(),
+      );
+      errorPtr.value = ffi.nullptr;
+      final tensorPtr = FFINN2D.upsample2xConv2d(
+        input.nativePtr,
+        phaseWeights.nativePtr,
+        bias?.nativePtr ?? ffi.nullptr,
+        errorPtr,
+      );
+      if (errorPtr.value != ffi.nullptr) {
+        final error = errorPtr.value.toDartString();
+        ffi.malloc.free(errorPtr.value);
+        throw Exception(error);
+      }
+      return Tensor(tensorPtr);
+    } finally {
+      arena.releaseAll();
+    }
+  }
+
   static Tensor conv2dTranspose(
     Tensor input,
     Tensor weight, {
@@ -293,3 +633,7 @@ abstract class NN2DUtil {
     }
   }
 }
+
+/// Activations that native ops can apply as a fused epilogue. The index
+/// matches the `activation*` constants of torchffi.
+enum FusedActivation { none, gelu, geluTanh, silu, quickGelu, relu }
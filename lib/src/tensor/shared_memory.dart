@@ -0,0 +1,101 @@
+import 'dart:ffi' as ffi;
+
+import 'package:ffi/ffi.dart' as ffi;
+import 'package:tensor/tensor.dart';
+import 'package:tensor/src/ffi/torch_ffi.dart';
+
+/// CPU tensors backed by a named POSIX shared memory region, e.g. to hand
+/// activations between worker processes behind a local router without
+/// copying them through a pipe.
+///
+/// [create] makes a new region and maps it as a tensor; the region's name
+/// is its descriptor and is what gets sent to other processes, which
+/// [open] it to map the same memory as a tensor of the same sizes and
+/// data type. Writes through any of the tensors are seen by all of them.
+///
+/// The region holds a reference count shared by all processes: each
+/// tensor returned by [create] or [open] holds one, and the last one to be
+/// released unlinks the name. A process that exits without releasing its
+/// tensors leaves its references behind, so routers should release the
+/// regions of workers that crash. Names follow `shm_open`: a leading `/`
+/// and no other slashes. Not supported on Windows.
+///
+/// ```dart
+/// final x = SharedMemoryTensor.copyOf(latents, '/worker-1-latents');
+/// router.send('/worker-1-latents');
+/// // In the worker:
+/// final latents = SharedMemoryTensor.open('/worker-1-latents');
+/// ```
+abstract class SharedMemoryTensor {
+  /// Creates the region [name], which must not exist yet, as an
+  /// uninitialized tensor of [sizes].
+  static Tensor create(
+    String name,
+    List<int> sizes, {
+    DataType datatype = DataType.float32,
+  }) {
+    final arena = ffi.Arena();
+    try {
+      final dims = arena.allocate<ffi.Int64>(
+        ffi.sizeOf<ffi.Int64>() * (sizes.isEmpty ? 1 : sizes.length),
+      );
+      dims.asTypedList(sizes.length).setAll(0, sizes);
+      final errorPtr = arena.allocate<ffi.Pointer<ffi.Utf8>>(
+        ffi.sizeOf<ffi.Pointer<ffi.Utf8>>(),
+      );
+      errorPtr.value = ffi.nullptr;
+      final tensor = FFISharedMemory.create(
+        name.toNativeUtf8(allocator: arena),
+        dims,
+        sizes.length,
+        datatype.type,
+        errorPtr,
+      );
+      if (errorPtr.value != ffi.nullptr) {
+        final error = errorPtr.value.toDartString();
+        ffi.malloc.free(errorPtr.value);
+        throw Exception(error);
+      }
+      return Tensor(tensor);
+    } finally {
+      arena.releaseAll();
+    }
+  }
+
+  /// Maps the region [name] created by this or another process.
+  static Tensor open(String name) {
+    final arena = ffi.Arena();
+    try {
+      final errorPtr = arena.allocate<ffi.Pointer<ffi.Utf8>>(
+        ffi.sizeOf<ffi.Pointer<ffi.Utf8>>(),
+      );
+      errorPtr.value = ffi.nullptr;
+      final tensor = FFISharedMemory.open(
+        name.toNativeUtf8(allocator: arena),
+        errorPtr,
+      );
+      if (errorPtr.value != ffi.nullptr) {
+        final error = errorPtr.value.toDartString();
+        ffi.malloc.free(errorPtr.value);
+        throw Exception(error);
+      }
+      return Tensor(tensor);
+    } finally {
+      arena.releaseAll();
+    }
+  }
+
+  /// Creates the region [name] with a copy of [tensor].
+  static Tensor copyOf(Tensor tensor, String name) {
+    final shared = create(name, tensor.sizes, datatype: tensor.dataType);
+    shared.copy_(tensor);
+    return shared;
+  }
+
+  /// Number of tensors mapping the region of [tensor] in all processes, or
+  /// `null` if [tensor] is not a shared memory tensor.
+  static int? refs(Tensor tensor) {
+    final refs = FFISharedMemory.refs(tensor.nativePtr);
+    return refs < 0 ? null : refs;
+  }
+}
@@ -0,0 +1,61 @@
+import 'dart:ffi' as ffi;
+
+import 'package:ffi/ffi.dart' as ffi;
+import 'package:tensor/tensor.dart';
+import 'package:tensor/src/ffi/torch_ffi.dart';
+
+/// A tensor exported for other isolates of this process, e.g. to serve one
+/// copy of a model's weights from several worker isolates.
+///
+/// [TensorToken.export] holds a reference to the tensor for each of its
+/// importers. Each [import] turns one of them into a new owning [Tensor]
+/// over the same storage, and [release] drops those that will not be
+/// imported. The storage is freed once the exporter and every importer have
+/// dropped their tensors. A token is a plain value that can be sent through
+/// a `SendPort`, or passed around as its [address].
+///
+/// Imported tensors share data with the exported one, so in-place writes
+/// are seen by all isolates; sizes, strides and `requires_grad` are not
+/// shared.
+class TensorToken {
+  final int address;
+
+  const TensorToken.fromAddress(this.address);
+
+  /// Exports [tensor] to be imported [importers] times in total.
+  factory TensorToken.export(Tensor tensor, {int importers = 1}) {
+    final arena = ffi.Arena();
+    try {
+      final errorPtr = arena.allocate<ffi.Pointer<ffi.Utf8>>(
+        ffi.sizeOf<ffi.Pointer<ffi.Utf8>>(),
+      );
+      errorPtr.value = ffi.nullptr;
+      final token = FFISharedTensor.share(
+        tensor.nativePtr,
+        importers,
+        errorPtr,
+      );
+      if (errorPtr.value != ffi.nullptr) {
+        final error = errorPtr.value.toDartString();
+        ffi.malloc.free(errorPtr.value);
+        throw Exception(error);
+      }
+      return TensorToken.fromAddress(token.address);
+    } finally {
+      arena.releaseAll();
+    }
+  }
+
+  ffi.Pointer<ffi.Void> get _nativePtr =>
+      ffi.Pointer<ffi.Void>.fromAddress(address);
+
+  /// Number of imports left. The token must not be used once it is zero.
+  int get remaining => FFISharedTensor.remaining(_nativePtr);
+
+  /// Takes one of the remaining imports as a new tensor owned by the
+  /// calling isolate.
+  Tensor import() => Tensor(FFISharedTensor.import(_nativePtr));
+
+  /// Gives up [count] of the remaining imports.
+  void release([int count = 1]) => FFISharedTensor.release(_nativePtr, count);
+}
@@ -1,11 +1,16 @@
 import 'dart:ffi' as ffi;
+import 'dart:typed_data';
+
 import 'package:collection/collection.dart';
 import 'package:ffi/ffi.dart' as ffi;
 import 'package:tensor/tensor.dart';
 import 'package:tensor/src/ffi/torch_ffi.dart';
 
 export 'finfo.dart';
+export 'image.dart';
 export 'nn.dart';
+export 'shared_memory.dart';
+export 'shared_tensor.dart';
 
 class Tensor implements ffi.Finalizable {
   ffi.Pointer<ffi.Void> nativePtr;
@@ -437,6 +442,67 @@ class Tensor implements ffi.Finalizable {
     }
   }
 
+  /// Wraps [dataPointer] without copying and transfers its ownership to the
+  /// tensor storage. [release] is invoked once the last tensor or view
+  /// sharing the storage is released. If this throws, the caller keeps
+  /// ownership of [dataPointer].
+  ///
+  /// A [BlobRelease.listener] serves a single call; passing it again throws
+  /// a [StateError].
+  static Tensor fromBlobOwned(
+    ffi.Pointer<ffi.Void> dataPointer,
+    List<int> sizes, {
+    required BlobRelease release,
+    String? name,
+    required DataType datatype,
+    Device? device,
+    Layout? layout,
+    MemoryFormat? memoryFormat,
+    bool? requiresGrad,
+    bool? pinnedMemory,
+  }) {
+    release._consume();
+    final arena = ffi.Arena();
+    try {
+      final options = CTensorOptions.make(
+        dataType: datatype,
+        device: device,
+        layout: layout,
+        memoryFormat: memoryFormat,
+        requiresGrad: requiresGrad,
+        pinnedMemory: pinnedMemory,
+        allocator: arena,
+      );
+
+      final sizesPointer = arena.allocate<ffi.Int64>(
+        sizes.length * ffi.sizeOf<ffi.Int64>(),
+      );
+      sizesPointer.asTypedList(sizes.length).setAll(0, sizes);
+      final errorPtr = arena.allocate<ffi.Pointer<ffi.Utf8>>(
+        ffi.sizeOf<ffi.Pointer<ffi.Utf8>>(),
+      );
+      errorPtr.value = ffi.nullptr;
+      final tensor = FFITensor.fromBlobOwned(
+        dataPointer,
+        sizesPointer,
+        sizes.length,
+        options.ref,
+        release.function,
+        release.context,
+        errorPtr,
+      );
+      if (errorPtr.value != ffi.nullptr) {
+        final error = errorPtr.value.toDartString();
+        ffi.malloc.free(errorPtr.value);
+        release._cancel();
+        throw Exception(error);
+      }
+      return Tensor(tensor, name: name);
+    } finally {
+      arena.releaseAll();
+    }
+  }
+
   void ones_() {
     FFITensor.ones_(nativePtr);
   }
@@ -477,6 +543,47 @@ class Tensor implements ffi.Finalizable {
 
   ffi.Pointer<void> get dataPointer => FFITensor.dataPointer(nativePtr);
 
+  /// Address of the underlying tensor implementation. Shared by all handles
+  /// to the same tensor, unlike [nativePtr].
+  ffi.Pointer<ffi.Void> get implPointer => FFITensor.impl(nativePtr);
+
+  /// Another handle to the same tensor implementation. Unlike this handle
+  /// after [to_] or [assign_], it keeps referring to, and keeps alive, the
+  /// current implementation.
+  Tensor share() => Tensor(FFITensor.share(nativePtr));
+
+  /// Counter bumped by every in-place modification of this tensor.
+  int get version => FFITensor.version(nativePtr);
+
+  /// Whether this tensor only has metadata, see [Device.meta].
+  bool get isMeta => device.deviceType == DeviceType.meta;
+
+  /// Makes this handle refer to [other], e.g. to materialize a meta tensor
+  /// in place. Other handles to the previous tensor are not affected.
+  /// Whether this tensor requires grad is kept.
+  void assign_(Tensor other) {
+    FFITensor.assign(nativePtr, other.nativePtr);
+  }
+
+  /// 64-bit hash of the dtype, shape and row-major contents, computed in
+  /// parallel. Equal tensors have equal hashes on any device and layout.
+  int get contentHash {
+    int hash = 0;
+    _bulkCall((error) => hash = FFITensor.contentHash(nativePtr, error));
+    return hash;
+  }
+
+  /// Whether [other] has the same dtype, shape and row-major bytes, on any
+  /// device and layout. Confirms a [contentHash] match.
+  bool bytesEqual(Tensor other) {
+    bool equal = false;
+    _bulkCall(
+      (error) =>
+          equal = FFITensor.bytesEqual(nativePtr, other.nativePtr, error),
+    );
+    return equal;
+  }
+
   int get dim => FFITensor.dim(nativePtr);
 
   int get elementSize => FFITensor.elementSize(nativePtr);
@@ -515,6 +622,121 @@ class Tensor implements ffi.Finalizable {
     return scalar.value;
   }
 
+  /// Copies all elements in row-major order into [out] as [dataType], in one
+  /// pass regardless of strides and device.
+  void readInto(ffi.Pointer<ffi.Void> out, DataType dataType) {
+    _bulkCall(
+      (error) => FFITensor.readInto(nativePtr, out, dataType.type, error),
+    );
+  }
+
+  /// Overwrites this tensor with row-major [data] of type [dataType].
+  void writeFrom(ffi.Pointer<ffi.Void> data, DataType dataType) {
+    _bulkCall(
+      (error) => FFITensor.writeFrom(nativePtr, data, dataType.type, error),
+    );
+  }
+
+  /// Reads the element at each index tuple of [indices] into [out] as
+  /// [dataType] with a single native call.
+  void gatherInto(
+    List<List<int>> indices,
+    ffi.Pointer<ffi.Void> out,
+    DataType dataType,
+  ) {
+    final dim = this.dim;
+    final arena = ffi.Arena();
+    try {
+      final indicesPtr = arena.allocate<ffi.Int64>(
+        indices.length * dim * ffi.sizeOf<ffi.Int64>(),
+      );
+      final list = indicesPtr.asTypedList(indices.length * dim);
+      for (int i = 0; i < indices.length; i++) {
+        if (indices[i].length != dim) {
+          throw ArgumentError('expected $dim indices, got ${indices[i]}');
+        }
+        list.setAll(i * dim, indices[i]);
+      }
+      _bulkCall(
+        (error) => FFITensor.gatherInto(
+          nativePtr,
+          indicesPtr,
+          indices.length,
+          out,
+          dataType.type,
+          error,
+        ),
+      );
+    } finally {
+      arena.releaseAll();
+    }
+  }
+
+  /// Elements at [indices], as doubles for floating point tensors and ints
+  /// otherwise.
+  List<num> gather(List<List<int>> indices) {
+    final count = indices.length;
+    if (count == 0) return const [];
+    if (dataType.isFloatingPoint) {
+      final out = ffi.malloc.allocate<ffi.Double>(
+        count * ffi.sizeOf<ffi.Double>(),
+      );
+      gatherInto(indices, out.cast(), DataType.float64);
+      return out.asTypedList(count, finalizer: ffi.malloc.nativeFree);
+    }
+    final out = ffi.malloc.allocate<ffi.Int64>(count * ffi.sizeOf<ffi.Int64>());
+    gatherInto(indices, out.cast(), DataType.int64);
+    return out.asTypedList(count, finalizer: ffi.malloc.nativeFree);
+  }
+
+  /// All elements in row-major order converted to float32.
+  Float32List toFloat32List() {
+    final numel = this.numel;
+    if (numel == 0) return Float32List(0);
+    final out = ffi.malloc.allocate<ffi.Float>(numel * ffi.sizeOf<ffi.Float>());
+    readInto(out.cast(), DataType.float32);
+    return out.asTypedList(numel, finalizer: ffi.malloc.nativeFree);
+  }
+
+  /// All elements in row-major order converted to float64.
+  Float64List toFloat64List() {
+    final numel = this.numel;
+    if (numel == 0) return Float64List(0);
+    final out = ffi.malloc.allocate<ffi.Double>(
+      numel * ffi.sizeOf<ffi.Double>(),
+    );
+    readInto(out.cast(), DataType.float64);
+    return out.asTypedList(numel, finalizer: ffi.malloc.nativeFree);
+  }
+
+  /// All elements in row-major order converted to int64.
+  Int64List toInt64List() {
+    final numel = this.numel;
+    if (numel == 0) return Int64List(0);
+    final out = ffi.malloc.allocate<ffi.Int64>(numel * ffi.sizeOf<ffi.Int64>());
+    readInto(out.cast(), DataType.int64);
+    return out.asTypedList(numel, finalizer: ffi.malloc.nativeFree);
+  }
+
+  static void _bulkCall(
+    void Function(ffi.Pointer<ffi.Pointer<ffi.Utf8>>) op,
+  ) {
+    final errorPtr = ffi.malloc.allocate<ffi.Pointer<ffi.Utf8>>(
+      ffi.sizeOf<ffi.Pointer<ffi.Utf8>>(),
+    );
+    try {
+      errorPtr.value = ffi.nullptr;
+      op(errorPtr);
+      if (errorPtr.value != ffi.nullptr) {
+        final error = errorPtr.value.toDartString();
+        ffi.malloc.free(errorPtr.value);
+        throw Exception(error);
+      }
+    } finally {
+      ffi.malloc.free(errorPtr);
+    }
+  }
+
   Tensor operator [](int index) {
     /*if (isScalar) {
       throw Exception('Scalar tensor cannot be indexed');
@@ -2043,6 +2265,72 @@ class Layout {
   ];
 }
 
+/// How the storage of [Tensor.fromBlobOwned] gives its buffer back.
+class BlobRelease {
+  final ffi.Pointer<ffi.NativeFunction<CBlobRelease>> function;
+
+  final ffi.Pointer<ffi.Void> context;
+
+  final _BlobListener? _listener;
+
+  const BlobRelease(this.function, {this.context = ffi.nullptr})
+    : _listener = null;
+
+  BlobRelease._listener(_BlobListener listener)
+    : function = listener.callable.nativeFunction,
+      context = ffi.nullptr,
+      _listener = listener;
+
+  /// For buffers allocated with C `malloc`, such as [ffi.malloc] on POSIX
+  /// platforms.
+  static final free = BlobRelease(FFITensor.blobReleaseFree);
+
+  /// For a region of [length] bytes mapped with `mmap`.
+  static BlobRelease munmap(int length) => BlobRelease(
+    FFITensor.blobReleaseMunmap,
+    context: ffi.Pointer<ffi.Void>.fromAddress(length),
+  );
+
+  /// Calls [onRelease] with the buffer on this isolate's event loop once
+  /// the storage is freed, e.g. to hand it back to an external decoder.
+  /// The pending callback keeps the isolate alive until it has run.
+  ///
+  /// The callback runs once, so the returned instance can be passed to a
+  /// single [Tensor.fromBlobOwned].
+  factory BlobRelease.listener(
+    void Function(ffi.Pointer<ffi.Void> data) onRelease,
+  ) {
+    late final ffi.NativeCallable<CBlobRelease> callable;
+    callable = ffi.NativeCallable<CBlobRelease>.listener((
+      ffi.Pointer<ffi.Void> data,
+      ffi.Pointer<ffi.Void> context,
+    ) {
+      callable.close();
+      onRelease(data);
+    });
+    return BlobRelease._listener(_BlobListener(callable));
+  }
+
+  void _consume() {
+    final listener = _listener;
+    if (listener == null) return;
+    if (listener.isConsumed) {
+      throw StateError('BlobRelease.listener was already used');
+    }
+    listener.isConsumed = true;
+  }
+
+  void _cancel() => _listener?.callable.close();
+}
+
+class _BlobListener {
+  final ffi.NativeCallable<CBlobRelease> callable;
+
+  bool isConsumed = false;
+
+  _BlobListener(this.callable);
+}
+
 class MemoryFormat {
   final String name;
   final int id;
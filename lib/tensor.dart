@@ -2,6 +2,8 @@ export 'src/safetensor/safetensor.dart';
 export 'src/tensor/tensor.dart';
 export 'src/nn/nn.dart';
 export 'src/init/init.dart';
+export 'src/diffusion/diffusion.dart';
+export 'src/executor/executor.dart';
 
 export 'src/ffi/torch_ffi.dart'
     show
@@ -0,0 +1,44 @@
+import 'package:tensor/tensor.dart';
+import 'package:test/test.dart';
+
+void main() {
+  group('ClassifierFreeGuidance', () {
+    test('combine', () {
+      final output = Tensor.randn([4, 4, 8, 8]);
+      final parts = output.chunk(2);
+      final expected = parts[0] + (parts[1] - parts[0]) * 7.5;
+
+      final guidance = ClassifierFreeGuidance(scale: 7.5);
+      final out = guidance.combine(output);
+      expect(out.shape, [2, 4, 8, 8]);
+      expect(out.allClose(expected, atol: 1e-4), true);
+    });
+
+    test('forward matches separate passes', () {
+      final weight = Tensor.randn([1, 4, 8, 8]);
+      Tensor model(Tensor latent, Tensor conditioning) =>
+          latent * weight + conditioning;
+
+      final latent = Tensor.randn([2, 4, 8, 8]);
+      final uncond = Tensor.randn([2, 4, 8, 8]);
+      final cond = Tensor.randn([2, 4, 8, 8]);
+      final guidance = ClassifierFreeGuidance(scale: 5);
+
+      final batched = guidance.forward(
+        latent,
+        guidance.batchConditioning(uncond, cond),
+        model,
+      );
+      final u = model(latent, uncond);
+      final c = model(latent, cond);
+      expect(batched.allClose(u + (c - u) * 5, atol: 1e-4), true);
+    });
+
+    test('odd batch throws', () {
+      expect(
+        () => ClassifierFreeGuidance.combineHalves(Tensor.randn([3, 4]), 2),
+        throwsException,
+      );
+    });
+  });
+}
@@ -0,0 +1,85 @@
+import 'dart:math';
+
+import 'package:tensor/tensor.dart';
+import 'package:test/test.dart';
+
+void main() {
+  group('SamplerUtil', () {
+    test('step_', () {
+      final x = Tensor.randn([2, 4, 8, 8]);
+      final t1 = Tensor.randn([2, 4, 8, 8]);
+      final t2 = Tensor.randn([2, 4, 8, 8]);
+      final expected = x * 0.5 + t1 * 2 + t2 * -0.25;
+
+      SamplerUtil.step_(x, a: 0.5, t1: t1, c1: 2, t2: t2, c2: -0.25);
+      expect(x.allClose(expected, atol: 1e-5), true);
+    });
+
+    test('eulerStep_', () {
+      final x = Tensor.randn([1, 4, 16, 16]);
+      final denoised = Tensor.randn([1, 4, 16, 16]);
+      const sigma = 7.0, sigmaNext = 5.5;
+      final d = (x - denoised) / sigma;
+      final expected = x + d * (sigmaNext - sigma);
+
+      SamplerUtil.eulerStep_(
+        x,
+        denoised,
+        sigma: sigma,
+        sigmaNext: sigmaNext,
+      );
+      expect(x.allClose(expected, atol: 1e-5), true);
+    });
+
+    test('ddimStep_', () {
+      final x = Tensor.randn([1, 4, 16, 16]);
+      final eps = Tensor.randn([1, 4, 16, 16]);
+      const alpha = 0.3, alphaPrev = 0.5;
+      final predOriginal = (x - eps * sqrt(1 - alpha)) / sqrt(alpha);
+      final expected =
+          predOriginal * sqrt(alphaPrev) + eps * sqrt(1 - alphaPrev);
+
+      SamplerUtil.ddimStep_(
+        x,
+        eps,
+        alphaCumprod: alpha,
+        alphaCumprodPrev: alphaPrev,
+      );
+      expect(x.allClose(expected, atol: 1e-5), true);
+    });
+
+    test('dpmpp2mStep_', () {
+      final sigmas = [10.0, 6.0, 3.0, 0.0];
+      final denoised = [
+        for (int i = 0; i < 3; i++) Tensor.randn([1, 4, 8, 8]),
+      ];
+      final x = Tensor.randn([1, 4, 8, 8]);
+      var expected = x.clone();
+
+      Tensor? old;
+      for (int i = 0; i < 3; i++) {
+        final t = -log(sigmas[i]);
+        if (sigmas[i + 1] == 0) {
+          expected = denoised[i].clone();
+        } else {
+          final tNext = -log(sigmas[i + 1]);
+          final h = tNext - t;
+          var d = denoised[i];
+          if (old != null) {
+            final r = (t + log(sigmas[i - 1])) / h;
+            d = d * (1 + 1 / (2 * r)) - old * (1 / (2 * r));
+          }
+          expected = expected * (sigmas[i + 1] / sigmas[i]) + d * (1 - exp(-h));
+        }
+        old = denoised[i];
+      }
+
+      final sampler = DPMPP2MSampler(sigmas);
+      for (int i = 0; i < 3; i++) {
+        sampler.step_(x, denoised[i]);
+      }
+      expect(sampler.isDone, true);
+      expect(x.allClose(expected, atol: 1e-4), true);
+    });
+  });
+}
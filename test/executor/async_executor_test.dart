@@ -0,0 +1,90 @@
+import 'package:tensor/tensor.dart';
+import 'package:test/test.dart';
+
+void main() {
+  final context = Context(isTraining: false, device: Device.cpu);
+
+  group('AsyncExecutor', () {
+    late AsyncExecutor executor;
+
+    setUp(() => executor = AsyncExecutor(threads: 2));
+    tearDown(() => executor.close());
+
+    test('runs a tape off the isolate', () async {
+      final conv = Conv2D.make(
+        numInChannels: 4,
+        numOutChannels: 8,
+        padding: const SymmetricPadding2D.same(1),
+      );
+      final x = Tensor.randn([2, 4, 16, 16]);
+      final expected = conv.forward(x, context: context).silu();
+
+      final tape = OpTape();
+      final h = tape.op('aten::conv2d', [
+        x,
+        conv.weight,
+        conv.bias,
+        [1, 1],
+        [1, 1],
+      ]);
+      tape.output(tape.op('aten::silu', [h]));
+      expect(tape.length, 2);
+
+      final request = executor.submit(tape);
+      tape.release();
+      expect(request.progress.total, anyOf(0, 2));
+      final [output] = await request.result;
+      expect(output.allClose(expected, atol: 1e-5), true);
+      expect(request.progress.status, AsyncRequestStatus.finished);
+      expect(executor.pending, 0);
+    });
+
+    test('keeps submission order within a stream', () async {
+      final x = Tensor.zeros([4]);
+      final results = <Future<List<Tensor>>>[];
+      for (int i = 0; i < 8; i++) {
+        final tape = OpTape();
+        tape.output(
+          tape.op('aten::mul_', [
+            tape.op('aten::add_', [x, 1.0], overload: 'Scalar'),
+            2.0,
+          ], overload: 'Scalar'),
+        );
+        results.add(executor.submit(tape, stream: 1).result);
+      }
+      await Future.wait(results);
+      double expected = 0;
+      for (int i = 0; i < 8; i++) {
+        expected = (expected + 1) * 2;
+      }
+      expect(x.allClose(Tensor.full([4], expected)), true);
+    });
+
+    test('reports op errors through the result', () async {
+      final tape = OpTape();
+      tape.output(
+        tape.op('aten::matmul', [
+          Tensor.randn([2, 3]),
+          Tensor.randn([4, 5]),
+        ]),
+      );
+      await expectLater(
+        executor.submit(tape).result,
+        throwsA(isA<Exception>()),
+      );
+    });
+
+    test('rejects unknown operators when recording', () {
+      final tape = OpTape();
+      expect(() => tape.op('aten::does_not_exist', []), throwsException);
+      expect(tape.length, 0);
+    });
+
+    test('run', () async {
+      final a = Tensor.randn([8, 8]);
+      final b = Tensor.randn([8, 8]);
+      final output = await executor.run('aten::mm', [a, b]);
+      expect(output.allClose(a.matmul(b), atol: 1e-5), true);
+    });
+  });
+}
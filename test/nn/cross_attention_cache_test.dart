@@ -0,0 +1,86 @@
+import 'package:tensor/tensor.dart';
+import 'package:test/test.dart';
+
+void main() {
+  final context = Context(isTraining: false, device: Device.cpu);
+
+  group('CrossAttentionKVCache', () {
+    final toKey = LinearLayer.make(inFeatures: 32, outFeatures: 16);
+    final toValue = LinearLayer.make(inFeatures: 32, outFeatures: 16);
+    final owner = Object();
+
+    (Tensor, Tensor) project(Tensor conditioning) =>
+        CrossAttentionKVCache.project(
+          owner,
+          conditioning,
+          toKey: toKey,
+          toValue: toValue,
+          context: context,
+        );
+
+    tearDown(() => context.crossAttentionCache = null);
+
+    test('reuses projections across steps', () {
+      final cache = context.crossAttentionCache = CrossAttentionKVCache();
+      final conditioning = Tensor.randn([2, 7, 32]);
+      final (key, value) = project(conditioning);
+      for (int step = 0; step < 5; step++) {
+        final (k, v) = project(conditioning);
+        expect(identical(k, key), true);
+        expect(identical(v, value), true);
+      }
+      expect(cache.misses, 1);
+      expect(cache.hits, 5);
+      expect(key.allClose(toKey.forward(conditioning, context: context)), true);
+    });
+
+    test('invalidates on new or modified conditioning', () {
+      final cache = context.crossAttentionCache = CrossAttentionKVCache();
+      final conditioning = Tensor.randn([2, 7, 32]);
+      project(conditioning);
+
+      conditioning.normal_();
+      final (key, _) = project(conditioning);
+      expect(cache.misses, 2);
+      expect(key.allClose(toKey.forward(conditioning, context: context)), true);
+
+      final other = Tensor.randn([2, 7, 32]);
+      final (otherKey, _) = project(other);
+      expect(cache.misses, 3);
+      expect(
+        otherKey.allClose(toKey.forward(other, context: context)),
+        true,
+      );
+      expect(cache.length, 1);
+    });
+
+    test('invalidates on modified weights or adapters', () {
+      final cache = context.crossAttentionCache = CrossAttentionKVCache();
+      final conditioning = Tensor.randn([2, 7, 32]);
+      project(conditioning);
+
+      toKey.weight.normal_();
+      var (key, _) = project(conditioning);
+      expect(cache.misses, 2);
+      expect(key.allClose(toKey.forward(conditioning, context: context)), true);
+
+      final adapter = LoRAAdapter(
+        down: Tensor.randn([2, 32]),
+        up: Tensor.randn([16, 2]),
+      );
+      toKey.lora = adapter;
+      (key, _) = project(conditioning);
+      expect(cache.misses, 3);
+      expect(key.allClose(toKey.forward(conditioning, context: context)), true);
+
+      adapter.scale = 0.5;
+      (key, _) = project(conditioning);
+      expect(cache.misses, 4);
+      expect(key.allClose(toKey.forward(conditioning, context: context)), true);
+
+      project(conditioning);
+      expect(cache.hits, 1);
+      toKey.lora = null;
+    });
+  });
+}
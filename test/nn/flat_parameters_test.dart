@@ -0,0 +1,188 @@
+import 'package:tensor/tensor.dart';
+import 'package:test/test.dart';
+
+class _Block extends Module implements SimpleModule {
+  final LinearLayer first;
+  final LinearLayer second;
+
+  _Block({super.name = 'block', required this.first, required this.second});
+
+  @override
+  Tensor forward(Tensor x, {required Context context}) {
+    return context.runForward(this, () {
+      context.onloadModule(this);
+      final hidden = first.forward(x, context: context).relu();
+      return second.forward(hidden, context: context);
+    });
+  }
+
+  @override
+  void resetParameters() {}
+
+  @override
+  Map<String, dynamic> get meta => {};
+
+  @override
+  Iterable<Tensor> get parameters => [];
+
+  @override
+  Iterable<Module> get submodules => [first, second];
+}
+
+void main() {
+  final context = Context(isTraining: false, device: Device.cpu);
+
+  group('FlatParameters', () {
+    test('parameters become views into one buffer', () {
+      final linear = LinearLayer.make(inFeatures: 8, outFeatures: 5);
+      linear.weight.normal_();
+      linear.bias!.normal_();
+      final x = Tensor.randn([3, 8]);
+      final expected = linear.forward(x, context: context);
+      final weight = linear.weight.clone();
+
+      linear.flattenParameters_();
+      expect(linear.flatParameters, hasLength(1));
+      final flat = linear.flatParameters.single;
+      expect(flat.parameters, hasLength(2));
+      expect(linear.weight.dataPointer, flat.flat.dataPointer);
+      expect(linear.weight.allClose(weight), true);
+      expect(linear.forward(x, context: context).allClose(expected), true);
+
+      flat.flat.zeros_();
+      expect(linear.weight.allClose(Tensor.zeros([5, 8])), true);
+      expect(linear.bias!.allClose(Tensor.zeros([5])), true);
+    });
+
+    test('keeps channels-last strides', () {
+      final conv = Conv2D.make(numInChannels: 4, numOutChannels: 8);
+      conv.memoryFormat_(MemoryFormat.channelsLast);
+      final weight = conv.weight.clone();
+      conv.flattenParameters_();
+      expect(
+        conv.weight.isContiguous(memoryFormat: MemoryFormat.channelsLast),
+        true,
+      );
+      expect(conv.weight.allClose(weight), true);
+    });
+
+    test('moves the group at once', () {
+      final linear = LinearLayer.make(inFeatures: 8, outFeatures: 5);
+      linear.weight.normal_();
+      final weight = linear.weight.clone();
+      linear.flattenParameters_();
+      final flat = linear.flatParameters.single;
+
+      flat.to_(dataType: DataType.float64);
+      expect(flat.dataType, DataType.float64);
+      expect(linear.weight.dataType, DataType.float64);
+      expect(linear.bias!.dataType, DataType.float64);
+      expect(linear.weight.dataPointer, flat.flat.dataPointer);
+      expect(
+        linear.weight.allClose(weight.to(dataType: DataType.float64)),
+        true,
+      );
+    });
+
+    test('changing the dtype keeps every value', () {
+      final linear = LinearLayer.make(inFeatures: 8, outFeatures: 5);
+      final weight = linear.weight.clone();
+      final bias = linear.bias!.clone();
+      linear.flattenParameters_();
+      final flat = linear.flatParameters.single;
+
+      flat.to_(dataType: DataType.float64);
+      flat.to_(dataType: DataType.float32);
+      expect(linear.weight.dataType, DataType.float32);
+      expect(linear.weight.shape, [5, 8]);
+      expect(linear.weight.allClose(weight), true);
+      expect(linear.bias!.allClose(bias), true);
+      expect(linear.weight.dataPointer, flat.flat.dataPointer);
+      final x = Tensor.randn([3, 8]);
+      expect(
+        linear
+            .forward(x, context: context)
+            .allClose(NNUtil.linear(x, weight, bias: bias), atol: 1e-5),
+        true,
+      );
+    });
+
+    test('writes through the buffer bump the parameter versions', () {
+      final linear = LinearLayer.make(inFeatures: 8, outFeatures: 5);
+      linear.flattenParameters_();
+      final flat = linear.flatParameters.single;
+
+      final version = linear.weight.version;
+      flat.flat.zeros_();
+      expect(linear.weight.version, greaterThan(version));
+
+      flat.to_(dataType: DataType.float64);
+      final moved = linear.bias!.version;
+      flat.flat.ones_();
+      expect(linear.bias!.version, greaterThan(moved));
+    });
+
+    test('flattening twice is a no-op', () {
+      final linear = LinearLayer.make(inFeatures: 8, outFeatures: 5);
+      linear.flattenParameters_();
+      final flat = linear.flatParameters.single;
+      linear.flattenParameters_();
+      expect(identical(linear.flatParameters.single, flat), true);
+    });
+  });
+  group('Offloader', () {
+    _Block make() => _Block(
+      first: LinearLayer.make(inFeatures: 8, outFeatures: 16, name: 'fc1'),
+      second: LinearLayer.make(inFeatures: 16, outFeatures: 4, name: 'fc2'),
+    );
+
+    test('tracks a flattened subtree as one unit', () {
+      final block = make();
+      final offloader = Offloader();
+      offloader.freeAndLoadModule(block.first, Device.cpu);
+      expect(offloader.modules, {block.first});
+
+      block.flattenParameters_();
+      expect(block.first.offloadUnit, same(block));
+      offloader.freeAndLoadModule(block.second, Device.cpu);
+      expect(offloader.modules, {block});
+
+      offloader.offloadModule(block.first);
+      expect(offloader.modules, isEmpty);
+    });
+
+    final device = Device.best();
+    test(
+      'submodules of an offloaded flattened module load again',
+      () {
+        final block = make();
+        final x = Tensor.randn([2, 8]);
+        final expected = block.forward(
+          x,
+          context: Context(isTraining: false, device: Device.cpu),
+        );
+        final context = Context(
+          isTraining: false,
+          device: device,
+          flattenParameters: true,
+        );
+        block.forward(x, context: context);
+        expect(block.first.weight.device, device);
+
+        context.offloader.offloadModule(block);
+        expect(block.first.weight.device, Device.cpu);
+        expect(block.second.bias!.device, Device.cpu);
+
+        final hidden = block.first.forward(x, context: context);
+        expect(block.first.weight.device, device);
+        expect(block.second.weight.device, device);
+        final output = block.second.forward(hidden.relu(), context: context);
+        expect(
+          output.to(device: Device.cpu).allClose(expected, atol: 1e-5),
+          true,
+        );
+      },
+      skip: device == Device.cpu ? 'Needs an accelerator' : null,
+    );
+  });
+}
@@ -0,0 +1,60 @@
+import 'package:tensor/tensor.dart';
+import 'package:test/test.dart';
+
+void main() {
+  final context = Context(isTraining: false, device: Device.cpu);
+
+  group('LinearLayer.forwardActivated', () {
+    for (final activation in Activation.list) {
+      test(activation.name, () {
+        final linear = LinearLayer.make(inFeatures: 8, outFeatures: 32);
+        final x = Tensor.randn([3, 70, 8]);
+        final expected = activation.forward(
+          linear.forward(x, context: context),
+          context: context,
+        );
+        final out = linear.forwardActivated(x, activation, context: context);
+        expect(out.shape, [3, 70, 32]);
+        expect(out.allClose(expected, atol: 1e-5), true);
+      });
+    }
+  });
+
+  test('GEGLU', () {
+    final geglu = GEGLU.make(inFeatures: 8, outFeatures: 16);
+    final x = Tensor.randn([2, 40, 8]);
+    final projected = geglu.proj.forward(x, context: context);
+    final expected =
+        projected.slice(-1, 0, end: 16) *
+        projected.slice(-1, 16).gelu(GeluApporimate.none);
+    final out = geglu.forward(x, context: context);
+    expect(out.shape, [2, 40, 16]);
+    expect(out.allClose(expected, atol: 1e-5), true);
+  });
+
+  test('GEGLU applies the adapter of its projection', () {
+    final geglu = GEGLU.make(inFeatures: 8, outFeatures: 16);
+    geglu.proj.lora = LoRAAdapter(
+      down: Tensor.randn([2, 8]),
+      up: Tensor.randn([32, 2]),
+      alpha: 2,
+    );
+    final x = Tensor.randn([2, 5, 8]);
+    final projected = geglu.proj.forward(x, context: context);
+    final expected =
+        projected.slice(-1, 0, end: 16) *
+        projected.slice(-1, 16).gelu(GeluApporimate.none);
+    final out = geglu.forward(x, context: context);
+    expect(out.allClose(expected, atol: 1e-4), true);
+  });
+
+  test('fused projection of many rows', () {
+    final linear = LinearLayer.make(inFeatures: 16, outFeatures: 32);
+    final x = Tensor.randn([1100, 16]);
+    final projected = linear.forward(x, context: context);
+    final expected =
+        projected.slice(-1, 0, end: 16) * projected.slice(-1, 16).silu();
+    final out = linear.forwardGated(x, Activation.silu, context: context);
+    expect(out.allClose(expected, atol: 1e-5), true);
+  });
+}
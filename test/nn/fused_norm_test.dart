@@ -0,0 +1,49 @@
+import 'package:tensor/tensor.dart';
+import 'package:test/test.dart';
+
+void main() {
+  final context = Context(isTraining: false, device: Device.cpu);
+
+  group('forwardAddResidual_', () {
+    test('LayerNorm', () {
+      final norm = LayerNorm.make(name: 'norm', normalizedShape: [16]);
+      norm.weight!.normal_();
+      norm.bias!.normal_();
+      final x = Tensor.randn([2, 5, 16]);
+      final residual = Tensor.randn([2, 5, 16]);
+      final sum = x + residual;
+      final expected = norm.forward(sum, context: context);
+
+      final out = norm.forwardAddResidual_(x, residual, context: context);
+      expect(x.allClose(sum), true);
+      expect(out.allClose(expected, atol: 1e-5), true);
+    });
+
+    test('RMSNorm', () {
+      final norm = RMSNorm.make(normalizedShape: [16], eps: 1e-6);
+      norm.weight!.normal_();
+      final x = Tensor.randn([3, 16]);
+      final residual = Tensor.randn([3, 16]);
+      final sum = x + residual;
+      final expected = norm.forward(sum, context: context);
+
+      final out = norm.forwardAddResidual_(x, residual, context: context);
+      expect(x.allClose(sum), true);
+      expect(out.allClose(expected, atol: 1e-5), true);
+    });
+
+    test('RMSNormWithBias', () {
+      final norm = RMSNormWithBias.make(normalizedShape: [16]);
+      norm.weight!.normal_();
+      norm.bias!.normal_();
+      final x = Tensor.randn([4, 16]);
+      final residual = Tensor.randn([4, 16]);
+      final sum = x + residual;
+      final expected = norm.forward(sum, context: context);
+
+      final out = norm.forwardAddResidual_(x, residual, context: context);
+      expect(x.allClose(sum), true);
+      expect(out.allClose(expected, atol: 1e-5), true);
+    });
+  });
+}
@@ -0,0 +1,96 @@
+import 'package:tensor/tensor.dart';
+import 'package:test/test.dart';
+
+void main() {
+  group('KVCache', () {
+    test('update appends and truncate rolls back', () {
+      final cache = KVCache.make(numLayers: 2, shape: [1, 2, 4, 3]);
+      expect(cache.length, 0);
+
+      final (keys, values) = cache.update(
+        0,
+        Tensor.ones([1, 2, 3, 3]),
+        Tensor.zeros([1, 2, 3, 3]),
+      );
+      expect(keys.shape, [1, 2, 3, 3]);
+      expect(values.shape, [1, 2, 3, 3]);
+      expect(cache.lengthOf(0), 3);
+      expect(cache.lengthOf(1), 0);
+
+      cache.truncate(1);
+      expect(cache.lengthOf(0), 1);
+      expect(cache.capacityOf(0), 4);
+
+      // Grows past the preallocated capacity
+      final (grownKeys, _) = cache.update(
+        0,
+        Tensor.ones([1, 2, 5, 3]) * 2.0,
+        Tensor.ones([1, 2, 5, 3]),
+      );
+      expect(grownKeys.shape, [1, 2, 6, 3]);
+      expect(cache.capacityOf(0) >= 6, true);
+      expect(grownKeys.at([0, 0, 0, 0]).scalar, 1.0);
+      expect(grownKeys.at([0, 0, 1, 0]).scalar, 2.0);
+    });
+
+    test('rejects bad layers and mismatched entries', () {
+      final cache = KVCache.make(numLayers: 2, shape: [1, 2, 4, 3]);
+      expect(() => cache.lengthOf(2), throwsException);
+      expect(() => cache.capacityOf(-1), throwsException);
+      void update(int layer, List<int> key, List<int> value) =>
+          cache.update(layer, Tensor.ones(key), Tensor.ones(value));
+      expect(() => update(2, [1, 2, 1, 3], [1, 2, 1, 3]), throwsException);
+      expect(() => update(0, [1, 2, 1, 5], [1, 2, 1, 3]), throwsException);
+      expect(() => update(0, [1, 2, 2, 3], [1, 2, 1, 3]), throwsException);
+      expect(() => update(0, [2, 1, 3], [2, 1, 3]), throwsException);
+      expect(cache.lengthOf(0), 0);
+    });
+  });
+
+  group('SpeculativeDecoder.verify', () {
+    test('accepts all tokens when draft matches target', () {
+      final probs = Tensor.from(
+        [0.0, 1.0, 0.0, 0.0, 0.0, 1.0, 1.0, 0.0, 0.0],
+        [3, 3],
+        datatype: DataType.float32,
+      );
+      final (accepted, next) = SpeculativeDecoder.verify(
+        probs.slice(0, 0, end: 2),
+        probs,
+        Tensor.from([1, 2], [2], datatype: DataType.int64),
+      );
+      expect(accepted, 2);
+      expect(next, 0);
+    });
+
+    test('greedy rejects at first mismatch', () {
+      final target = Tensor.from(
+        [0.0, 1.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0],
+        [3, 3],
+        datatype: DataType.float32,
+      );
+      final (accepted, next) = SpeculativeDecoder.verify(
+        Tensor.zeros([2, 3]),
+        target,
+        Tensor.from([1, 2], [2], datatype: DataType.int64),
+        greedy: true,
+      );
+      expect(accepted, 1);
+      expect(next, 0);
+    });
+  });
+
+  test('effective speedup is measured against a single-token step', () {
+    final stats = SpeculativeDecodingStats()
+      ..generated = 10
+      ..targetForwards = 4
+      ..draftForwards = 16
+      ..targetTime = const Duration(milliseconds: 40)
+      ..draftTime = const Duration(milliseconds: 10);
+    expect(stats.effectiveSpeedup, null);
+    expect(stats.toJson().containsKey('effectiveSpeedup'), false);
+
+    stats.targetStepTime = const Duration(milliseconds: 8);
+    expect(stats.effectiveSpeedup, closeTo(10 * 8 / 50, 1e-9));
+  });
+}
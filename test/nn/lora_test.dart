@@ -0,0 +1,122 @@
+import 'package:tensor/tensor.dart';
+import 'package:test/test.dart';
+
+void main() {
+  final context = Context(isTraining: false, device: Device.cpu);
+
+  LoRAAdapter adapter(int inFeatures, int outFeatures, int rank, double alpha) {
+    return LoRAAdapter(
+      down: Tensor.randn([rank, inFeatures]),
+      up: Tensor.randn([outFeatures, rank]),
+      alpha: alpha,
+    );
+  }
+
+  Tensor merged(LinearLayer linear, LoRAAdapter lora) =>
+      linear.weight + lora.up.matmul(lora.down) * lora.scale;
+
+  group('LoRA', () {
+    test('LinearLayer with one adapter', () {
+      final linear = LinearLayer.make(inFeatures: 16, outFeatures: 12);
+      final lora = adapter(16, 12, 4, 8);
+      final x = Tensor.randn([2, 5, 16]);
+      final expected = NNUtil.linear(
+        x,
+        merged(linear, lora),
+        bias: linear.bias,
+      );
+
+      linear.lora = lora;
+      expect(linear.forward(x, context: context).allClose(expected, atol: 1e-4),
+          true);
+
+      linear.lora = null;
+      final base = NNUtil.linear(x, linear.weight, bias: linear.bias);
+      expect(linear.forward(x, context: context).allClose(base, atol: 1e-5),
+          true);
+    });
+
+    test('LinearLayer with per-row adapters', () {
+      final linear = LinearLayer.make(inFeatures: 16, outFeatures: 12);
+      final adapters = [adapter(16, 12, 4, 4), adapter(16, 12, 2, 1)];
+      linear.loraBank = LoRAAdapterBank.stack(adapters);
+      final x = Tensor.randn([3, 5, 16]);
+      final local = Context(isTraining: false, device: Device.cpu)
+        ..loraIndices = Tensor.from([1, -1, 0], [3], datatype: DataType.int64);
+
+      final out = linear.forward(x, context: local);
+      final rows = [
+        NNUtil.linear(x[0], merged(linear, adapters[1]), bias: linear.bias),
+        NNUtil.linear(x[1], linear.weight, bias: linear.bias),
+        NNUtil.linear(x[2], merged(linear, adapters[0]), bias: linear.bias),
+      ];
+      for (int i = 0; i < 3; i++) {
+        expect(out[i].allClose(rows[i], atol: 1e-4), true);
+      }
+    });
+
+    test('Conv2D', () {
+      final conv = Conv2D.make(
+        numInChannels: 4,
+        numOutChannels: 6,
+        padding: const SymmetricPadding2D.same(1),
+      );
+      final lora = LoRAAdapter(
+        down: Tensor.randn([2, 4, 3, 3]),
+        up: Tensor.randn([6, 2, 1, 1]),
+        alpha: 1,
+      );
+      final weight =
+          conv.weight +
+          lora.up
+                  .view([6, 2])
+                  .matmul(lora.down.view([2, 36]))
+                  .view([6, 4, 3, 3]) *
+              lora.scale;
+      final x = Tensor.randn([1, 4, 8, 8]);
+      final expected = NN2DUtil.conv2d(
+        x,
+        weight,
+        bias: conv.bias,
+        padding: const SymmetricPadding2D.same(1),
+      );
+
+      conv.lora = lora;
+      expect(conv.forward(x, context: context).allClose(expected, atol: 1e-4),
+          true);
+    });
+
+    test('grouped Conv2D rejects an adapter', () {
+      final conv = Conv2D.make(
+        numInChannels: 4,
+        numOutChannels: 4,
+        groups: 2,
+        padding: const SymmetricPadding2D.same(1),
+      );
+      expect(
+        () => conv.lora = LoRAAdapter(
+          down: Tensor.randn([2, 4, 3, 3]),
+          up: Tensor.randn([4, 2, 1, 1]),
+        ),
+        throwsArgumentError,
+      );
+      expect(conv.lora, null);
+    });
+
+    final device = Device.best();
+    test(
+      'LinearLayer moves its adapters',
+      () {
+        final linear = LinearLayer.make(inFeatures: 16, outFeatures: 12)
+          ..lora = adapter(16, 12, 4, 4)
+          ..loraBank = LoRAAdapterBank.stack([adapter(16, 12, 2, 1)]);
+        linear.to_(device);
+        expect(linear.lora!.device, device);
+        expect(linear.loraBank!.down.device, device);
+        expect(linear.loraBank!.up.device, device);
+        expect(linear.loraBank!.scales.device, device);
+      },
+      skip: device == Device.cpu ? 'Needs an accelerator' : null,
+    );
+  });
+}
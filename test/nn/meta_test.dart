@@ -0,0 +1,110 @@
+import 'package:tensor/tensor.dart';
+import 'package:test/test.dart';
+
+class _MapLoader extends SafeTensorLoader {
+  final Map<String, Tensor> tensors;
+
+  _MapLoader(this.tensors);
+
+  @override
+  SafeTensorHeader get header => throw UnimplementedError();
+
+  @override
+  bool hasTensor(String name) => tensors.containsKey(name);
+
+  @override
+  Tensor loadByName(String name, {Device device = Device.cpu}) =>
+      tensors[name]!.to(device: device);
+
+  @override
+  Tensor? tryLoadByName(String name, {Device device = Device.cpu}) =>
+      tensors[name]?.to(device: device);
+}
+
+void main() {
+  final context = Context(isTraining: false, device: Device.cpu);
+
+  group('meta device', () {
+    test('make creates shape-only parameters', () {
+      final linear = LinearLayer.make(
+        inFeatures: 8,
+        outFeatures: 4,
+        device: Device.meta,
+      );
+      expect(linear.weight.device, Device.meta);
+      expect(linear.weight.shape, [4, 8]);
+      expect(linear.isMeta, true);
+    });
+
+    test('materializeFromSafeTensor_', () async {
+      final conv = Conv2D.make(
+        numInChannels: 3,
+        numOutChannels: 6,
+        device: Device.meta,
+      );
+      final norm = GroupNorm.make(
+        numGroups: 2,
+        numChannels: 6,
+        device: Device.meta,
+      );
+      final weight = Tensor.randn([6, 3, 3, 3]);
+      final bias = Tensor.randn([6]);
+      final loader = _MapLoader({
+        'conv.weight': weight,
+        'conv.bias': bias,
+        'norm.weight': Tensor.ones([6]),
+        'norm.bias': Tensor.zeros([6]),
+      });
+
+      final weightHandle = conv.weight;
+      await conv.materializeFromSafeTensor_(loader, prefix: 'conv.');
+      await norm.materializeFromSafeTensor_(loader, prefix: 'norm.');
+      expect(conv.isMeta, false);
+      expect(norm.isMeta, false);
+      expect(identical(conv.weight, weightHandle), true);
+      expect(conv.weight.device, Device.cpu);
+      expect(conv.weight.allClose(weight), true);
+      expect(conv.weight.dataPointer == weight.dataPointer, false);
+
+      final x = Tensor.randn([1, 3, 8, 8]);
+      final expected = NN2DUtil.conv2d(x, weight, bias: bias);
+      expect(conv.forward(x, context: context).allClose(expected), true);
+    });
+
+    test('materializeFromSafeTensor_ converts the data type', () async {
+      final linear = LinearLayer.make(
+        inFeatures: 8,
+        outFeatures: 4,
+        device: Device.meta,
+      );
+      final weight = Tensor.randn([4, 8]);
+      final loader = _MapLoader({'weight': weight, 'bias': Tensor.randn([4])});
+      await linear.materializeFromSafeTensor_(
+        loader,
+        dataType: DataType.float64,
+      );
+      expect(linear.weight.dataType, DataType.float64);
+      expect(linear.weight.device, Device.cpu);
+      expect(
+        linear.weight.allClose(weight.to(dataType: DataType.float64)),
+        true,
+      );
+    });
+
+    test('materializeFromSafeTensor_ checks shapes', () async {
+      final linear = LinearLayer.make(
+        inFeatures: 8,
+        outFeatures: 4,
+        device: Device.meta,
+      );
+      final loader = _MapLoader({
+        'weight': Tensor.randn([4, 7]),
+        'bias': Tensor.randn([4]),
+      });
+      await expectLater(
+        linear.materializeFromSafeTensor_(loader),
+        throwsException,
+      );
+    });
+  });
+}
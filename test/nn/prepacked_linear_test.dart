@@ -0,0 +1,51 @@
+import 'package:tensor/tensor.dart';
+import 'package:test/test.dart';
+
+void main() {
+  final context = Context(isTraining: false, device: Device.cpu);
+
+  group('PackedLinear', () {
+    test('matches unpacked linear for decode shapes', () {
+      final linear = LinearLayer.make(inFeatures: 64, outFeatures: 96);
+      for (final batch in [1, 4, 16]) {
+        final x = Tensor.randn([batch, 1, 64]);
+        linear.usePrepacked = false;
+        final expected = linear.forward(x, context: context);
+        linear.usePrepacked = true;
+        final output = linear.forward(x, context: context);
+        expect(output.shape, [batch, 1, 96]);
+        expect(output.allClose(expected, atol: 1e-5), true);
+      }
+    });
+
+    test('repacks after the weight is reset', () {
+      final linear = LinearLayer.make(inFeatures: 8, outFeatures: 8)
+        ..usePrepacked = true;
+      final x = Tensor.randn([2, 8]);
+      linear.forward(x, context: context);
+      linear.resetParameters();
+      final expected = NNUtil.linear(x, linear.weight, bias: linear.bias);
+      final output = linear.forward(x, context: context);
+      expect(output.allClose(expected, atol: 1e-5), true);
+    });
+
+    test('repacks after in-place edits', () {
+      final linear = LinearLayer.make(inFeatures: 8, outFeatures: 8)
+        ..usePrepacked = true;
+      final x = Tensor.randn([2, 8]);
+      linear.forward(x, context: context);
+
+      Tensor expected() => NNUtil.linear(x, linear.weight, bias: linear.bias);
+      linear.weight.normal_();
+      expect(
+        linear.forward(x, context: context).allClose(expected(), atol: 1e-5),
+        true,
+      );
+      linear.bias!.copy_(linear.bias! + 1);
+      expect(
+        linear.forward(x, context: context).allClose(expected(), atol: 1e-5),
+        true,
+      );
+    });
+  });
+}
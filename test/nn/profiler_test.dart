@@ -0,0 +1,121 @@
+import 'dart:convert';
+
+import 'package:tensor/tensor.dart';
+import 'package:test/test.dart';
+
+class _Block extends Module implements SimpleModule {
+  final LinearLayer first;
+  final LinearLayer second;
+
+  _Block({super.name = 'block', required this.first, required this.second});
+
+  @override
+  Tensor forward(Tensor x, {required Context context}) {
+    return context.runForward(this, () {
+      final hidden = first.forward(x, context: context).relu();
+      return second.forward(hidden, context: context);
+    });
+  }
+
+  @override
+  void resetParameters() {}
+
+  @override
+  Map<String, dynamic> get meta => {};
+
+  @override
+  Iterable<Tensor> get parameters => [];
+
+  @override
+  Iterable<Module> get submodules => [first, second];
+}
+
+void main() {
+  group('ModuleProfiler', () {
+    _Block make() => _Block(
+      first: LinearLayer.make(inFeatures: 32, outFeatures: 64, name: 'fc1'),
+      second: LinearLayer.make(inFeatures: 64, outFeatures: 16, name: 'fc2'),
+    );
+
+    test('builds a tree keyed by state dict names', () {
+      final context = Context(isTraining: false, device: Device.cpu);
+      final block = make();
+      final profiler = ModuleProfiler(model: block)..attach(context);
+      for (int i = 0; i < 3; i++) {
+        block.forward(Tensor.randn([8, 32]), context: context);
+      }
+      profiler.detach(context);
+
+      final node = profiler.root.children['block']!;
+      expect(node.calls, 3);
+      expect(node.children.keys, ['fc1', 'fc2']);
+      final fc1 = node.children['fc1']!;
+      expect(fc1.path, 'block.fc1');
+      expect(fc1.calls, 3);
+      expect(fc1.outputShapes, [
+        [8, 64],
+      ]);
+      expect(node.outputShapes, [
+        [8, 16],
+      ]);
+      expect(node.totalNs, greaterThanOrEqualTo(fc1.totalNs));
+      expect(fc1.peakBytes, greaterThanOrEqualTo(8 * 64 * 4));
+
+      final json = jsonDecode(profiler.toJson()) as List;
+      expect(json.single['name'], 'block');
+      expect((json.single['children'] as List).first['name'], 'block.fc1');
+      final folded = const LineSplitter().convert(profiler.toFoldedStacks());
+      for (final line in folded) {
+        expect(line, matches(r'^block(;fc[12])? \d+$'));
+      }
+      profiler.dispose();
+    });
+
+    test('names modules without a model by nesting', () {
+      final context = Context(isTraining: false, device: Device.cpu);
+      final block = make();
+      final profiler = ModuleProfiler()..attach(context);
+      block.forward(Tensor.randn([2, 32]), context: context);
+      profiler.detach(context);
+      expect(profiler.root.children['block']!.children.keys, ['fc1', 'fc2']);
+      profiler.dispose();
+    });
+
+    test('keeps tracking memory for profilers still attached', () {
+      final first = Context(isTraining: false, device: Device.cpu);
+      final second = Context(isTraining: false, device: Device.cpu);
+      final block = make();
+      final a = ModuleProfiler(model: block)..attach(first);
+      final b = ModuleProfiler(model: block)..attach(second);
+      a.detach(first);
+      a.detach(first);
+      block.forward(Tensor.randn([8, 32]), context: second);
+      b.detach(second);
+      final fc1 = b.root.children['block']!.children['fc1']!;
+      expect(fc1.peakBytes, greaterThanOrEqualTo(8 * 64 * 4));
+      a.dispose();
+      b.dispose();
+    });
+
+    test('synchronizes around modules', () {
+      final context = Context.best();
+      final block = make()..to_(context.device, cascade: true);
+      final profiler = ModuleProfiler(model: block, synchronize: true)
+        ..attach(context);
+      block.forward(
+        Tensor.randn([8, 32], device: context.device),
+        context: context,
+      );
+      profiler.detach(context);
+      expect(profiler.root.children['block']!.calls, 1);
+      profiler.dispose();
+    });
+
+    test('does nothing without hooks', () {
+      final context = Context(isTraining: false, device: Device.cpu);
+      final output = make().forward(Tensor.randn([2, 32]), context: context);
+      expect(output.shape, [2, 16]);
+      expect(context.forwardHooks, isEmpty);
+    });
+  });
+}
@@ -0,0 +1,52 @@
+import 'dart:math';
+
+import 'package:tensor/tensor.dart';
+import 'package:test/test.dart';
+
+Tensor _reference(Tensor x, int offset, {double base = 10000}) {
+  final seqLength = x.shape[2];
+  final dim = x.shape[3];
+  final half = dim ~/ 2;
+  final invFreq = Tensor.from(
+    List.generate(half, (i) => 1 / pow(base, 2 * i / dim)),
+    [1, half],
+    datatype: DataType.float32,
+  );
+  final positions = Tensor.arange(
+    offset,
+    offset + seqLength,
+    datatype: DataType.float32,
+  ).view([seqLength, 1]);
+  final angles = positions * invFreq;
+  final cos = angles.cos();
+  final sin = angles.sin();
+  final x1 = x.slice(-1, 0, end: half);
+  final x2 = x.slice(-1, half);
+  return Tensor.cat([x1 * cos - x2 * sin, x2 * cos + x1 * sin], dim: -1);
+}
+
+void main() {
+  group('RotaryEmbedding', () {
+    test('matches reference with position offset', () {
+      final query = Tensor.randn([2, 3, 5, 16]);
+      final key = Tensor.randn([2, 3, 5, 16]);
+      final expectedQuery = _reference(query, 7);
+      final expectedKey = _reference(key, 7);
+
+      final rope = RotaryEmbedding(rotaryDim: 16);
+      rope.forward_(query, key, positionOffset: 7, context: Context.best());
+      expect(query.allClose(expectedQuery, atol: 1e-5), true);
+      expect(key.allClose(expectedKey, atol: 1e-5), true);
+    });
+
+    test('partial rotary dim leaves the tail untouched', () {
+      final query = Tensor.randn([1, 2, 4, 12]);
+      final tail = query.slice(-1, 8).clone();
+      final expected = _reference(query.slice(-1, 0, end: 8), 0);
+
+      RotaryEmbedding.apply_(query, null, rotaryDim: 8);
+      expect(query.slice(-1, 0, end: 8).allClose(expected, atol: 1e-5), true);
+      expect(query.slice(-1, 8).allClose(tail), true);
+    });
+  });
+}
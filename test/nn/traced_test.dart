@@ -0,0 +1,112 @@
+import 'package:tensor/tensor.dart';
+import 'package:test/test.dart';
+
+class _Block extends Module implements SimpleModule {
+  final LinearLayer first;
+  final LinearLayer second;
+
+  _Block({super.name = 'block', required this.first, required this.second});
+
+  @override
+  Tensor forward(Tensor x, {required Context context}) {
+    return context.runForward(this, () {
+      final hidden = first.forward(x, context: context).relu();
+      return second.forward(hidden, context: context);
+    });
+  }
+
+  @override
+  void resetParameters() {}
+
+  @override
+  Map<String, dynamic> get meta => {};
+
+  @override
+  Iterable<Tensor> get parameters => [];
+
+  @override
+  Iterable<Module> get submodules => [first, second];
+}
+
+void main() {
+  final context = Context(isTraining: false, device: Device.cpu);
+
+  _Block make() => _Block(
+    first: LinearLayer.make(inFeatures: 32, outFeatures: 64, name: 'fc1'),
+    second: LinearLayer.make(inFeatures: 64, outFeatures: 16, name: 'fc2'),
+  );
+
+  group('TracedForward', () {
+    test('replays the frozen graph', () {
+      final block = make();
+      final traced = TracedForward.module(block, context: context);
+      final x = Tensor.randn([4, 32]);
+      final expected = block.forward(x, context: context);
+
+      expect(traced([x]).allClose(expected, atol: 1e-5), true);
+      expect(traced.traces, 1);
+
+      final y = Tensor.randn([4, 32]);
+      expect(
+        traced([y]).allClose(block.forward(y, context: context), atol: 1e-5),
+        true,
+      );
+      expect(traced.replays, 1);
+      expect(traced.graphs.values.single.dump(), contains('aten::'));
+      traced.clear();
+    });
+
+    test('caches one graph per input signature', () {
+      final block = make();
+      final traced = TracedForward.module(
+        block,
+        context: context,
+        maxGraphs: 2,
+      );
+      for (final rows in [1, 2, 1, 3, 2]) {
+        final x = Tensor.randn([rows, 32]);
+        final output = traced([x]);
+        expect(output.sizes, [rows, 16]);
+        expect(
+          output.allClose(block.forward(x, context: context), atol: 1e-5),
+          true,
+        );
+      }
+      expect(traced.graphs.length, 2);
+      expect(traced.traces, 2);
+      expect(traced.replays, 2);
+      expect(traced.eagerRuns, 1);
+      traced.clear();
+    });
+
+    test('records fused kernels through their ATen path', () {
+      final rope = RotaryEmbedding(rotaryDim: 8);
+      final norm = RMSNorm.make(normalizedShape: [8]);
+      Tensor forward(List<Tensor> inputs) {
+        final hidden = inputs[0].clone();
+        rope.forward_(hidden, null, context: context);
+        return norm.forwardAddResidual_(hidden, inputs[1], context: context);
+      }
+
+      final traced = TracedForward(forward);
+      traced([Tensor.randn([1, 4, 8]), Tensor.randn([1, 4, 8])]);
+      expect(traced.traces, 1);
+
+      final x = Tensor.randn([1, 4, 8]);
+      final residual = Tensor.randn([1, 4, 8]);
+      final expected = forward([x, residual.clone()]);
+      final output = traced([x, residual]);
+      expect(traced.replays, 1);
+      expect(output.allClose(expected, atol: 1e-5), true);
+      traced.clear();
+    });
+
+    test('rethrows errors of the traced forward', () {
+      final x = Tensor.randn([2, 2]);
+      expect(
+        () => TracedGraph.trace([x], () => throw StateError('forward')),
+        throwsStateError,
+      );
+    });
+  });
+}
@@ -0,0 +1,40 @@
+import 'package:tensor/tensor.dart';
+import 'package:test/test.dart';
+
+void main() {
+  group('Context.preferredMemoryFormat', () {
+    test('conv stack stays channels-last', () {
+      final context = Context(
+        isTraining: false,
+        device: Device.cpu,
+        preferredMemoryFormat: MemoryFormat.channelsLast,
+      );
+      final conv = Conv2D.make(
+        numInChannels: 8,
+        numOutChannels: 16,
+        padding: SymmetricPadding2D.same(1),
+      );
+      final norm = GroupNorm.make(numGroups: 4, numChannels: 16);
+      final input = Tensor.randn([1, 8, 12, 12]);
+      final nchw = Context(isTraining: false, device: Device.cpu);
+      final expected = norm.forward(
+        conv.forward(input, context: nchw),
+        context: nchw,
+      );
+
+      final output = norm.forward(
+        conv.forward(input, context: context),
+        context: context,
+      );
+      expect(
+        conv.weight.isContiguous(memoryFormat: MemoryFormat.channelsLast),
+        true,
+      );
+      expect(
+        output.isContiguous(memoryFormat: MemoryFormat.channelsLast),
+        true,
+      );
+      expect(output.allClose(expected, atol: 1e-4), true);
+    });
+  });
+}
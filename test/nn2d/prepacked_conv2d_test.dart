@@ -0,0 +1,85 @@
+import 'package:tensor/tensor.dart';
+import 'package:test/test.dart';
+
+void main() {
+  final context = Context(isTraining: false, device: Device.cpu);
+
+  group('PackedConv2D', () {
+    test('matches unpacked conv2d across input shapes', () {
+      final conv = Conv2D.make(
+        numInChannels: 16,
+        numOutChannels: 32,
+        padding: SymmetricPadding2D.same(1),
+      );
+      for (final size in [8, 8, 13]) {
+        final input = Tensor.randn([2, 16, size, size]);
+        conv.usePrepacked = false;
+        final expected = conv.forward(input, context: context);
+        conv.usePrepacked = true;
+        final output = conv.forward(input, context: context);
+        expect(output.allClose(expected, atol: 1e-4), true);
+      }
+    });
+
+    test('pack is reused for the same shape and dropped on weight change', () {
+      final conv = Conv2D.make(
+        numInChannels: 8,
+        numOutChannels: 8,
+        padding: SymmetricPadding2D.same(1),
+      );
+      final input = Tensor.randn([1, 8, 10, 10]);
+      final packed = PackedConv2D.pack(
+        conv.weight,
+        bias: conv.bias,
+        inputShape: input.shape,
+        padding: SymmetricPadding2D.same(1),
+      );
+      expect(packed.matches(input, conv.weight, conv.bias), true);
+      expect(
+        packed.matches(Tensor.randn([1, 8, 12, 12]), conv.weight, conv.bias),
+        false,
+      );
+
+      conv.memoryFormat_(MemoryFormat.channelsLast);
+      expect(packed.matches(input, conv.weight, conv.bias), false);
+      packed.release();
+    });
+
+    test('repacks after in-place edits', () {
+      final conv = Conv2D.make(
+        numInChannels: 8,
+        numOutChannels: 8,
+        padding: SymmetricPadding2D.same(1),
+      )..usePrepacked = true;
+      final input = Tensor.randn([1, 8, 10, 10]);
+      conv.forward(input, context: context);
+
+      Tensor expected() => NN2DUtil.conv2d(
+        input,
+        conv.weight,
+        bias: conv.bias,
+        padding: SymmetricPadding2D.same(1),
+      );
+      conv.weight.normal_();
+      expect(conv.forward(input, context: context).allClose(expected(),
+          atol: 1e-4), true);
+      conv.bias!.copy_(conv.bias! + 1);
+      expect(conv.forward(input, context: context).allClose(expected(),
+          atol: 1e-4), true);
+    });
+
+    test('keeps a channels-last input in channels-last', () {
+      final conv = Conv2D.make(
+        numInChannels: 8,
+        numOutChannels: 16,
+        padding: SymmetricPadding2D.same(1),
+      )..usePrepacked = true;
+      final input = Tensor.randn(
+        [1, 8, 10, 10],
+      ).contiguous(format: MemoryFormat.channelsLast);
+      final output = conv.forward(input, context: context);
+      expect(output.isContiguous(memoryFormat: MemoryFormat.channelsLast),
+          true);
+    });
+  });
+}
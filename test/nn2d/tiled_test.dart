@@ -0,0 +1,139 @@
+import 'package:tensor/tensor.dart';
+import 'package:test/test.dart';
+
+void main() {
+  final context = Context(isTraining: false, device: Device.cpu);
+
+  group('TiledExecutor', () {
+    test('matches the untiled conv stack', () {
+      final convIn = Conv2D.make(
+        numInChannels: 4,
+        numOutChannels: 32,
+        padding: SymmetricPadding2D.same(1),
+      );
+      final norm1 = GroupNorm.make(numGroups: 8, numChannels: 32);
+      final conv = Conv2D.make(
+        numInChannels: 32,
+        numOutChannels: 32,
+        padding: SymmetricPadding2D.same(1),
+      );
+      final norm2 = GroupNorm.make(numGroups: 8, numChannels: 32);
+      final upsample = Upsample2D.make(channels: 32, useConv: true);
+      final convOut = Conv2D.make(
+        numInChannels: 32,
+        numOutChannels: 3,
+        padding: SymmetricPadding2D.same(1),
+      );
+
+      Tensor forward(Tensor x, Context context) {
+        x = convIn.forward(x, context: context);
+        x = norm1.forward(x, context: context).silu();
+        x = conv.forward(x, context: context);
+        x = norm2.forward(x, context: context).silu();
+        x = upsample.forward(x, context: context);
+        return convOut.forward(x, context: context);
+      }
+
+      final input = Tensor.randn([1, 4, 48, 40]);
+      final expected = forward(input, context);
+
+      final tiled = TiledExecutor(tileSize: 24, overlap: 12, statsPasses: 2);
+      final output = tiled.run(input, forward, context: context);
+      expect(output.shape, [1, 3, 96, 80]);
+      expect(output.allClose(expected, atol: 1e-4), true);
+      expect(context.groupNormTiling, null);
+    });
+
+    test('matches the untiled output of a deep norm stack', () {
+      const depth = 12;
+      final convIn = Conv2D.make(
+        numInChannels: 4,
+        numOutChannels: 16,
+        padding: SymmetricPadding2D.same(1),
+      );
+      final norms = [
+        for (int i = 0; i < depth; i++)
+          GroupNorm.make(numGroups: 4, numChannels: 16),
+      ];
+      final convs = [
+        for (int i = 0; i < depth; i++)
+          Conv2D.make(
+            numInChannels: 16,
+            numOutChannels: 16,
+            padding: SymmetricPadding2D.same(1),
+          ),
+      ];
+
+      // The 13 convs see 13 pixels around each output pixel, which the
+      // 16 pixels between a core boundary and the tile edge, less half the
+      // blend, cover.
+      Tensor forward(Tensor x, Context context) {
+        x = convIn.forward(x, context: context);
+        for (int i = 0; i < depth; i++) {
+          final h = norms[i].forward(x, context: context).silu();
+          x = x + convs[i].forward(h, context: context);
+        }
+        return x;
+      }
+
+      final input = Tensor.randn([1, 4, 96, 80]);
+      final expected = forward(input, context);
+
+      final tiled = TiledExecutor(
+        tileSize: 56,
+        overlap: 32,
+        blendWidth: 4,
+        statsPasses: depth,
+      );
+      final output = tiled.run(input, forward, context: context);
+      expect(output.allClose(expected, atol: 1e-3), true);
+    });
+
+    test('bounds the passes and runs every tile to completion', () {
+      final norms = [
+        for (int i = 0; i < 3; i++)
+          GroupNorm.make(numGroups: 2, numChannels: 4),
+      ];
+      int forwards = 0;
+      Tensor forward(Tensor x, Context context) {
+        forwards++;
+        for (final norm in norms) {
+          x = norm.forward(x, context: context);
+        }
+        return x;
+      }
+
+      final hook = _OutputRecorder();
+      final hooked = Context(isTraining: false, device: Device.cpu)
+        ..forwardHooks.add(hook);
+      final input = Tensor.randn([1, 4, 32, 32]);
+      // 4 tiles, one collecting pass and the final one.
+      TiledExecutor(tileSize: 20, overlap: 8).run(
+        input,
+        forward,
+        context: hooked,
+      );
+      expect(forwards, 8);
+      expect(hook.outputs, isNot(contains(null)));
+
+      // Passing stops once all three norms are exact.
+      forwards = 0;
+      TiledExecutor(tileSize: 20, overlap: 8, statsPasses: 10).run(
+        input,
+        forward,
+        context: context,
+      );
+      expect(forwards, 16);
+    });
+  });
+}
+
+class _OutputRecorder implements ForwardHook {
+  final List<Object?> outputs = [];
+
+  @override
+  void before(Module module) {}
+
+  @override
+  void after(Module module, Object? output) => outputs.add(output);
+}
@@ -0,0 +1,158 @@
+import 'dart:io';
+
+import 'package:tensor/tensor.dart';
+import 'package:test/test.dart';
+
+class _MapLoader extends SafeTensorLoader {
+  final Map<String, Tensor> tensors;
+
+  @override
+  final SafeTensorHeader header;
+
+  _MapLoader(this.tensors)
+    : header = SafeTensorHeader(
+        metadata: {},
+        dataOffset: 0,
+        tensorInfos: tensors.map(
+          (name, t) => MapEntry(
+            name,
+            SafeTensorInfo(
+              dtype: t.dataType.safetensorName!,
+              shape: t.shape,
+              startOffset: 0,
+              endOffset: t.memorySize,
+            ),
+          ),
+        ),
+      );
+
+  @override
+  Tensor loadByName(String name, {Device device = Device.cpu}) {
+    return tensors[name]!;
+  }
+
+  @override
+  Tensor? tryLoadByName(String name, {Device device = Device.cpu}) =>
+      tensors[name];
+}
+
+void main() {
+  group('TensorDedupCache', () {
+    late Directory dir;
+
+    setUp(() => dir = Directory.systemTemp.createTempSync('dedup'));
+    tearDown(() => dir.deleteSync(recursive: true));
+
+    Future<DedupSafeTensorLoader> open(
+      String file,
+      _MapLoader base,
+      TensorDedupCache cache,
+    ) async {
+      final path = '${dir.path}/$file';
+      File(path).writeAsStringSync(file);
+      final hashes = await SafeTensorHashes.load(path);
+      return DedupSafeTensorLoader(base, hashes, cache: cache);
+    }
+
+    test('content hash', () {
+      final a = Tensor.randn([4, 5]);
+      expect(a.clone().contentHash, a.contentHash);
+      final strided = a.transpose(0, 1).contiguous().transpose(0, 1);
+      expect(strided.contentHash, a.contentHash);
+      expect(a.view([5, 4]).contentHash == a.contentHash, false);
+      expect((a + 1).contentHash == a.contentHash, false);
+    });
+
+    test('shares identical tensors across checkpoints', () async {
+      final cache = TensorDedupCache();
+      final vae = Tensor.randn([8, 8]);
+      final first = await open(
+        'a.safetensors',
+        _MapLoader({'vae': vae.clone(), 'unet': Tensor.randn([8])}),
+        cache,
+      );
+      final second = await open(
+        'b.safetensors',
+        _MapLoader({'vae': vae.clone(), 'unet': Tensor.randn([8])}),
+        cache,
+      );
+
+      final vae1 = await first.loadByName('vae');
+      final vae2 = await second.loadByName('vae');
+      final unet1 = await first.loadByName('unet');
+      final unet2 = await second.loadByName('unet');
+      expect(vae1.dataPointer, vae2.dataPointer);
+      expect(unet1.dataPointer == unet2.dataPointer, false);
+      expect(vae2.allClose(vae), true);
+
+      final stats = cache.stats;
+      expect(stats.tensors, 3);
+      expect(stats.hits, 1);
+      expect(stats.bytesSaved, vae.memorySize);
+
+      await first.release();
+      expect(cache.length, 2);
+      await second.release();
+      expect(cache.length, 0);
+      expect(cache.stats.bytesResident, 0);
+    });
+
+    test('repeat loads from one checkpoint save nothing', () async {
+      final cache = TensorDedupCache();
+      final loader = await open(
+        'd.safetensors',
+        _MapLoader({'w': Tensor.randn([8])}),
+        cache,
+      );
+      final a = await loader.loadByName('w');
+      final b = await loader.loadByName('w');
+      expect(a.dataPointer, b.dataPointer);
+      expect(cache.stats.hits, 1);
+      expect(cache.stats.bytesSaved, 0);
+      await loader.release();
+      expect(cache.length, 0);
+    });
+
+    test('hash collisions are not shared', () async {
+      final cache = TensorDedupCache();
+      final other = Tensor.randn([8]);
+      final first = await open(
+        'e.safetensors',
+        _MapLoader({'w': Tensor.randn([8])}),
+        cache,
+      );
+      final second = await open(
+        'f.safetensors',
+        _MapLoader({'w': other}),
+        cache,
+      );
+      first.hashes['w'] = '0000000000000000';
+      second.hashes['w'] = '0000000000000000';
+
+      final w1 = await first.loadByName('w');
+      final w2 = await second.loadByName('w');
+      expect(w1.dataPointer == w2.dataPointer, false);
+      expect(w2.bytesEqual(other), true);
+      expect(cache.stats.collisions, 1);
+      expect(cache.stats.bytesSaved, 0);
+
+      await second.release();
+      expect(cache.length, 1);
+      await first.release();
+      expect(cache.length, 0);
+    });
+
+    test('hashes are kept in a sidecar', () async {
+      final cache = TensorDedupCache();
+      final tensors = {'w': Tensor.randn([16])};
+      final loader = await open('c.safetensors', _MapLoader(tensors), cache);
+      final hash = await loader.hashOf('w');
+      await loader.release();
+
+      final path = '${dir.path}/c.safetensors';
+      expect(File(SafeTensorHashes.sidecarPath(path)).existsSync(), true);
+      final reloaded = await SafeTensorHashes.load(path);
+      expect(reloaded['w'], hash);
+    });
+  });
+}
@@ -1,3 +1,4 @@
+import 'dart:async';
 import 'dart:ffi';
 import 'package:ffi/ffi.dart';
 import 'package:tensor/tensor.dart';
@@ -122,4 +123,72 @@ void main() {
       calloc.free(ptr);
     });
   });
+
+  group('Tensor.fromBlobOwned', () {
+    test('releases the buffer with the last view', () async {
+      final size = 8;
+      final ptr = malloc<Float>(size);
+      for (var i = 0; i < size; i++) {
+        ptr[i] = i.toDouble();
+      }
+      final released = Completer<Pointer<Void>>();
+
+      final tensor = Tensor.fromBlobOwned(
+        ptr.cast(),
+        [2, 4],
+        datatype: DataType.float32,
+        release: BlobRelease.listener(released.complete),
+      );
+      expect(tensor.dataPointer, ptr);
+      final view = tensor.slice(1, 2);
+      tensor.release();
+      expect(released.isCompleted, false);
+      expect(view.at([1, 1]).scalar, 7.0);
+
+      view.release();
+      expect(await released.future, ptr.cast<Void>());
+      malloc.free(ptr);
+    });
+
+    test('rejects a listener that was already used', () async {
+      final first = malloc<Float>(4);
+      final second = malloc<Float>(4);
+      final released = Completer<Pointer<Void>>();
+      final release = BlobRelease.listener(released.complete);
+
+      final tensor = Tensor.fromBlobOwned(
+        first.cast(),
+        [4],
+        datatype: DataType.float32,
+        release: release,
+      );
+      expect(
+        () => Tensor.fromBlobOwned(
+          second.cast(),
+          [4],
+          datatype: DataType.float32,
+          release: release,
+        ),
+        throwsStateError,
+      );
+      malloc.free(second);
+
+      tensor.release();
+      expect(await released.future, first.cast<Void>());
+      malloc.free(first);
+    });
+
+    test('frees malloc memory', () {
+      final ptr = malloc<Int64>(16);
+      final tensor = Tensor.fromBlobOwned(
+        ptr.cast(),
+        [16],
+        datatype: DataType.int64,
+        release: BlobRelease.free,
+      );
+      tensor.fill_(3);
+      expect(ptr[15], 3);
+      tensor.release();
+    }, testOn: '!windows');
+  });
 }
@@ -0,0 +1,105 @@
+import 'dart:math';
+import 'dart:typed_data';
+
+import 'package:tensor/tensor.dart';
+import 'package:test/test.dart';
+
+void main() {
+  group('ImageUtil', () {
+    const batch = 2, height = 5, width = 19, channels = 3;
+    final random = Random(7);
+    final data = Uint8List.fromList([
+      for (int i = 0; i < batch * height * width * channels; i++)
+        random.nextInt(256),
+    ]);
+    const mean = [0.485, 0.456, 0.406];
+    const std = [0.229, 0.224, 0.225];
+
+    Tensor reference() {
+      final hwc = Tensor.from(
+        data.map((v) => v.toDouble()).toList(),
+        [batch, height, width, channels],
+        datatype: DataType.float32,
+      );
+      final nchw = hwc.permute([0, 3, 1, 2]) / 255;
+      final m = Tensor.from(mean, [1, 3, 1, 1], datatype: DataType.float32);
+      final s = Tensor.from(std, [1, 3, 1, 1], datatype: DataType.float32);
+      return (nchw - m) / s;
+    }
+
+    test('fromUint8 NCHW', () {
+      final image = ImageUtil.fromUint8(
+        data,
+        batch: batch,
+        height: height,
+        width: width,
+        mean: mean,
+        std: std,
+      );
+      expect(image.shape, [batch, channels, height, width]);
+      expect(image.isContiguous(), true);
+      expect(image.allClose(reference(), atol: 1e-5), true);
+    });
+
+    test('fromUint8 channels last', () {
+      final image = ImageUtil.fromUint8(
+        data,
+        batch: batch,
+        height: height,
+        width: width,
+        mean: mean,
+        std: std,
+        channelsLast: true,
+      );
+      expect(image.shape, [batch, channels, height, width]);
+      expect(
+        image.isContiguous(memoryFormat: MemoryFormat.channelsLast),
+        true,
+      );
+      expect(image.allClose(reference(), atol: 1e-5), true);
+    });
+
+    test('toUint8 round trip', () {
+      for (final channelsLast in [false, true]) {
+        final image = ImageUtil.fromUint8(
+          data,
+          batch: batch,
+          height: height,
+          width: width,
+          mean: [0.5, 0.5, 0.5],
+          std: [0.5, 0.5, 0.5],
+          channelsLast: channelsLast,
+        );
+        expect(ImageUtil.toUint8(image), data);
+      }
+    });
+
+    test('toUint8 clamps', () {
+      final image = Tensor.from(
+        [-3.0, -1.0, 0.0, 1.0, 3.0, 0.5],
+        [1, 1, 2, 3],
+        datatype: DataType.float32,
+      );
+      final out = Uint8List(6);
+      ImageUtil.toUint8(image, out: out);
+      expect(out, [0, 0, 128, 255, 255, 191]);
+    });
+
+    final device = Device.best();
+    test(
+      'toUint8 copies device images to the CPU',
+      () {
+        final image = ImageUtil.fromUint8(
+          data,
+          batch: batch,
+          height: height,
+          width: width,
+          mean: [0.5, 0.5, 0.5],
+          std: [0.5, 0.5, 0.5],
+        ).to(device: device);
+        expect(ImageUtil.toUint8(image), data);
+      },
+      skip: device == Device.cpu ? 'Needs an accelerator' : null,
+    );
+  });
+}
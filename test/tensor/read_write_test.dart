@@ -0,0 +1,54 @@
+import 'dart:ffi';
+
+import 'package:ffi/ffi.dart';
+import 'package:tensor/tensor.dart';
+import 'package:test/test.dart';
+
+void main() {
+  group('Tensor bulk read/write', () {
+    test('toFloat64List of a strided view', () {
+      final tensor = Tensor.randn([3, 4, 5]).permute([2, 0, 1]);
+      expect(tensor.isContiguous(), false);
+      final expected = tensor.contiguous().toList();
+      final values = tensor.toFloat64List();
+      expect(values.length, expected.length);
+      for (int i = 0; i < values.length; i++) {
+        expect(values[i], closeTo(expected[i], 1e-6));
+      }
+    });
+
+    test('toInt64List converts', () {
+      final tensor = Tensor.arange(0, 12).view([3, 4]).slice(1, 1, end: 3);
+      expect(tensor.toInt64List(), [1, 2, 5, 6, 9, 10]);
+      expect(
+        tensor.to(dataType: DataType.float32).toInt64List(),
+        [1, 2, 5, 6, 9, 10],
+      );
+    });
+
+    test('writeFrom a strided view', () {
+      final base = Tensor.zeros([2, 3], datatype: DataType.float32);
+      final view = base.permute([1, 0]);
+      final data = malloc<Double>(6);
+      for (int i = 0; i < 6; i++) {
+        data[i] = i.toDouble();
+      }
+      view.writeFrom(data.cast(), DataType.float64);
+      malloc.free(data);
+      expect(base.toFloat32List(), [0, 2, 4, 1, 3, 5]);
+    });
+
+    test('gather', () {
+      final tensor = Tensor.arange(0, 24).view([2, 3, 4]);
+      expect(
+        tensor.gather([
+          [0, 0, 0],
+          [1, 2, 3],
+          [-1, 0, -2],
+        ]),
+        [0, 23, 14],
+      );
+      expect(() => tensor.gather([[2, 0, 0]]), throwsException);
+    });
+  });
+}
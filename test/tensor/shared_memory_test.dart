@@ -0,0 +1,97 @@
+import 'dart:async';
+import 'dart:convert';
+import 'dart:io';
+
+import 'package:tensor/tensor.dart';
+import 'package:test/test.dart';
+
+/// A local stand-in for the router: forwards descriptors to a worker
+/// process over its stdin and waits for its answers.
+class _Router {
+  final Process _worker;
+  final StreamIterator<String> _replies;
+
+  _Router._(this._worker)
+    : _replies = StreamIterator(
+        _worker.stdout
+            .transform(utf8.decoder)
+            .transform(const LineSplitter()),
+      );
+
+  static Future<_Router> start() async => _Router._(
+    await Process.start(Platform.resolvedExecutable, [
+      'test/tensor/shared_memory_worker.dart',
+    ]),
+  );
+
+  Future<String> send(String command) async {
+    _worker.stdin.writeln(command);
+    await _worker.stdin.flush();
+    if (!await _replies.moveNext()) throw StateError('Worker exited');
+    final reply = _replies.current;
+    if (reply.startsWith('error')) throw StateError(reply);
+    return reply;
+  }
+
+  Future<void> close() async {
+    await _worker.stdin.close();
+    await _worker.exitCode;
+  }
+}
+
+void main() {
+  group('SharedMemoryTensor', () {
+    final prefix = '/tensor-test-$pid';
+    late _Router router;
+
+    setUpAll(() async {
+      router = await _Router.start();
+    });
+
+    tearDownAll(() async {
+      await router.close();
+    });
+
+    test('worker writes are visible without a copy', () async {
+      final name = '$prefix-scale';
+      final x = SharedMemoryTensor.copyOf(Tensor.full([32, 32], 2.0), name);
+      await router.send('scale $name 3.0');
+      expect(x.allClose(Tensor.full([32, 32], 6.0)), true);
+      x.release();
+    });
+
+    test('worker reads the data of this process', () async {
+      final name = '$prefix-sum';
+      final x = SharedMemoryTensor.create(name, [4, 8]);
+      x.fill_(0.5);
+      expect(double.parse(await router.send('sum $name')), closeTo(16, 1e-4));
+      x.release();
+    });
+
+    test('references are counted across processes', () async {
+      final name = '$prefix-refs';
+      final x = SharedMemoryTensor.create(name, [16], datatype: DataType.int64);
+      x.fill_(7);
+      expect(SharedMemoryTensor.refs(x), 1);
+      await router.send('hold $name');
+      expect(SharedMemoryTensor.refs(x), 2);
+
+      // The worker keeps the region alive after the creator drops it.
+      final y = SharedMemoryTensor.open(name);
+      x.release();
+      expect(SharedMemoryTensor.refs(y), 2);
+      y.release();
+
+      await router.send('drop');
+      expect(() => SharedMemoryTensor.open(name), throwsException);
+    });
+
+    test('rejects existing names and unshared tensors', () {
+      final name = '$prefix-exists';
+      final x = SharedMemoryTensor.create(name, [2]);
+      expect(() => SharedMemoryTensor.create(name, [2]), throwsException);
+      expect(SharedMemoryTensor.refs(Tensor.zeros([2])), isNull);
+      x.release();
+    });
+  });
+}
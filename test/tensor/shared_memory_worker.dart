@@ -0,0 +1,45 @@
+// Worker process for shared_memory_test.dart.
+//
+// Reads commands from stdin, one per line, and answers each on stdout:
+//   scale <name> <factor>  maps the tensor <name> and scales it in place
+//   sum <name>             maps the tensor <name> and prints its sum
+//   hold <name>            maps the tensor <name> and keeps it mapped
+//   drop                   releases the held tensors
+import 'dart:convert';
+import 'dart:io';
+
+import 'package:tensor/tensor.dart';
+
+Future<void> main() async {
+  final held = <Tensor>[];
+  final lines = stdin.transform(utf8.decoder).transform(const LineSplitter());
+  await for (final line in lines) {
+    final args = line.split(' ');
+    try {
+      switch (args[0]) {
+        case 'scale':
+          final tensor = SharedMemoryTensor.open(args[1]);
+          tensor.copy_(tensor * double.parse(args[2]));
+          tensor.release();
+          stdout.writeln('ok');
+        case 'sum':
+          final tensor = SharedMemoryTensor.open(args[1]);
+          stdout.writeln(tensor.sum().scalar);
+          tensor.release();
+        case 'hold':
+          held.add(SharedMemoryTensor.open(args[1]));
+          stdout.writeln('ok');
+        case 'drop':
+          for (final tensor in held) {
+            tensor.release();
+          }
+          held.clear();
+          stdout.writeln('ok');
+        default:
+          stdout.writeln('error unknown command ${args[0]}');
+      }
+    } catch (e) {
+      stdout.writeln('error $e');
+    }
+  }
+}
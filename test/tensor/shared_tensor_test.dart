@@ -0,0 +1,110 @@
+import 'dart:isolate';
+
+import 'package:tensor/tensor.dart';
+import 'package:test/test.dart';
+
+void main() {
+  group('TensorToken', () {
+    test('imports share storage across isolates', () async {
+      final weights = Tensor.randn([64, 64]);
+      final token = TensorToken.export(weights, importers: 2);
+      expect(token.remaining, 2);
+
+      final sums = await Future.wait([
+        for (int i = 0; i < 2; i++)
+          Isolate.run(() {
+            final imported = token.import();
+            return imported.sum().scalar as double;
+          }),
+      ]);
+      final expected = weights.sum().scalar as double;
+      for (final sum in sums) {
+        expect(sum, closeTo(expected, 1e-3));
+      }
+    });
+
+    test('keeps storage alive after the exporter drops it', () async {
+      var weights = Tensor.full([16], 3.0);
+      final token = TensorToken.export(weights);
+      weights.release();
+
+      final imported = await Isolate.run(() {
+        final tensor = token.import();
+        tensor.fill_(5.0);
+        return TensorToken.export(tensor);
+      });
+      weights = imported.import();
+      expect(weights.allClose(Tensor.full([16], 5.0)), true);
+    });
+
+    test('in-place writes are visible to the exporter', () async {
+      final weights = Tensor.zeros([8]);
+      final token = TensorToken.export(weights);
+      await Isolate.run(() => token.import().fill_(2.0));
+      expect(weights.allClose(Tensor.full([8], 2.0)), true);
+    });
+
+    test('release drops unused imports', () {
+      final token = TensorToken.export(Tensor.zeros([4]), importers: 3);
+      token.import();
+      expect(token.remaining, 2);
+      token.release(2);
+    });
+  });
+
+  group('Module.importStateDict_', () {
+    test('shares the weights of a module', () async {
+      final linear = LinearLayer.make(inFeatures: 8, outFeatures: 4);
+      final tokens = linear.shareStateDict();
+      final x = Tensor.randn([2, 8]);
+      final input = TensorToken.export(x);
+      final expected = NNUtil.linear(x, linear.weight, bias: linear.bias);
+
+      final output = await Isolate.run(() {
+        final context = Context(isTraining: false, device: Device.cpu);
+        final copy = LinearLayer.make(
+          inFeatures: 8,
+          outFeatures: 4,
+          device: Device.meta,
+        );
+        copy.importStateDict_(tokens);
+        if (copy.isMeta) throw StateError('Parameters were not imported');
+        final result = copy.forward(input.import(), context: context);
+        return TensorToken.export(result);
+      });
+      expect(output.import().allClose(expected, atol: 1e-6), true);
+    });
+
+    test('keeps imported weights shared', () {
+      final context = Context(isTraining: false, device: Device.cpu);
+      final linear = LinearLayer.make(inFeatures: 8, outFeatures: 4);
+      final copy = LinearLayer.make(inFeatures: 8, outFeatures: 4)
+        ..usePrepacked = true;
+      copy.importStateDict_(linear.shareStateDict());
+      expect(copy.hasImportedParameters, true);
+
+      final x = Tensor.randn([2, 8]);
+      final expected = NNUtil.linear(x, linear.weight, bias: linear.bias);
+      expect(copy.forward(x, context: context).allClose(expected), true);
+      copy.flattenParameters_();
+      expect(copy.flatParameters, isEmpty);
+      expect(copy.weight.dataPointer, linear.weight.dataPointer);
+    });
+
+    test('drops caches built from replaced weights', () {
+      final context = Context(isTraining: false, device: Device.cpu);
+      final linear = LinearLayer.make(inFeatures: 8, outFeatures: 4)
+        ..usePrepacked = true;
+      final x = Tensor.randn([2, 8]);
+      linear.forward(x, context: context);
+
+      final other = LinearLayer.make(inFeatures: 8, outFeatures: 4);
+      linear.importStateDict_(other.shareStateDict());
+      final expected = NNUtil.linear(x, other.weight, bias: other.bias);
+      expect(
+        linear.forward(x, context: context).allClose(expected, atol: 1e-6),
+        true,
+      );
+    });
+  });
+}
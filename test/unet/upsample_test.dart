@@ -0,0 +1,79 @@
+import 'package:tensor/tensor.dart';
+import 'package:test/test.dart';
+
+void main() {
+  final context = Context(isTraining: false, device: Device.cpu);
+
+  group('Upsample2D', () {
+    test('fused upsample + conv matches upsample then conv', () {
+      final upsample = Upsample2D.make(
+        channels: 8,
+        useConv: true,
+        outChannels: 16,
+      );
+      expect(upsample.isFusable, true);
+      final input = Tensor.randn([2, 8, 7, 9]);
+      final expected = upsample.conv!.forward(
+        interpolateNearestScale(input, [2.0, 2.0]),
+        context: context,
+      );
+
+      final output = upsample.forward(input, context: context);
+      expect(output.shape, [2, 16, 14, 18]);
+      expect(output.allClose(expected, atol: 1e-5), true);
+    });
+
+    test('fused phase kernels follow in-place weight edits', () {
+      final upsample = Upsample2D.make(channels: 4, useConv: true);
+      final input = Tensor.randn([1, 4, 5, 5]);
+      upsample.forward(input, context: context);
+
+      upsample.conv!.weight.normal_();
+      final expected = upsample.conv!.forward(
+        interpolateNearestScale(input, [2.0, 2.0]),
+        context: context,
+      );
+      final output = upsample.forward(input, context: context);
+      expect(output.allClose(expected, atol: 1e-4), true);
+    });
+
+    test('conv with an adapter is not fused', () {
+      final upsample = Upsample2D.make(channels: 4, useConv: true);
+      upsample.conv!.lora = LoRAAdapter(
+        down: Tensor.randn([2, 4, 3, 3]),
+        up: Tensor.randn([4, 2, 1, 1]),
+        alpha: 1,
+      );
+      final input = Tensor.randn([1, 4, 5, 5]);
+      final expected = upsample.conv!.forward(
+        interpolateNearestScale(input, [2.0, 2.0]),
+        context: context,
+      );
+
+      final output = upsample.forward(input, context: context);
+      expect(output.allClose(expected, atol: 1e-4), true);
+    });
+
+    for (final (file, name) in [
+      ('upsample_simple', 'upsample'),
+      ('upsample_vae', 'vae1'),
+    ]) {
+      test(file, () async {
+        final safeTensors = await SafeTensorsFile.load(
+          './test_data/unet/upsample/$file.safetensors',
+        );
+        final loader = safeTensors.mmapTensorLoader();
+        final input = await loader.loadByName('$name.input');
+        final expected = await loader.loadByName('$name.output');
+        final upsample = await Upsample2D.loadFromSafeTensor(
+          loader,
+          prefix: '$name.upsample.',
+          channels: input.shape[1],
+        );
+
+        final output = upsample.forward(input, context: context);
+        expect(output.allClose(expected, atol: 1e-4), true);
+      });
+    }
+  });
+}
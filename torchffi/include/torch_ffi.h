@@ -58,6 +58,16 @@ static const char *padModeNameReflect = "reflect";
 static const char *padModeNameReplicate = "replicate";
 static const char *padModeNameCircular = "circular";
 
+static const uint8_t normTypeLayer = 0;
+static const uint8_t normTypeRMS = 1;
+
+static const uint8_t activationNone = 0;
+static const uint8_t activationGelu = 1;
+static const uint8_t activationGeluTanh = 2;
+static const uint8_t activationSilu = 3;
+static const uint8_t activationQuickGelu = 4;
+static const uint8_t activationRelu = 5;
+
 typedef struct FInfo_t {
   double min;
   double max;
@@ -66,11 +76,75 @@ typedef struct FInfo_t {
   double resolution;
 } FInfo;
 
+typedef struct KVCache_t {
+  std::vector<at::Tensor> keys;
+  std::vector<at::Tensor> values;
+  std::vector<int64_t> lengths;
+  int64_t seqDim;
+} KVCache_t;
+
+typedef struct PackedConv2d_t {
+  at::Tensor weight;
+  std::optional<at::Tensor> bias;
+  std::vector<int64_t> strides;
+  std::vector<int64_t> paddings;
+  std::vector<int64_t> dilations;
+  int64_t groups;
+  bool mkldnn;
+} PackedConv2d_t;
+
+typedef struct PackedLinear_t {
+  at::Tensor weight;
+  std::optional<at::Tensor> bias;
+  int64_t outFeatures;
+  bool mkldnn;
+} PackedLinear_t;
+
+struct OpTape_t;
+struct Executor_t;
+struct SharedTensor_t;
+struct TracedGraph_t;
+
+extern "C" {
+typedef KVCache_t *KVCache;
+typedef PackedConv2d_t *PackedConv2d;
+typedef PackedLinear_t *PackedLinear;
+typedef OpTape_t *OpTape;
+typedef Executor_t *Executor;
+typedef SharedTensor_t *SharedTensor;
+typedef TracedGraph_t *TracedGraph;
+}
+
+at::TensorOptions torchffi_make_tensor_options(TensorOptions options);
+
 #else
 typedef void *tensor;
 typedef void *Generator;
+typedef void *KVCache;
+typedef void *PackedConv2d;
+typedef void *PackedLinear;
+typedef void *OpTape;
+typedef void *Executor;
+typedef void *SharedTensor;
+typedef void *TracedGraph;
 #endif
 
+// Releases a buffer wrapped by torchffi_tensor_new_from_blob_owned once the
+// last reference to its storage dies. May be called from any thread.
+typedef void (*BlobRelease)(void *data, void *context);
+
+// Receives the outputs of a request run by an Executor, or its error, on a
+// worker thread. The receiver owns the outputs array, the tensors in it and
+// the error, all allocated with malloc/new.
+typedef void (*ExecutorCompletion)(int64_t requestId, tensor *outputs,
+                                   int64_t count, char *error);
+
+// Runs the forward being traced by torchffi_graph_trace on the calling
+// thread and stores its output in *output, or leaves it null on failure.
+// The caller keeps ownership of the output and must keep it alive until
+// torchffi_graph_trace returns.
+typedef void (*TraceForward)(tensor *output);
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -117,6 +191,18 @@ extern tensor torchffi_tensor_new_randint(int64_t low, int64_t high,
 
 extern void *torchffi_tensor_data_pointer(tensor t);
 
+extern void *torchffi_tensor_impl(tensor t);
+
+extern tensor torchffi_tensor_share(tensor t);
+
+extern int64_t torchffi_tensor_version(tensor t);
+
+extern void torchffi_tensor_assign(tensor dst, tensor src);
+
+extern uint64_t torchffi_tensor_content_hash(tensor t, char **error);
+
+extern bool torchffi_tensor_bytes_equal(tensor a, tensor b, char **error);
+
 extern size_t torchffi_tensor_dim(tensor t);
 
 extern void torchffi_tensor_sizes(tensor t, size_t dim, int64_t *shape);
@@ -130,11 +216,29 @@ extern tensor torchffi_tensor_new_from_blob(void *data, int64_t *dims,
                                             size_t ndims,
                                             TensorOptions options);
 
+extern tensor torchffi_tensor_new_from_blob_owned(
+    void *data, int64_t *dims, size_t ndims, TensorOptions options,
+    BlobRelease release, void *context, char **error);
+
+extern void torchffi_blob_release_free(void *data, void *context);
+
+extern void torchffi_blob_release_munmap(void *data, void *context);
+
 extern Scalar_t torchffi_tensor_scalar(tensor t);
 
 extern Scalar_t torchffi_tensor_scalar_at(tensor t, int64_t *indices,
                                           size_t indicesLength, char **error);
 
+extern void torchffi_tensor_read_into(tensor t, void *out, int8_t dtype,
+                                      char **error);
+
+extern void torchffi_tensor_write_from(tensor t, const void *data,
+                                       int8_t dtype, char **error);
+
+extern void torchffi_tensor_gather_into(tensor t, const int64_t *indices,
+                                        int64_t count, void *out,
+                                        int8_t dtype, char **error);
+
 extern tensor torchffi_tensor_get(tensor t, int index);
 
 extern int8_t torchffi_tensor_get_datatype(tensor t);
@@ -285,6 +389,15 @@ extern tensor torchffi_rms_norm(tensor input, int64_t *normalizedShape,
                                 size_t normalizedShapeLength, tensor weight,
                                 double *eps);
 
+extern void torchffi_group_norm_stats(tensor input, int64_t numGroups,
+                                      tensor *sums, tensor *sumSquares,
+                                      char **error);
+
+extern tensor torchffi_group_norm_apply(tensor input, int64_t numGroups,
+                                        tensor mean, tensor rstd,
+                                        tensor weight, tensor bias,
+                                        char **error);
+
 extern tensor torchffi_dropout(tensor t, double p, bool train);
 
 extern void torchffi_dropout_(tensor t, double p, bool train);
@@ -408,6 +521,239 @@ extern void torchffi_set_autocast_enabled(int8_t device, bool enabled);
 
 extern bool torchffi_is_autocast_enabled(int8_t device);
 
+// KV cache
+
+extern KVCache torchffi_kv_cache_new(int64_t numLayers, int64_t *sizes,
+                                     size_t ndims, int64_t seqDim,
+                                     TensorOptions options);
+
+extern void torchffi_kv_cache_delete(KVCache cache);
+
+extern int64_t torchffi_kv_cache_length(KVCache cache, int64_t layer,
+                                        char **error);
+
+extern int64_t torchffi_kv_cache_capacity(KVCache cache, int64_t layer,
+                                          char **error);
+
+extern void torchffi_kv_cache_update(KVCache cache, int64_t layer, tensor key,
+                                     tensor value, tensor *keysOut,
+                                     tensor *valuesOut, char **error);
+
+extern void torchffi_kv_cache_truncate(KVCache cache, int64_t length);
+
+// Fused upsample + convolution
+
+extern tensor torchffi_upsample2x_conv2d_phase_weights(tensor weights,
+                                                       char **error);
+
+extern tensor torchffi_upsample2x_conv2d(tensor input, tensor phaseWeights,
+                                         tensor bias, char **error);
+
+// Prepacked convolution
+
+extern PackedConv2d torchffi_conv2d_prepack(tensor weights, tensor bias,
+                                            int64_t *strides,
+                                            int64_t *paddings,
+                                            int64_t *dilations, int64_t groups,
+                                            int64_t *inputSizes, size_t ndims,
+                                            char **error);
+
+extern void torchffi_conv2d_packed_delete(PackedConv2d packed);
+
+extern bool torchffi_conv2d_packed_is_mkldnn(PackedConv2d packed);
+
+extern tensor torchffi_conv2d_packed(PackedConv2d packed, tensor input,
+                                     char **error);
+
+// Prepacked linear
+
+extern PackedLinear torchffi_linear_prepack(tensor weight, tensor bias,
+                                            int64_t batchSize, char **error);
+
+extern void torchffi_linear_packed_delete(PackedLinear packed);
+
+extern bool torchffi_linear_packed_is_mkldnn(PackedLinear packed);
+
+extern tensor torchffi_linear_packed(PackedLinear packed, tensor input,
+                                     char **error);
+
+// Fused linear
+
+extern tensor torchffi_linear_activation(tensor input, tensor weight,
+                                         tensor bias, uint8_t activation,
+                                         char **error);
+
+extern tensor torchffi_linear_gated(tensor input, tensor weight, tensor bias,
+                                    uint8_t activation, char **error);
+
+// Fused normalization
+
+extern tensor torchffi_add_norm_(tensor input, tensor residual,
+                                 int64_t normalizedSize, tensor weight,
+                                 tensor bias, double *eps, uint8_t normType,
+                                 char **error);
+
+// Tensors shared between isolates
+
+extern SharedTensor torchffi_tensor_share(tensor t, int64_t importers,
+                                          char **error);
+
+extern tensor torchffi_shared_tensor_import(SharedTensor token);
+
+extern void torchffi_shared_tensor_release(SharedTensor token, int64_t count);
+
+extern int64_t torchffi_shared_tensor_remaining(SharedTensor token);
+
+// Shared memory tensors
+
+extern tensor torchffi_shm_tensor_new(char *name, int64_t *dims, size_t ndims,
+                                      int8_t dtype, char **error);
+
+extern tensor torchffi_shm_tensor_open(char *name, char **error);
+
+extern int64_t torchffi_shm_tensor_refs(tensor t);
+
+// Traced graphs
+
+extern TracedGraph torchffi_graph_trace(tensor *inputs, size_t ninputs,
+                                        TraceForward forward, bool optimize,
+                                        char **error);
+
+extern void torchffi_graph_delete(TracedGraph graph);
+
+extern tensor torchffi_graph_run(TracedGraph graph, tensor *inputs,
+                                 size_t ninputs, char **error);
+
+extern char *torchffi_graph_dump(TracedGraph graph);
+
+// Op tapes and the async executor
+
+extern OpTape torchffi_tape_new();
+
+extern void torchffi_tape_delete(OpTape tape);
+
+extern int64_t torchffi_tape_length(OpTape tape);
+
+extern int64_t torchffi_tape_capture(OpTape tape, tensor t);
+
+extern void torchffi_tape_arg_slot(OpTape tape, int64_t slot);
+
+extern void torchffi_tape_arg_slot_list(OpTape tape, int64_t *slots,
+                                        size_t count);
+
+extern void torchffi_tape_arg_int(OpTape tape, int64_t value);
+
+extern void torchffi_tape_arg_double(OpTape tape, double value);
+
+extern void torchffi_tape_arg_bool(OpTape tape, bool value);
+
+extern void torchffi_tape_arg_int_list(OpTape tape, int64_t *values,
+                                       size_t count);
+
+extern void torchffi_tape_arg_string(OpTape tape, char *value);
+
+extern void torchffi_tape_arg_none(OpTape tape);
+
+extern int64_t torchffi_tape_call(OpTape tape, char *name, char *overload,
+                                  int64_t *numOutputs, char **error);
+
+extern void torchffi_tape_output(OpTape tape, int64_t slot, char **error);
+
+extern Executor torchffi_executor_new(int64_t threads,
+                                      ExecutorCompletion completion);
+
+extern void torchffi_executor_delete(Executor executor);
+
+extern int64_t torchffi_executor_submit(Executor executor, OpTape tape,
+                                        int64_t stream, char **error);
+
+extern int32_t torchffi_executor_progress(Executor executor, int64_t requestId,
+                                          int64_t *done, int64_t *total);
+
+// Module profiler
+
+extern int64_t torchffi_profiler_now_ns();
+
+extern void torchffi_profiler_track_memory(bool enabled);
+
+extern void torchffi_profiler_synchronize(char **error);
+
+extern void torchffi_profiler_enter(int64_t *record);
+
+extern void torchffi_profiler_exit(int64_t *record);
+
+// Low-rank adapters
+
+extern void torchffi_lora_add_(tensor output, tensor input, tensor down,
+                               tensor up, double scale, char **error);
+
+extern void torchffi_lora_add_batched_(tensor output, tensor input,
+                                       tensor down, tensor up, tensor scales,
+                                       tensor indices, char **error);
+
+// Flat parameters
+
+extern tensor torchffi_flatten_parameters(tensor *parameters, size_t count,
+                                          char **error);
+
+extern void torchffi_flat_parameters_to(tensor flat, tensor *parameters,
+                                        size_t count, TensorOptions options,
+                                        bool nonBlocking, char **error);
+
+// Image conversion
+
+extern tensor torchffi_image_from_uint8(const uint8_t *data, int64_t batch,
+                                        int64_t height, int64_t width,
+                                        int64_t channels, const float *mean,
+                                        const float *std, bool channelsLast,
+                                        char **error);
+
+extern void torchffi_image_to_uint8(tensor image, uint8_t *out, double low,
+                                    double high, char **error);
+
+// Classifier-free guidance
+
+extern tensor torchffi_guidance_combine(tensor output, double scale,
+                                        char **error);
+
+// Diffusion sampler steps
+
+extern void torchffi_sampler_step_(tensor x, double a, tensor t1, double c1,
+                                   tensor t2, double c2, double noiseScale,
+                                   Generator generator, char **error);
+
+extern void torchffi_euler_step_(tensor x, tensor denoised, double sigma,
+                                 double sigmaNext, double eta,
+                                 Generator generator, char **error);
+
+extern void torchffi_ddim_step_(tensor x, tensor noisePrediction,
+                                double alphaCumprod, double alphaCumprodPrev,
+                                double eta, Generator generator,
+                                char **error);
+
+extern void torchffi_dpmpp_2m_step_(tensor x, tensor denoised,
+                                    tensor previousDenoised, double sigma,
+                                    double sigmaNext, double sigmaPrevious,
+                                    char **error);
+
+// Rotary position embedding
+
+extern void torchffi_rotary_embedding_(tensor query, tensor key,
+                                       int64_t rotaryDim, double base,
+                                       double scaling, int64_t positionOffset,
+                                       int64_t seqDim, bool interleaved,
+                                       char **error);
+
+extern void torchffi_rotary_embedding_cache_clear();
+
+// Speculative decoding
+
+extern int64_t torchffi_speculative_verify(tensor draftProbs,
+                                           tensor targetProbs,
+                                           tensor draftTokens, bool greedy,
+                                           Generator generator,
+                                           int64_t *nextToken, char **error);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,133 @@
+#include <torch/all.h>
+#include <torch_ffi.h>
+
+#include <ATen/Parallel.h>
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+// Chunks are hashed independently so that the result does not depend on the
+// number of threads.
+constexpr int64_t kChunkBytes = 1 << 20;
+
+constexpr uint64_t kMultiplier = 0x9e3779b97f4a7c15ULL;
+
+inline uint64_t mix(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+inline uint64_t combine(uint64_t h, uint64_t value) {
+  return mix(h ^ (value + kMultiplier + (h << 6) + (h >> 2)));
+}
+
+at::Tensor contiguousCpu(const at::Tensor &input) {
+  at::Tensor t = input.contiguous();
+  return t.is_cpu() ? t : t.cpu();
+}
+
+uint64_t hashChunk(const uint8_t *data, int64_t length, uint64_t seed) {
+  // Four independent lanes keep the multiplies pipelined.
+  uint64_t lanes[4] = {seed, seed ^ kMultiplier, seed + 1, seed - kMultiplier};
+  int64_t i = 0;
+  for (; i + 32 <= length; i += 32) {
+    for (int lane = 0; lane < 4; lane++) {
+      uint64_t word;
+      std::memcpy(&word, data + i + lane * 8, 8);
+      lanes[lane] = (lanes[lane] ^ word) * kMultiplier;
+      lanes[lane] = (lanes[lane] << 31) | (lanes[lane] >> 33);
+    }
+  }
+  uint64_t h = seed ^ static_cast<uint64_t>(length);
+  for (uint64_t lane : lanes) {
+    h = combine(h, lane);
+  }
+  for (; i < length; i++) {
+    h = combine(h, data[i]);
+  }
+  return h;
+}
+
+uint64_t contentHash(const at::Tensor &input) {
+  at::Tensor t = contiguousCpu(input);
+  const uint8_t *data = static_cast<const uint8_t *>(t.data_ptr());
+  int64_t bytes = t.numel() * t.element_size();
+  int64_t chunks = (bytes + kChunkBytes - 1) / kChunkBytes;
+  std::vector<uint64_t> chunkHashes(chunks);
+  at::parallel_for(0, chunks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t c = begin; c < end; c++) {
+      int64_t offset = c * kChunkBytes;
+      chunkHashes[c] = hashChunk(data + offset,
+                                 std::min(kChunkBytes, bytes - offset), c);
+    }
+  });
+
+  uint64_t h = mix(static_cast<uint64_t>(t.scalar_type()));
+  for (int64_t size : t.sizes()) {
+    h = combine(h, static_cast<uint64_t>(size));
+  }
+  for (uint64_t chunk : chunkHashes) {
+    h = combine(h, chunk);
+  }
+  return h;
+}
+
+bool bytesEqual(const at::Tensor &a, const at::Tensor &b) {
+  if (a.scalar_type() != b.scalar_type() || a.sizes() != b.sizes()) {
+    return false;
+  }
+  at::Tensor x = contiguousCpu(a);
+  at::Tensor y = contiguousCpu(b);
+  const uint8_t *xData = static_cast<const uint8_t *>(x.data_ptr());
+  const uint8_t *yData = static_cast<const uint8_t *>(y.data_ptr());
+  int64_t bytes = x.numel() * x.element_size();
+  int64_t chunks = (bytes + kChunkBytes - 1) / kChunkBytes;
+  std::atomic<bool> equal{true};
+  at::parallel_for(0, chunks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t c = begin; c < end && equal.load(); c++) {
+      int64_t offset = c * kChunkBytes;
+      if (std::memcmp(xData + offset, yData + offset,
+                      std::min(kChunkBytes, bytes - offset)) != 0) {
+        equal = false;
+      }
+    }
+  });
+  return equal;
+}
+
+} // namespace
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 64-bit hash of the dtype, shape and contents of t in row-major order.
+uint64_t torchffi_tensor_content_hash(tensor t, char **error) {
+  try {
+    return contentHash(*t);
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+    return 0;
+  }
+}
+
+// Whether a and b have the same dtype, shape and row-major bytes. Unlike
+// torch.equal, NaNs with equal bits match and 0.0 does not match -0.0.
+bool torchffi_tensor_bytes_equal(tensor a, tensor b, char **error) {
+  try {
+    return bytesEqual(*a, *b);
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+    return false;
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,330 @@
+#include <torch/all.h>
+#include <torch_ffi.h>
+
+#include <ATen/ThreadLocalState.h>
+#include <ATen/core/dispatch/Dispatcher.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+// Argument of a recorded op: a slot, a list of slots or a constant.
+struct TapeArg {
+  enum Kind : uint8_t { kSlot, kSlotList, kConstant } kind;
+  std::vector<int64_t> slots;
+  c10::IValue constant;
+};
+
+struct TapeInstruction {
+  c10::OperatorHandle op;
+  std::vector<TapeArg> args;
+  int64_t firstOutput;
+  size_t numOutputs;
+};
+
+struct OpTape_t {
+  int64_t numSlots = 0;
+  std::vector<std::pair<int64_t, at::Tensor>> captured;
+  std::vector<TapeInstruction> instructions;
+  std::vector<int64_t> outputs;
+  // Arguments of the op being recorded, consumed by torchffi_tape_call.
+  std::vector<TapeArg> pending;
+};
+
+namespace {
+
+enum Status : int32_t {
+  kUnknown = 0,
+  kQueued = 1,
+  kRunning = 2,
+};
+
+struct Request {
+  int64_t id;
+  int64_t stream;
+  OpTape_t tape;
+  // Grad mode, autocast and dispatch key state of the submitting thread.
+  at::ThreadLocalState state;
+  std::atomic<int64_t> done{0};
+  std::atomic<int32_t> status{kQueued};
+};
+
+struct Stream {
+  std::deque<std::shared_ptr<Request>> queue;
+  // Queued in Executor_t::runnable or being run by a worker.
+  bool active = false;
+};
+
+void checkSlot(const OpTape_t &tape, int64_t slot) {
+  TORCH_CHECK(slot >= 0 && slot < tape.numSlots, "Invalid tape slot ", slot);
+}
+
+std::vector<at::Tensor> run(Request &request) {
+  const OpTape_t &tape = request.tape;
+  std::vector<c10::IValue> slots(tape.numSlots);
+  for (const auto &[slot, tensor] : tape.captured) {
+    slots[slot] = tensor;
+  }
+  torch::jit::Stack stack;
+  for (const TapeInstruction &instruction : tape.instructions) {
+    stack.clear();
+    for (const TapeArg &arg : instruction.args) {
+      switch (arg.kind) {
+      case TapeArg::kSlot:
+        stack.push_back(slots[arg.slots[0]]);
+        break;
+      case TapeArg::kSlotList: {
+        c10::List<at::Tensor> list;
+        list.reserve(arg.slots.size());
+        for (int64_t slot : arg.slots) {
+          list.push_back(slots[slot].toTensor());
+        }
+        stack.emplace_back(std::move(list));
+        break;
+      }
+      case TapeArg::kConstant:
+        stack.push_back(arg.constant);
+        break;
+      }
+    }
+    instruction.op.callBoxed(stack);
+    for (size_t i = 0; i < instruction.numOutputs; i++) {
+      slots[instruction.firstOutput + i] = std::move(stack[i]);
+    }
+    request.done.fetch_add(1, std::memory_order_relaxed);
+  }
+  std::vector<at::Tensor> outputs;
+  outputs.reserve(tape.outputs.size());
+  for (int64_t slot : tape.outputs) {
+    TORCH_CHECK(slots[slot].isTensor(), "Tape output ", slot,
+                " is not a tensor");
+    outputs.push_back(slots[slot].toTensor());
+  }
+  return outputs;
+}
+
+} // namespace
+
+// Runs tapes on worker threads. Requests of one stream run one at a time in
+// submission order; different streams run concurrently.
+struct Executor_t {
+  ExecutorCompletion completion;
+  std::mutex mutex;
+  std::condition_variable ready;
+  std::deque<int64_t> runnable;
+  std::unordered_map<int64_t, Stream> streams;
+  std::unordered_map<int64_t, std::shared_ptr<Request>> requests;
+  std::vector<std::thread> workers;
+  int64_t nextId = 1;
+  bool stopping = false;
+
+  void work() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      ready.wait(lock, [this] { return stopping || !runnable.empty(); });
+      if (runnable.empty()) return;
+      const int64_t streamId = runnable.front();
+      runnable.pop_front();
+      Stream &stream = streams[streamId];
+      std::shared_ptr<Request> request = std::move(stream.queue.front());
+      stream.queue.pop_front();
+      lock.unlock();
+
+      complete(*request);
+
+      lock.lock();
+      requests.erase(request->id);
+      Stream &after = streams[streamId];
+      if (after.queue.empty()) {
+        streams.erase(streamId);
+      } else {
+        runnable.push_back(streamId);
+        ready.notify_one();
+      }
+    }
+  }
+
+  void complete(Request &request) {
+    request.status.store(kRunning);
+    tensor *outputs = nullptr;
+    int64_t count = 0;
+    char *error = nullptr;
+    try {
+      at::ThreadLocalStateGuard guard(request.state);
+      std::vector<at::Tensor> results = run(request);
+      count = int64_t(results.size());
+      outputs = static_cast<tensor *>(malloc(sizeof(tensor) * (count + 1)));
+      for (int64_t i = 0; i < count; i++) {
+        outputs[i] = new torch::Tensor(std::move(results[i]));
+      }
+    } catch (const std::exception &e) {
+      error = strdup(e.what());
+    }
+    // The receiver owns the output array, the tensors and the error.
+    completion(request.id, outputs, count, error);
+  }
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+OpTape torchffi_tape_new() { return new OpTape_t(); }
+
+void torchffi_tape_delete(OpTape tape) { delete tape; }
+
+int64_t torchffi_tape_length(OpTape tape) {
+  return int64_t(tape->instructions.size());
+}
+
+int64_t torchffi_tape_capture(OpTape tape, tensor t) {
+  const int64_t slot = tape->numSlots++;
+  tape->captured.emplace_back(slot, *t);
+  return slot;
+}
+
+void torchffi_tape_arg_slot(OpTape tape, int64_t slot) {
+  tape->pending.push_back({TapeArg::kSlot, {slot}, {}});
+}
+
+void torchffi_tape_arg_slot_list(OpTape tape, int64_t *slots, size_t count) {
+  tape->pending.push_back(
+      {TapeArg::kSlotList, std::vector<int64_t>(slots, slots + count), {}});
+}
+
+void torchffi_tape_arg_int(OpTape tape, int64_t value) {
+  tape->pending.push_back({TapeArg::kConstant, {}, value});
+}
+
+void torchffi_tape_arg_double(OpTape tape, double value) {
+  tape->pending.push_back({TapeArg::kConstant, {}, value});
+}
+
+void torchffi_tape_arg_bool(OpTape tape, bool value) {
+  tape->pending.push_back({TapeArg::kConstant, {}, value});
+}
+
+void torchffi_tape_arg_int_list(OpTape tape, int64_t *values, size_t count) {
+  tape->pending.push_back(
+      {TapeArg::kConstant,
+       {},
+       c10::List<int64_t>(c10::ArrayRef<int64_t>(values, count))});
+}
+
+void torchffi_tape_arg_string(OpTape tape, char *value) {
+  tape->pending.push_back({TapeArg::kConstant, {}, std::string(value)});
+}
+
+void torchffi_tape_arg_none(OpTape tape) {
+  tape->pending.push_back({TapeArg::kConstant, {}, c10::IValue()});
+}
+
+int64_t torchffi_tape_call(OpTape tape, char *name, char *overload,
+                           int64_t *numOutputs, char **error) {
+  std::vector<TapeArg> args = std::move(tape->pending);
+  tape->pending.clear();
+  try {
+    c10::OperatorHandle op =
+        c10::Dispatcher::singleton().findSchemaOrThrow(name, overload);
+    const c10::FunctionSchema &schema = op.schema();
+    const auto &expected = schema.arguments();
+    TORCH_CHECK(args.size() <= expected.size(), schema.name(), " takes ",
+                expected.size(), " arguments, got ", args.size());
+    for (const TapeArg &arg : args) {
+      if (arg.kind == TapeArg::kConstant) continue;
+      for (int64_t slot : arg.slots) {
+        checkSlot(*tape, slot);
+      }
+    }
+    for (size_t i = args.size(); i < expected.size(); i++) {
+      const auto &value = expected[i].default_value();
+      TORCH_CHECK(value.has_value(), schema.name(), " is missing argument ",
+                  expected[i].name());
+      args.push_back({TapeArg::kConstant, {}, *value});
+    }
+    const int64_t firstOutput = tape->numSlots;
+    const size_t outputs = schema.returns().size();
+    tape->numSlots += int64_t(outputs);
+    tape->instructions.push_back(
+        {std::move(op), std::move(args), firstOutput, outputs});
+    *numOutputs = int64_t(outputs);
+    return firstOutput;
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+    return -1;
+  }
+}
+
+void torchffi_tape_output(OpTape tape, int64_t slot, char **error) {
+  try {
+    checkSlot(*tape, slot);
+    tape->outputs.push_back(slot);
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+  }
+}
+
+Executor torchffi_executor_new(int64_t threads,
+                               ExecutorCompletion completion) {
+  Executor executor = new Executor_t();
+  executor->completion = completion;
+  for (int64_t i = 0; i < std::max<int64_t>(threads, 1); i++) {
+    executor->workers.emplace_back([executor] { executor->work(); });
+  }
+  return executor;
+}
+
+void torchffi_executor_delete(Executor executor) {
+  {
+    std::lock_guard<std::mutex> lock(executor->mutex);
+    executor->stopping = true;
+  }
+  executor->ready.notify_all();
+  for (std::thread &worker : executor->workers) {
+    worker.join();
+  }
+  delete executor;
+}
+
+int64_t torchffi_executor_submit(Executor executor, OpTape tape,
+                                 int64_t stream, char **error) {
+  try {
+    TORCH_CHECK(tape->pending.empty(), "Tape has arguments without an op");
+    auto request = std::make_shared<Request>();
+    request->stream = stream;
+    // Copied so that the tape can be edited, resubmitted or freed.
+    request->tape = *tape;
+    std::lock_guard<std::mutex> lock(executor->mutex);
+    TORCH_CHECK(!executor->stopping, "Executor is closed");
+    request->id = executor->nextId++;
+    executor->requests[request->id] = request;
+    Stream &s = executor->streams[stream];
+    s.queue.push_back(request);
+    if (!s.active) {
+      s.active = true;
+      executor->runnable.push_back(stream);
+      executor->ready.notify_one();
+    }
+    return request->id;
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+    return -1;
+  }
+}
+
+int32_t torchffi_executor_progress(Executor executor, int64_t requestId,
+                                   int64_t *done, int64_t *total) {
+  std::lock_guard<std::mutex> lock(executor->mutex);
+  auto it = executor->requests.find(requestId);
+  if (it == executor->requests.end()) return kUnknown;
+  *done = it->second->done.load(std::memory_order_relaxed);
+  *total = int64_t(it->second->tape.instructions.size());
+  return it->second->status.load();
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,136 @@
+#include <torch/all.h>
+#include <torch_ffi.h>
+
+#include <cstring>
+
+namespace {
+
+// Parameter offsets are aligned to this many elements so that every view
+// starts on a vector boundary.
+constexpr int64_t kAlignment = 16;
+
+int64_t alignUp(int64_t value) {
+  return (value + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+// A tensor over the storage of flat at offset with the sizes and strides of
+// parameter.
+at::Tensor viewOf(const at::Tensor &flat, int64_t offset,
+                  const at::Tensor &parameter) {
+  at::Tensor view = at::empty({0}, flat.options());
+  view.set_(flat.storage(), offset, parameter.sizes(), parameter.strides());
+  return view;
+}
+
+// Makes parameter a view of flat at offset in place, keeping its sizes and
+// strides. set_ requires flat to have the dtype and device of parameter.
+void rebind(at::Tensor &parameter, const at::Tensor &flat, int64_t offset) {
+  parameter.set_(flat.storage(), offset, parameter.sizes(),
+                 parameter.strides());
+}
+
+// Gives view the version counter of flat, as autograd views share that of
+// their base, so that writes through either bump the version of both.
+// Inference tensors do not track versions.
+void shareVersion(at::Tensor &view, const at::Tensor &flat) {
+  if (view.is_inference() || flat.is_inference()) {
+    return;
+  }
+  view.unsafeGetTensorImpl()->set_version_counter(
+      flat.unsafeGetTensorImpl()->version_counter());
+}
+
+bool isViewOf(const at::Tensor &parameter, const at::Tensor &flat) {
+  return parameter.has_storage() &&
+         parameter.storage().is_alias_of(flat.storage());
+}
+
+at::Tensor flatten(tensor *parameters, size_t count) {
+  TORCH_CHECK(count > 0, "no parameters to flatten");
+  const at::Tensor &first = *parameters[0];
+  std::vector<int64_t> offsets(count);
+  int64_t total = 0;
+  for (size_t i = 0; i < count; i++) {
+    const at::Tensor &parameter = *parameters[i];
+    TORCH_CHECK(parameter.scalar_type() == first.scalar_type() &&
+                    parameter.device() == first.device(),
+                "parameters must share dtype and device, got ",
+                parameter.scalar_type(), " on ", parameter.device(),
+                " and ", first.scalar_type(), " on ", first.device());
+    TORCH_CHECK(parameter.is_non_overlapping_and_dense(),
+                "parameter ", i, " is not dense");
+    offsets[i] = total;
+    total = alignUp(total + parameter.numel());
+  }
+
+  at::NoGradGuard noGrad;
+  at::Tensor flat = at::empty({total}, first.options());
+  for (size_t i = 0; i < count; i++) {
+    at::Tensor &parameter = *parameters[i];
+    viewOf(flat, offsets[i], parameter).copy_(parameter);
+    rebind(parameter, flat, offsets[i]);
+    shareVersion(parameter, flat);
+  }
+  return flat;
+}
+
+void moveFlat(at::Tensor &flat, tensor *parameters, size_t count,
+              const at::TensorOptions &options, bool nonBlocking) {
+  at::NoGradGuard noGrad;
+  at::Tensor moved = flat.to(options, nonBlocking);
+  if (moved.is_same(flat)) {
+    return;
+  }
+  for (size_t i = 0; i < count; i++) {
+    at::Tensor &parameter = *parameters[i];
+    if (isViewOf(parameter, flat)) {
+      // A new tensor rather than set_, which cannot change the dtype or
+      // the device of the parameter. Offsets are in elements, so they are
+      // the same in the moved buffer.
+      at::Tensor view = viewOf(moved, parameter.storage_offset(), parameter);
+      view.requires_grad_(parameter.requires_grad());
+      shareVersion(view, moved);
+      parameter = view;
+    } else {
+      // Replaced since it was flattened, e.g. by a layout conversion.
+      parameter = parameter.to(options, nonBlocking);
+    }
+  }
+  flat = moved;
+}
+
+} // namespace
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Copies parameters into one contiguous flat buffer and rebinds each of them
+// in place as a view into it, keeping its sizes and strides. Returns the
+// flat buffer.
+tensor torchffi_flatten_parameters(tensor *parameters, size_t count,
+                                   char **error) {
+  try {
+    return new torch::Tensor(flatten(parameters, count));
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+    return nullptr;
+  }
+}
+
+// Moves the flat buffer with a single allocation and copy and points the
+// parameters that were views into it at views into the moved buffer.
+void torchffi_flat_parameters_to(tensor flat, tensor *parameters,
+                                 size_t count, TensorOptions options,
+                                 bool nonBlocking, char **error) {
+  try {
+    moveFlat(*flat, parameters, count, torchffi_make_tensor_options(options),
+             nonBlocking);
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
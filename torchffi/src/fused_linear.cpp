@@ -0,0 +1,187 @@
+#include <torch/all.h>
+#include <torch_ffi.h>
+
+#include <ATen/core/dispatch/Dispatcher.h>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+void activate_(at::Tensor &t, uint8_t activation) {
+  switch (activation) {
+  case activationNone:
+    break;
+  case activationGelu:
+    at::gelu_(t, "none");
+    break;
+  case activationGeluTanh:
+    at::gelu_(t, "tanh");
+    break;
+  case activationSilu:
+    at::silu_(t);
+    break;
+  case activationQuickGelu:
+    t.mul_(at::sigmoid(t * 1.702));
+    break;
+  case activationRelu:
+    at::relu_(t);
+    break;
+  default:
+    TORCH_CHECK(false, "Unknown activation ", int(activation));
+  }
+}
+
+// oneDNN matmul with the bias and an elementwise op applied to each output
+// tile while it is still in cache. The .binary overload multiplies with
+// another tensor instead.
+const std::optional<c10::OperatorHandle> &linearPointwise() {
+  static const std::optional<c10::OperatorHandle> op =
+      c10::Dispatcher::singleton().findOp({"mkldnn::_linear_pointwise", ""});
+  return op;
+}
+
+const std::optional<c10::OperatorHandle> &linearPointwiseBinary() {
+  static const std::optional<c10::OperatorHandle> op =
+      c10::Dispatcher::singleton().findOp(
+          {"mkldnn::_linear_pointwise", "binary"});
+  return op;
+}
+
+// oneDNN post-op attribute and algorithm of an activation, if it has one.
+std::optional<std::pair<std::string, c10::IValue>>
+postOp(uint8_t activation) {
+  switch (activation) {
+  case activationNone:
+    return std::make_pair(std::string("none"), c10::IValue());
+  case activationGelu:
+    return std::make_pair(std::string("gelu"), c10::IValue("none"));
+  case activationGeluTanh:
+    return std::make_pair(std::string("gelu"), c10::IValue("tanh"));
+  case activationSilu:
+    return std::make_pair(std::string("swish"), c10::IValue());
+  case activationRelu:
+    return std::make_pair(std::string("relu"), c10::IValue());
+  default:
+    return std::nullopt;
+  }
+}
+
+bool canUsePostOps(const at::Tensor &input, const at::Tensor &weight,
+                   uint8_t activation) {
+  return at::hasMKLDNN() && input.is_cpu() && weight.is_cpu() &&
+         (input.scalar_type() == at::kFloat ||
+          input.scalar_type() == at::kBFloat16) &&
+         weight.scalar_type() == input.scalar_type() &&
+         !input.requires_grad() && !weight.requires_grad() &&
+         postOp(activation).has_value() &&
+         linearPointwise().has_value() && linearPointwiseBinary().has_value();
+}
+
+// rows @ weight^T + bias with the activation fused into the GEMM.
+at::Tensor linearPostOp(const at::Tensor &rows, const at::Tensor &weight,
+                        const std::optional<at::Tensor> &bias,
+                        uint8_t activation) {
+  auto [attr, algorithm] = *postOp(activation);
+  torch::jit::Stack stack{rows,
+                          weight,
+                          bias ? c10::IValue(*bias) : c10::IValue(),
+                          attr,
+                          c10::List<std::optional<at::Scalar>>(),
+                          algorithm};
+  linearPointwise()->callBoxed(stack);
+  return stack[0].toTensor();
+}
+
+// (rows @ weight^T + bias) * other in one GEMM.
+at::Tensor linearMul(const at::Tensor &rows, const at::Tensor &other,
+                     const at::Tensor &weight,
+                     const std::optional<at::Tensor> &bias) {
+  torch::jit::Stack stack{rows, other, weight,
+                          bias ? c10::IValue(*bias) : c10::IValue(),
+                          std::string("mul")};
+  linearPointwiseBinary()->callBoxed(stack);
+  return stack[0].toTensor();
+}
+
+std::optional<at::Tensor> optionalTensor(tensor t) {
+  return t ? std::optional<at::Tensor>(*t) : std::nullopt;
+}
+
+std::vector<int64_t> outputShape(const at::Tensor &input, int64_t features) {
+  std::vector<int64_t> shape(input.sizes().begin(), input.sizes().end());
+  shape.back() = features;
+  return shape;
+}
+
+} // namespace
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Applies the activation inside the GEMM on CPU through oneDNN post-ops, so
+// the output is written once instead of being written, then read and
+// written again by a separate pass. Elsewhere, and for activations oneDNN
+// has no post-op for, the activation runs in place after one GEMM.
+tensor torchffi_linear_activation(tensor input, tensor weight, tensor bias,
+                                  uint8_t activation, char **error) {
+  try {
+    int64_t features = weight->size(0);
+    if (canUsePostOps(*input, *weight, activation)) {
+      at::Tensor rows = input->reshape({-1, input->size(-1)}).contiguous();
+      at::Tensor out = linearPostOp(rows, weight->contiguous(),
+                                    optionalTensor(bias), activation);
+      return new torch::Tensor(out.view(outputShape(*input, features)));
+    }
+
+    at::Tensor out = at::linear(*input, *weight, optionalTensor(bias));
+    activate_(out, activation);
+    return new torch::Tensor(out);
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+    return nullptr;
+  }
+}
+
+// Gated linear unit: weight projects to [hidden, gate] halves and the
+// result is hidden * activation(gate), as in GEGLU/SwiGLU. On CPU the gate
+// half is one GEMM with the activation as a oneDNN post-op and the hidden
+// half a second GEMM whose post-op multiplies by the gate, so each half of
+// the weight is read once and the 2x-wide projection never exists.
+// Elsewhere the projection is one GEMM followed by in-place passes.
+tensor torchffi_linear_gated(tensor input, tensor weight, tensor bias,
+                             uint8_t activation, char **error) {
+  try {
+    TORCH_CHECK(weight->size(0) % 2 == 0,
+                "Gated linear needs an even number of output features");
+    int64_t features = weight->size(0) / 2;
+
+    if (canUsePostOps(*input, *weight, activation)) {
+      at::Tensor rows = input->reshape({-1, input->size(-1)}).contiguous();
+      at::Tensor hiddenWeight = weight->narrow(0, 0, features).contiguous();
+      at::Tensor gateWeight =
+          weight->narrow(0, features, features).contiguous();
+      std::optional<at::Tensor> hiddenBias, gateBias;
+      if (bias) {
+        hiddenBias = bias->narrow(0, 0, features).contiguous();
+        gateBias = bias->narrow(0, features, features).contiguous();
+      }
+      at::Tensor gate = linearPostOp(rows, gateWeight, gateBias, activation);
+      at::Tensor out = linearMul(rows, gate, hiddenWeight, hiddenBias);
+      return new torch::Tensor(out.view(outputShape(*input, features)));
+    }
+
+    at::Tensor projected =
+        at::linear(*input, *weight, optionalTensor(bias));
+    at::Tensor gate = projected.narrow(-1, features, features);
+    activate_(gate, activation);
+    return new torch::Tensor(projected.narrow(-1, 0, features).mul(gate));
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+    return nullptr;
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
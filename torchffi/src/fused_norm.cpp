@@ -0,0 +1,154 @@
+#include <torch/all.h>
+#include <torch_ffi.h>
+
+#include <ATen/OpMathType.h>
+#include <ATen/Parallel.h>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <torch/csrc/jit/frontend/tracer.h>
+
+namespace {
+
+// Adds residual into input and normalizes every row of normalizedSize
+// elements. Each row is read once from memory: the second pass over the
+// updated row hits cache.
+template <typename scalar_t>
+void addNormRowsCPU(at::Tensor &input, const at::Tensor &residual,
+                    at::Tensor &output, int64_t normalizedSize,
+                    const at::Tensor *weight, const at::Tensor *bias,
+                    double eps, bool rms) {
+  using acc_t = at::opmath_type<scalar_t>;
+  int64_t rows = input.numel() / normalizedSize;
+  scalar_t *x = input.data_ptr<scalar_t>();
+  const scalar_t *r = residual.data_ptr<scalar_t>();
+  scalar_t *y = output.data_ptr<scalar_t>();
+  const scalar_t *w = weight ? weight->data_ptr<scalar_t>() : nullptr;
+  const scalar_t *b = bias ? bias->data_ptr<scalar_t>() : nullptr;
+
+  at::parallel_for(0, rows, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t row = begin; row < end; row++) {
+      scalar_t *xRow = x + row * normalizedSize;
+      const scalar_t *rRow = r + row * normalizedSize;
+      scalar_t *yRow = y + row * normalizedSize;
+
+      double sum = 0;
+      double sumSquares = 0;
+      for (int64_t i = 0; i < normalizedSize; i++) {
+        scalar_t value = static_cast<scalar_t>(static_cast<acc_t>(xRow[i]) +
+                                               static_cast<acc_t>(rRow[i]));
+        xRow[i] = value;
+        double v = static_cast<double>(value);
+        sum += v;
+        sumSquares += v * v;
+      }
+
+      double mean = rms ? 0.0 : sum / normalizedSize;
+      double variance = sumSquares / normalizedSize - mean * mean;
+      acc_t rstd = acc_t(1.0 / std::sqrt(std::max(variance, 0.0) + eps));
+      acc_t shift = acc_t(mean);
+
+      for (int64_t i = 0; i < normalizedSize; i++) {
+        acc_t v = (static_cast<acc_t>(xRow[i]) - shift) * rstd;
+        if (w) {
+          v *= static_cast<acc_t>(w[i]);
+        }
+        if (b) {
+          v += static_cast<acc_t>(b[i]);
+        }
+        yRow[i] = static_cast<scalar_t>(v);
+      }
+    }
+  });
+}
+
+bool canUseCPUKernel(const at::Tensor &input, const at::Tensor &residual,
+                     int64_t normalizedSize, const at::Tensor *weight,
+                     const at::Tensor *bias) {
+  if (!input.is_cpu() || !input.is_contiguous() ||
+      !residual.is_contiguous() || !input.sizes().equals(residual.sizes()) ||
+      residual.scalar_type() != input.scalar_type() ||
+      !residual.is_cpu()) {
+    return false;
+  }
+  if (input.dim() == 0 || input.numel() % normalizedSize != 0) {
+    return false;
+  }
+  for (const at::Tensor *param : {weight, bias}) {
+    if (param && (!param->is_cpu() || !param->is_contiguous() ||
+                  param->numel() != normalizedSize ||
+                  param->scalar_type() != input.scalar_type())) {
+      return false;
+    }
+  }
+  switch (input.scalar_type()) {
+  case at::kFloat:
+  case at::kDouble:
+  case at::kHalf:
+  case at::kBFloat16:
+    return true;
+  default:
+    return false;
+  }
+}
+
+} // namespace
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+tensor torchffi_add_norm_(tensor input, tensor residual,
+                          int64_t normalizedSize, tensor weight, tensor bias,
+                          double *eps, uint8_t normType, char **error) {
+  try {
+    bool rms = normType == normTypeRMS;
+    // The tracer only records dispatched ops, so traced forwards take the
+    // unfused path.
+    if (canUseCPUKernel(*input, *residual, normalizedSize, weight, bias) &&
+        !torch::jit::tracer::isTracing()) {
+      at::Tensor output = at::empty_like(*input);
+      AT_DISPATCH_FLOATING_TYPES_AND2(
+          at::kHalf, at::kBFloat16, input->scalar_type(), "torchffi_add_norm_",
+          [&] {
+            double epsilon =
+                eps ? *eps
+                    : (rms ? double(std::numeric_limits<scalar_t>::epsilon())
+                           : 1e-5);
+            addNormRowsCPU<scalar_t>(*input, *residual, output, normalizedSize,
+                                     weight, bias, epsilon, rms);
+          });
+      return new torch::Tensor(output);
+    }
+
+    // Unfused fallback for other devices and layouts
+    input->add_(*residual);
+    at::Tensor rows = input->reshape({-1, normalizedSize});
+    at::Tensor output;
+    if (rms) {
+      output = at::rms_norm(
+          rows, {normalizedSize},
+          weight ? std::optional<at::Tensor>(weight->reshape({-1}))
+                 : std::nullopt,
+          eps ? std::optional<double>(*eps) : std::nullopt);
+      if (bias) {
+        output.add_(bias->reshape({-1}));
+      }
+    } else {
+      output = at::layer_norm(
+          rows, {normalizedSize},
+          weight ? std::optional<at::Tensor>(weight->reshape({-1}))
+                 : std::nullopt,
+          bias ? std::optional<at::Tensor>(bias->reshape({-1})) : std::nullopt,
+          eps ? *eps : 1e-5);
+    }
+    return new torch::Tensor(output.view(input->sizes()));
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+    return nullptr;
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,102 @@
+#include <torch/all.h>
+#include <torch_ffi.h>
+
+#include <cstring>
+#include <sstream>
+#include <torch/csrc/jit/frontend/tracer.h>
+#include <torch/script.h>
+
+// A forward recorded by the tracer and wrapped as the forward method of a
+// module, so that it can be frozen and run by the graph executor.
+struct TracedGraph_t {
+  torch::jit::Module module;
+  size_t numInputs;
+};
+
+namespace {
+
+torch::jit::Module makeModule(std::shared_ptr<torch::jit::Graph> graph) {
+  torch::jit::Module module("__torch__.torchffi.TracedForward");
+  // freeze() and eval() expect the attribute every scripted module has.
+  module.register_attribute("training", c10::BoolType::get(), false);
+  graph->insertInput(0, "self")->setType(module._ivalue()->type());
+  auto cu = module._ivalue()->compilation_unit();
+  torch::jit::Function *forward = cu->create_function(
+      c10::QualifiedName(*module.type()->name(), "forward"), graph);
+  module.type()->addMethod(forward);
+  return module;
+}
+
+} // namespace
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+TracedGraph torchffi_graph_trace(tensor *inputs, size_t ninputs,
+                                 TraceForward forward, bool optimize,
+                                 char **error) {
+  try {
+    torch::NoGradGuard noGrad;
+    torch::jit::Stack stack;
+    stack.reserve(ninputs);
+    for (size_t i = 0; i < ninputs; i++) {
+      stack.emplace_back(*inputs[i]);
+    }
+    // The forward is run by the caller's isolate on this thread while the
+    // tracer is active, so every ATen op it dispatches is recorded.
+    // Tensors that are not inputs, such as weights, become constants.
+    auto state = torch::jit::tracer::trace(
+        std::move(stack),
+        [forward](torch::jit::Stack) -> torch::jit::Stack {
+          tensor result = nullptr;
+          forward(&result);
+          TORCH_CHECK(result != nullptr, "Traced forward failed");
+          return {*result};
+        },
+        [](const at::Tensor &) { return std::string(); }).first;
+
+    torch::jit::Module module = makeModule(state->graph);
+    if (optimize) {
+      // Folds constants and conv-batchnorm pairs, then fuses ops for
+      // inference, e.g. conv with oneDNN where available.
+      module = torch::jit::freeze(module);
+      torch::jit::optimize_for_inference(module);
+    }
+    return new TracedGraph_t{std::move(module), ninputs};
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+    return nullptr;
+  }
+}
+
+void torchffi_graph_delete(TracedGraph graph) { delete graph; }
+
+tensor torchffi_graph_run(TracedGraph graph, tensor *inputs, size_t ninputs,
+                          char **error) {
+  try {
+    TORCH_CHECK(ninputs == graph->numInputs, "Graph takes ", graph->numInputs,
+                " inputs, got ", ninputs);
+    torch::NoGradGuard noGrad;
+    std::vector<c10::IValue> args;
+    args.reserve(ninputs);
+    for (size_t i = 0; i < ninputs; i++) {
+      args.emplace_back(*inputs[i]);
+    }
+    return new torch::Tensor(graph->module.forward(args).toTensor());
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+    return nullptr;
+  }
+}
+
+// Text of the forward graph, allocated with malloc.
+char *torchffi_graph_dump(TracedGraph graph) {
+  std::ostringstream out;
+  out << *graph->module.get_method("forward").graph();
+  return strdup(out.str().c_str());
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,67 @@
+#include <torch/all.h>
+#include <torch_ffi.h>
+
+#include <cstring>
+
+// Split group normalization: statistics are reduced separately from the
+// normalization so that they can be accumulated over several spatial tiles
+// and applied to each tile afterwards.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Writes the per (batch, group) sum and sum of squares of input in double
+// precision, both of shape [N, numGroups].
+void torchffi_group_norm_stats(tensor input, int64_t numGroups, tensor *sums,
+                               tensor *sumSquares, char **error) {
+  try {
+    at::Tensor grouped = input->reshape({input->size(0), numGroups, -1});
+    at::Tensor sum = at::sum(grouped, {2}, false, at::kDouble);
+    at::Tensor norm = at::linalg_vector_norm(grouped, 2, {2}, false,
+                                             at::kDouble);
+    *sums = new torch::Tensor(sum);
+    *sumSquares = new torch::Tensor(norm.square_());
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+  }
+}
+
+// Normalizes input with the given [N, numGroups] mean and reciprocal
+// standard deviation, folding them and the affine parameters into a
+// per-channel scale and shift applied in a single pass.
+tensor torchffi_group_norm_apply(tensor input, int64_t numGroups, tensor mean,
+                                 tensor rstd, tensor weight, tensor bias,
+                                 char **error) {
+  try {
+    int64_t batch = input->size(0);
+    int64_t channels = input->size(1);
+    int64_t groupSize = channels / numGroups;
+    // [N, C]
+    at::Tensor scale = rstd->to(at::kFloat).repeat_interleave(groupSize, 1);
+    at::Tensor shift =
+        -mean->to(at::kFloat).repeat_interleave(groupSize, 1) * scale;
+    if (weight) {
+      at::Tensor w = weight->to(at::kFloat).view({1, channels});
+      scale = scale * w;
+      shift = shift * w;
+    }
+    if (bias) {
+      shift = shift + bias->to(at::kFloat).view({1, channels});
+    }
+
+    std::vector<int64_t> shape(input->dim(), 1);
+    shape[0] = batch;
+    shape[1] = channels;
+    scale = scale.to(input->scalar_type()).view(shape);
+    shift = shift.to(input->scalar_type()).view(shape);
+    return new torch::Tensor(at::addcmul(shift, *input, scale));
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+    return nullptr;
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
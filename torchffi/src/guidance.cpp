@@ -0,0 +1,66 @@
+#include <torch/all.h>
+#include <torch_ffi.h>
+
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec/vec.h>
+#include <cstring>
+#include <torch/csrc/jit/frontend/tracer.h>
+
+namespace {
+
+// Reads the unconditional half [0, n) and the conditional half [n, 2n) of
+// the batched model output in place; only the result is allocated.
+at::Tensor guidanceCombine(const at::Tensor &output, double scale) {
+  TORCH_CHECK(output.dim() > 0 && output.size(0) % 2 == 0,
+              "guidance combine expects an even batch dimension, got ",
+              output.sizes());
+  int64_t half = output.size(0) / 2;
+  at::Tensor uncond = output.narrow(0, 0, half);
+  at::Tensor cond = output.narrow(0, half, half);
+  // lerp also while tracing, which cannot record the loop below.
+  if (!output.is_cpu() || !output.is_contiguous() ||
+      output.scalar_type() != at::kFloat || torch::jit::tracer::isTracing()) {
+    return at::lerp(uncond, cond, scale);
+  }
+
+  at::Tensor result = at::empty(uncond.sizes(), uncond.options());
+  using Vec = at::vec::Vectorized<float>;
+  const float *uData = output.data_ptr<float>();
+  const float *cData = uData + uncond.numel();
+  float *rData = result.data_ptr<float>();
+  float s = scale;
+
+  at::parallel_for(0, result.numel(), 32768, [&](int64_t begin, int64_t end) {
+    int64_t i = begin;
+    const Vec vs(s);
+    for (; i + Vec::size() <= end; i += Vec::size()) {
+      Vec u = Vec::loadu(uData + i);
+      at::vec::fmadd(Vec::loadu(cData + i) - u, vs, u).store(rData + i);
+    }
+    for (; i < end; i++) {
+      rData[i] = uData[i] + s * (cData[i] - uData[i]);
+    }
+  });
+  return result;
+}
+
+} // namespace
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// uncond + scale * (cond - uncond) over the two halves of a batched
+// classifier-free guidance output.
+tensor torchffi_guidance_combine(tensor output, double scale, char **error) {
+  try {
+    return new torch::Tensor(guidanceCombine(*output, scale));
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+    return nullptr;
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,212 @@
+#include <torch/all.h>
+#include <torch_ffi.h>
+
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec/vec.h>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+using Vec = at::vec::Vectorized<float>;
+
+// Per-channel affine map v * scale[c] + shift[c] from uint8 to float. With
+// null mean and std the result is in [0, 1].
+void channelAffine(int64_t channels, const float *mean, const float *std,
+                   std::vector<float> &scale, std::vector<float> &shift) {
+  scale.resize(channels);
+  shift.resize(channels);
+  for (int64_t c = 0; c < channels; c++) {
+    float m = mean ? mean[c] : 0.0f;
+    float s = std ? std[c] : 1.0f;
+    scale[c] = 1.0f / (255.0f * s);
+    shift[c] = -m / s;
+  }
+}
+
+// Loads Vec::size() values starting at src with the given element stride
+// and widens them to float.
+inline Vec loadWiden(const uint8_t *src, int64_t stride) {
+  float buffer[Vec::size()];
+  for (int64_t k = 0; k < Vec::size(); k++) {
+    buffer[k] = src[k * stride];
+  }
+  return Vec::loadu(buffer);
+}
+
+// uint8 HWC rows to planar NCHW, one pass per output element.
+void hwcToNchw(const uint8_t *src, float *dst, int64_t batch, int64_t height,
+               int64_t width, int64_t channels, const float *scale,
+               const float *shift) {
+  int64_t plane = height * width;
+  at::parallel_for(0, batch * height, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t row = begin; row < end; row++) {
+      int64_t n = row / height;
+      int64_t y = row % height;
+      const uint8_t *in = src + row * width * channels;
+      for (int64_t c = 0; c < channels; c++) {
+        float *out = dst + (n * channels + c) * plane + y * width;
+        const Vec vScale(scale[c]), vShift(shift[c]);
+        int64_t x = 0;
+        for (; x + Vec::size() <= width; x += Vec::size()) {
+          at::vec::fmadd(loadWiden(in + x * channels + c, channels), vScale,
+                         vShift)
+              .store(out + x);
+        }
+        for (; x < width; x++) {
+          out[x] = in[x * channels + c] * scale[c] + shift[c];
+        }
+      }
+    }
+  });
+}
+
+// uint8 HWC rows to NHWC, which keeps the interleaved order. The channel of
+// element i is i % channels, so the scale/shift vectors repeat with period
+// channels in units of Vec::size().
+void hwcToNhwc(const uint8_t *src, float *dst, int64_t batch, int64_t height,
+               int64_t width, int64_t channels, const float *scale,
+               const float *shift) {
+  int64_t rowSize = width * channels;
+  std::vector<Vec> scales, shifts;
+  for (int64_t phase = 0; phase < channels; phase++) {
+    float s[Vec::size()], b[Vec::size()];
+    for (int64_t k = 0; k < Vec::size(); k++) {
+      s[k] = scale[(phase + k) % channels];
+      b[k] = shift[(phase + k) % channels];
+    }
+    scales.push_back(Vec::loadu(s));
+    shifts.push_back(Vec::loadu(b));
+  }
+  at::parallel_for(0, batch * height, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t row = begin; row < end; row++) {
+      const uint8_t *in = src + row * rowSize;
+      float *out = dst + row * rowSize;
+      int64_t i = 0;
+      for (; i + Vec::size() <= rowSize; i += Vec::size()) {
+        int64_t phase = i % channels;
+        at::vec::fmadd(loadWiden(in + i, 1), scales[phase], shifts[phase])
+            .store(out + i);
+      }
+      for (; i < rowSize; i++) {
+        out[i] = in[i] * scale[i % channels] + shift[i % channels];
+      }
+    }
+  });
+}
+
+at::Tensor imageFromUint8(const uint8_t *data, int64_t batch, int64_t height,
+                          int64_t width, int64_t channels, const float *mean,
+                          const float *std, bool channelsLast) {
+  TORCH_CHECK(batch > 0 && height > 0 && width > 0 && channels > 0,
+              "invalid image shape [", batch, ", ", height, ", ", width, ", ",
+              channels, "]");
+  std::vector<float> scale, shift;
+  channelAffine(channels, mean, std, scale, shift);
+  at::Tensor image;
+  if (channelsLast) {
+    image = at::empty({batch, channels, height, width},
+                      at::TensorOptions()
+                          .dtype(at::kFloat)
+                          .memory_format(at::MemoryFormat::ChannelsLast));
+    hwcToNhwc(data, image.data_ptr<float>(), batch, height, width, channels,
+              scale.data(), shift.data());
+  } else {
+    image = at::empty({batch, channels, height, width}, at::kFloat);
+    hwcToNchw(data, image.data_ptr<float>(), batch, height, width, channels,
+              scale.data(), shift.data());
+  }
+  return image;
+}
+
+inline uint8_t quantize(float v) {
+  return static_cast<uint8_t>(std::nearbyint(std::min(std::max(v, 0.0f),
+                                                      255.0f)));
+}
+
+// Float CPU [N, C, H, W] of any strides to uint8 NHWC, mapping [low, high] to
+// [0, 255] with clamping and round-to-nearest.
+void imageToUint8(const at::Tensor &input, uint8_t *out, double low,
+                  double high) {
+  TORCH_CHECK(input.dim() == 4, "expected a [N, C, H, W] image, got ",
+              input.sizes());
+  // Called as a leaf from Dart, so a device copy must happen before.
+  TORCH_CHECK(input.is_cpu(), "expected a CPU image, got ", input.device());
+  at::Tensor image = input;
+  if (image.scalar_type() != at::kFloat) {
+    image = image.to(at::kFloat);
+  }
+  int64_t batch = image.size(0), channels = image.size(1);
+  int64_t height = image.size(2), width = image.size(3);
+  int64_t sN = image.stride(0), sC = image.stride(1);
+  int64_t sH = image.stride(2), sW = image.stride(3);
+  const float *src = image.data_ptr<float>();
+  float scale = 255.0 / (high - low);
+  float shift = -low * scale;
+
+  at::parallel_for(0, batch * height, 1, [&](int64_t begin, int64_t end) {
+    const Vec vScale(scale), vShift(shift), zero(0.0f), max(255.0f);
+    float buffer[Vec::size()];
+    for (int64_t row = begin; row < end; row++) {
+      int64_t n = row / height;
+      int64_t y = row % height;
+      uint8_t *dst = out + row * width * channels;
+      for (int64_t c = 0; c < channels; c++) {
+        const float *in = src + n * sN + c * sC + y * sH;
+        int64_t x = 0;
+        if (sW == 1) {
+          for (; x + Vec::size() <= width; x += Vec::size()) {
+            Vec v = at::vec::fmadd(Vec::loadu(in + x), vScale, vShift);
+            at::vec::clamp(v, zero, max).round().store(buffer);
+            for (int64_t k = 0; k < Vec::size(); k++) {
+              dst[(x + k) * channels + c] = static_cast<uint8_t>(buffer[k]);
+            }
+          }
+        }
+        for (; x < width; x++) {
+          dst[x * channels + c] = quantize(in[x * sW] * scale + shift);
+        }
+      }
+    }
+  });
+}
+
+} // namespace
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Converts a uint8 [N, H, W, C] buffer to a float [N, C, H, W] tensor with
+// (v / 255 - mean[c]) / std[c], in NCHW or channels-last memory format.
+// mean and std may be null.
+tensor torchffi_image_from_uint8(const uint8_t *data, int64_t batch,
+                                 int64_t height, int64_t width,
+                                 int64_t channels, const float *mean,
+                                 const float *std, bool channelsLast,
+                                 char **error) {
+  try {
+    return new torch::Tensor(imageFromUint8(data, batch, height, width,
+                                            channels, mean, std,
+                                            channelsLast));
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+    return nullptr;
+  }
+}
+
+// Writes a float [N, C, H, W] image with values in [low, high] to out as
+// clamped, rounded uint8 [N, H, W, C].
+void torchffi_image_to_uint8(tensor image, uint8_t *out, double low,
+                             double high, char **error) {
+  try {
+    imageToUint8(*image, out, low, high);
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
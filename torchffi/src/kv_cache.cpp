@@ -0,0 +1,125 @@
+#include <torch/all.h>
+#include <torch_ffi.h>
+
+#include <cstring>
+
+namespace {
+
+void checkLayer(KVCache cache, int64_t layer) {
+  const int64_t numLayers = int64_t(cache->lengths.size());
+  TORCH_CHECK(layer >= 0 && layer < numLayers, "layer ", layer,
+              " out of range for a cache of ", numLayers, " layers");
+}
+
+// Entries must match the stored tensor in every dimension but seqDim.
+void checkEntries(const char *name, const at::Tensor &entries,
+                  const at::Tensor &stored, int64_t seqDim) {
+  TORCH_CHECK(entries.dim() == stored.dim(), name, " has ", entries.dim(),
+              " dimensions, the cache has ", stored.dim());
+  for (int64_t d = 0; d < stored.dim(); d++) {
+    TORCH_CHECK(d == seqDim || entries.size(d) == stored.size(d), name,
+                " has shape ", entries.sizes(), ", the cache has ",
+                stored.sizes(), " outside of dimension ", seqDim);
+  }
+}
+
+} // namespace
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+KVCache torchffi_kv_cache_new(int64_t numLayers, int64_t *sizes, size_t ndims,
+                              int64_t seqDim, TensorOptions options) {
+  at::TensorOptions tensorOptions = torchffi_make_tensor_options(options);
+  KVCache cache = new KVCache_t();
+  cache->seqDim = seqDim < 0 ? seqDim + int64_t(ndims) : seqDim;
+  for (int64_t i = 0; i < numLayers; i++) {
+    cache->keys.push_back(
+        at::empty(at::IntArrayRef(sizes, ndims), tensorOptions));
+    cache->values.push_back(
+        at::empty(at::IntArrayRef(sizes, ndims), tensorOptions));
+    cache->lengths.push_back(0);
+  }
+  return cache;
+}
+
+void torchffi_kv_cache_delete(KVCache cache) { delete cache; }
+
+int64_t torchffi_kv_cache_length(KVCache cache, int64_t layer,
+                                 char **error) {
+  try {
+    checkLayer(cache, layer);
+    return cache->lengths[layer];
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+    return 0;
+  }
+}
+
+int64_t torchffi_kv_cache_capacity(KVCache cache, int64_t layer,
+                                   char **error) {
+  try {
+    checkLayer(cache, layer);
+    return cache->keys[layer].size(cache->seqDim);
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+    return 0;
+  }
+}
+
+void torchffi_kv_cache_update(KVCache cache, int64_t layer, tensor key,
+                              tensor value, tensor *keysOut, tensor *valuesOut,
+                              char **error) {
+  try {
+    checkLayer(cache, layer);
+    int64_t seqDim = cache->seqDim;
+    int64_t length = cache->lengths[layer];
+    at::Tensor &keys = cache->keys[layer];
+    at::Tensor &values = cache->values[layer];
+    checkEntries("key", *key, keys, seqDim);
+    checkEntries("value", *value, values, seqDim);
+    int64_t count = key->size(seqDim);
+    TORCH_CHECK(value->size(seqDim) == count, "key has ", count,
+                " entries, value has ", value->size(seqDim));
+
+    int64_t capacity = keys.size(seqDim);
+    if (length + count > capacity) {
+      // Grow geometrically so that appends stay amortized O(1).
+      int64_t newCapacity = std::max(capacity * 2, length + count);
+      std::vector<int64_t> keySizes = keys.sizes().vec();
+      keySizes[seqDim] = newCapacity;
+      std::vector<int64_t> valueSizes = values.sizes().vec();
+      valueSizes[seqDim] = newCapacity;
+      at::Tensor newKeys = at::empty(keySizes, keys.options());
+      at::Tensor newValues = at::empty(valueSizes, values.options());
+      newKeys.narrow(seqDim, 0, length).copy_(keys.narrow(seqDim, 0, length));
+      newValues.narrow(seqDim, 0, length)
+          .copy_(values.narrow(seqDim, 0, length));
+      keys = newKeys;
+      values = newValues;
+    }
+
+    keys.narrow(seqDim, length, count).copy_(*key);
+    values.narrow(seqDim, length, count).copy_(*value);
+    length += count;
+    cache->lengths[layer] = length;
+
+    *keysOut = new torch::Tensor(keys.narrow(seqDim, 0, length));
+    *valuesOut = new torch::Tensor(values.narrow(seqDim, 0, length));
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+  }
+}
+
+void torchffi_kv_cache_truncate(KVCache cache, int64_t length) {
+  // Rolled back entries are simply overwritten by the next update.
+  length = std::max<int64_t>(length, 0);
+  for (size_t i = 0; i < cache->lengths.size(); i++) {
+    cache->lengths[i] = std::min(cache->lengths[i], length);
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,93 @@
+#include <torch/all.h>
+#include <torch_ffi.h>
+
+#include <cstring>
+
+namespace {
+
+// output += scale * (input @ down^T) @ up^T, where down is [rank, in] and up
+// is [out, rank]. The rank-sized intermediate is the only allocation; the
+// second product accumulates into output.
+void loraAdd_(at::Tensor &output, const at::Tensor &input,
+              const at::Tensor &down, const at::Tensor &up, double scale) {
+  TORCH_CHECK(output.is_contiguous(), "LoRA output must be contiguous");
+  int64_t inFeatures = input.size(-1);
+  int64_t outFeatures = output.size(-1);
+  TORCH_CHECK(down.dim() == 2 && down.size(1) == inFeatures,
+              "LoRA down projection must be [rank, ", inFeatures, "], got ",
+              down.sizes());
+  TORCH_CHECK(up.dim() == 2 && up.size(0) == outFeatures &&
+                  up.size(1) == down.size(0),
+              "LoRA up projection must be [", outFeatures, ", ", down.size(0),
+              "], got ", up.sizes());
+  at::Tensor hidden = at::mm(input.reshape({-1, inFeatures}), down.t());
+  at::Tensor output2d = output.view({-1, outFeatures});
+  output2d.addmm_(hidden, up.t(), 1, scale);
+}
+
+// Per-row adapters: down is [adapters, rank, in], up is [adapters, out, rank]
+// and scales is [adapters]. Row b of the batch uses adapter indices[b], or
+// none if it is negative.
+void loraAddBatched_(at::Tensor &output, const at::Tensor &input,
+                     const at::Tensor &down, const at::Tensor &up,
+                     const at::Tensor &scales, const at::Tensor &indices) {
+  TORCH_CHECK(output.is_contiguous(), "LoRA output must be contiguous");
+  int64_t batch = input.size(0);
+  int64_t inFeatures = input.size(-1);
+  int64_t outFeatures = output.size(-1);
+  TORCH_CHECK(indices.dim() == 1 && indices.size(0) == batch,
+              "expected one adapter index per batch row, got ",
+              indices.sizes());
+  TORCH_CHECK(down.dim() == 3 && down.size(2) == inFeatures,
+              "LoRA down projections must be [adapters, rank, ", inFeatures,
+              "], got ", down.sizes());
+  TORCH_CHECK(up.dim() == 3 && up.size(1) == outFeatures &&
+                  up.size(2) == down.size(1),
+              "LoRA up projections must be [adapters, ", outFeatures, ", ",
+              down.size(1), "], got ", up.sizes());
+
+  at::Tensor rowIndices = indices.to(down.device(), at::kLong);
+  at::Tensor active = rowIndices.ge(0);
+  rowIndices = rowIndices.clamp_min(0);
+  // Only the small per-row [rank, in] and [out, rank] matrices are gathered.
+  at::Tensor rowDown = down.index_select(0, rowIndices);
+  at::Tensor rowUp = up.index_select(0, rowIndices);
+  at::Tensor rowScales = scales.to(down.device(), input.scalar_type())
+                             .index_select(0, rowIndices)
+                             .mul_(active.to(input.scalar_type()));
+
+  at::Tensor hidden =
+      at::bmm(input.reshape({batch, -1, inFeatures}), rowDown.transpose(1, 2));
+  hidden.mul_(rowScales.view({batch, 1, 1}));
+  at::Tensor output3d = output.view({batch, -1, outFeatures});
+  output3d.baddbmm_(hidden, rowUp.transpose(1, 2));
+}
+
+} // namespace
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void torchffi_lora_add_(tensor output, tensor input, tensor down, tensor up,
+                        double scale, char **error) {
+  try {
+    loraAdd_(*output, *input, *down, *up, scale);
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+  }
+}
+
+void torchffi_lora_add_batched_(tensor output, tensor input, tensor down,
+                                tensor up, tensor scales, tensor indices,
+                                char **error) {
+  try {
+    loraAddBatched_(*output, *input, *down, *up, *scales, *indices);
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
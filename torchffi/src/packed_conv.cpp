@@ -0,0 +1,106 @@
+#include <torch/all.h>
+#include <torch_ffi.h>
+
+#include <ATen/core/dispatch/Dispatcher.h>
+#include <cstring>
+#include <memory>
+
+namespace {
+
+// Takes a dense input, contiguous or channels-last, and a weight reordered
+// by mkldnn_reorder_conv2d_weight, and returns a dense output in the memory
+// format of the input, so only the weight lives in oneDNN layout.
+const std::optional<c10::OperatorHandle> &convolutionPointwise() {
+  static const std::optional<c10::OperatorHandle> op =
+      c10::Dispatcher::singleton().findOp(
+          {"mkldnn::_convolution_pointwise", ""});
+  return op;
+}
+
+} // namespace
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Reorders the weight into the blocked oneDNN layout best suited for inputs
+// of inputSizes once, so that forward calls skip the per-call reorder.
+// Activations stay dense in their own memory format; only the weight is
+// blocked. When oneDNN cannot be used the handle keeps the dense weight and
+// forwards to the regular convolution.
+PackedConv2d torchffi_conv2d_prepack(tensor weights, tensor bias,
+                                     int64_t *strides, int64_t *paddings,
+                                     int64_t *dilations, int64_t groups,
+                                     int64_t *inputSizes, size_t ndims,
+                                     char **error) {
+  try {
+    std::unique_ptr<PackedConv2d_t> packed(new PackedConv2d_t());
+    packed->strides.assign(strides, strides + 2);
+    packed->paddings.assign(paddings, paddings + 2);
+    packed->dilations.assign(dilations, dilations + 2);
+    packed->groups = groups;
+    packed->mkldnn = at::hasMKLDNN() && weights->is_cpu() &&
+                     weights->scalar_type() == at::kFloat &&
+                     !weights->requires_grad() &&
+                     convolutionPointwise().has_value();
+    if (!packed->mkldnn) {
+      packed->weight = *weights;
+      if (bias) {
+        packed->bias = *bias;
+      }
+      return packed.release();
+    }
+
+    packed->weight = at::mkldnn_reorder_conv2d_weight(
+        weights->to_mkldnn(), packed->paddings, packed->strides,
+        packed->dilations, groups, at::IntArrayRef(inputSizes, ndims));
+    if (bias) {
+      packed->bias = bias->contiguous();
+    }
+    return packed.release();
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+    return nullptr;
+  }
+}
+
+void torchffi_conv2d_packed_delete(PackedConv2d packed) { delete packed; }
+
+bool torchffi_conv2d_packed_is_mkldnn(PackedConv2d packed) {
+  return packed->mkldnn;
+}
+
+tensor torchffi_conv2d_packed(PackedConv2d packed, tensor input,
+                              char **error) {
+  try {
+    if (!packed->mkldnn) {
+      at::Tensor output =
+          at::conv2d(*input, packed->weight, packed->bias, packed->strides,
+                     packed->paddings, packed->dilations, packed->groups);
+      return new torch::Tensor(output);
+    }
+
+    at::Tensor dense = input->contiguous(input->suggest_memory_format());
+    torch::jit::Stack stack{dense,
+                            packed->weight,
+                            packed->bias ? c10::IValue(*packed->bias)
+                                         : c10::IValue(),
+                            packed->paddings,
+                            packed->strides,
+                            packed->dilations,
+                            packed->groups,
+                            std::string("none"),
+                            c10::List<std::optional<at::Scalar>>(),
+                            c10::IValue()};
+    convolutionPointwise()->callBoxed(stack);
+    at::Tensor output = stack[0].toTensor();
+    return new torch::Tensor(output);
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+    return nullptr;
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,92 @@
+#include <torch/all.h>
+#include <torch_ffi.h>
+
+#include <ATen/core/dispatch/Dispatcher.h>
+#include <cstring>
+#include <memory>
+
+namespace {
+
+// Takes a dense input and a weight reordered by mkldnn_reorder_linear_weight
+// and returns a dense output, so only the weight lives in oneDNN layout.
+const std::optional<c10::OperatorHandle> &linearPointwise() {
+  static const std::optional<c10::OperatorHandle> op =
+      c10::Dispatcher::singleton().findOp({"mkldnn::_linear_pointwise", ""});
+  return op;
+}
+
+} // namespace
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Reorders the [out, in] weight into the blocked oneDNN layout best suited
+// for batchSize rows once, so that the GEMM does not reorder it on every
+// call. A batchSize of 0 lets oneDNN pick the layout. Weights oneDNN cannot
+// take keep the dense layout and go through the regular linear.
+PackedLinear torchffi_linear_prepack(tensor weight, tensor bias,
+                                     int64_t batchSize, char **error) {
+  try {
+    std::unique_ptr<PackedLinear_t> packed(new PackedLinear_t());
+    packed->outFeatures = weight->size(0);
+    packed->mkldnn = at::hasMKLDNN() && weight->is_cpu() &&
+                     weight->scalar_type() == at::kFloat &&
+                     !weight->requires_grad() &&
+                     linearPointwise().has_value();
+    if (!packed->mkldnn) {
+      packed->weight = *weight;
+      if (bias) {
+        packed->bias = *bias;
+      }
+      return packed.release();
+    }
+
+    packed->weight = at::mkldnn_reorder_linear_weight(
+        weight->contiguous(),
+        batchSize > 0 ? std::optional<int64_t>(batchSize) : std::nullopt);
+    if (bias) {
+      packed->bias = bias->contiguous();
+    }
+    return packed.release();
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+    return nullptr;
+  }
+}
+
+void torchffi_linear_packed_delete(PackedLinear packed) { delete packed; }
+
+bool torchffi_linear_packed_is_mkldnn(PackedLinear packed) {
+  return packed->mkldnn;
+}
+
+tensor torchffi_linear_packed(PackedLinear packed, tensor input,
+                              char **error) {
+  try {
+    if (!packed->mkldnn) {
+      return new torch::Tensor(
+          at::linear(*input, packed->weight, packed->bias));
+    }
+
+    std::vector<int64_t> shape(input->sizes().begin(), input->sizes().end());
+    shape.back() = packed->outFeatures;
+    at::Tensor rows = input->reshape({-1, input->size(-1)}).contiguous();
+    torch::jit::Stack stack{rows,
+                            packed->weight,
+                            packed->bias ? c10::IValue(*packed->bias)
+                                         : c10::IValue(),
+                            std::string("none"),
+                            c10::List<std::optional<at::Scalar>>(),
+                            c10::IValue()};
+    linearPointwise()->callBoxed(stack);
+    return new torch::Tensor(stack[0].toTensor().view(shape));
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+    return nullptr;
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,148 @@
+#include <torch/all.h>
+#include <torch_ffi.h>
+
+#include <ATen/DeviceAccelerator.h>
+#include <c10/core/Allocator.h>
+#include <c10/util/ThreadLocalDebugInfo.h>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <cstring>
+
+namespace {
+
+// Layout of the int64 record shared with Dart, one per active module.
+enum Field : int {
+  kStartNs = 0,
+  kBytesIn = 1,
+  kParentPeak = 2,
+  kEndNs = 3,
+  kBytesOut = 4,
+  kPeak = 5,
+};
+
+inline int64_t nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Receives the allocation reports that the CPU and CUDA allocators send to
+// the profiler slot of the current thread. Bytes are counted from the
+// moment tracking was enabled, so they can go negative when tensors
+// allocated before are freed.
+class MemoryTracker : public c10::MemoryReportingInfoBase {
+public:
+  std::atomic<bool> enabled{false};
+  // Number of profilers that asked for tracking.
+  std::atomic<int> users{0};
+  std::atomic<int64_t> current{0};
+  std::atomic<int64_t> peak{0};
+
+  void reportMemoryUsage(void *ptr, int64_t size, size_t totalAllocated,
+                         size_t totalReserved, c10::Device device) override {
+    if (!enabled.load(std::memory_order_relaxed)) return;
+    const int64_t now =
+        current.fetch_add(size, std::memory_order_relaxed) + size;
+    int64_t previous = peak.load(std::memory_order_relaxed);
+    while (now > previous &&
+           !peak.compare_exchange_weak(previous, now,
+                                       std::memory_order_relaxed)) {
+    }
+  }
+
+  bool memoryProfilingEnabled() const override {
+    return enabled.load(std::memory_order_relaxed);
+  }
+};
+
+std::shared_ptr<MemoryTracker> &tracker() {
+  static auto instance = std::make_shared<MemoryTracker>();
+  return instance;
+}
+
+// Installs the tracker in the profiler slot of the calling thread for the
+// outermost profiled forward and restores the slot when it exits, so the
+// tracker never outlives a forward in a slot that libtorch's own profiler
+// reads as a ProfilerStateBase. Not installed if the slot is already taken,
+// e.g. by the autograd profiler.
+struct ThreadScope {
+  int depth = 0;
+  std::optional<c10::DebugInfoGuard> guard;
+};
+
+ThreadScope &threadScope() {
+  thread_local ThreadScope scope;
+  return scope;
+}
+
+} // namespace
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int64_t torchffi_profiler_now_ns() { return nowNs(); }
+
+// Reference counted so that one profiler stopping does not stop tracking
+// for the others. Counters restart only when the first one starts.
+void torchffi_profiler_track_memory(bool enabled) {
+  auto &t = tracker();
+  if (enabled) {
+    if (t->users.fetch_add(1) == 0) {
+      t->current.store(0);
+      t->peak.store(0);
+    }
+    t->enabled.store(true);
+    return;
+  }
+  int users = t->users.load();
+  while (users > 0 && !t->users.compare_exchange_weak(users, users - 1)) {
+  }
+  if (users == 1) t->enabled.store(false);
+}
+
+// Waits for the work queued on the current accelerator, if any, so that
+// wall time covers kernels and not just their launch.
+void torchffi_profiler_synchronize(char **error) {
+  try {
+    if (at::accelerator::getAccelerator(false).has_value()) {
+      at::accelerator::synchronizeDevice(at::accelerator::getDeviceIndex());
+    }
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+  }
+}
+
+void torchffi_profiler_enter(int64_t *record) {
+  auto &t = tracker();
+  ThreadScope &scope = threadScope();
+  if (scope.depth++ == 0 && t->enabled.load(std::memory_order_relaxed) &&
+      !c10::ThreadLocalDebugInfo::get(c10::DebugInfoKind::PROFILER_STATE)) {
+    scope.guard.emplace(c10::DebugInfoKind::PROFILER_STATE, t);
+  }
+  const int64_t current = t->current.load(std::memory_order_relaxed);
+  record[kBytesIn] = current;
+  // The peak of this module starts from what is allocated on entry; the
+  // parent's peak is restored on exit.
+  record[kParentPeak] = t->peak.exchange(current, std::memory_order_relaxed);
+  record[kStartNs] = nowNs();
+}
+
+void torchffi_profiler_exit(int64_t *record) {
+  record[kEndNs] = nowNs();
+  auto &t = tracker();
+  record[kBytesOut] = t->current.load(std::memory_order_relaxed);
+  const int64_t peak = t->peak.load(std::memory_order_relaxed);
+  record[kPeak] = peak;
+  t->peak.store(std::max(peak, record[kParentPeak]),
+                std::memory_order_relaxed);
+  ThreadScope &scope = threadScope();
+  if (scope.depth > 0 && --scope.depth == 0) {
+    scope.guard.reset();
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,194 @@
+#include <torch/all.h>
+#include <torch_ffi.h>
+
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec/vec.h>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <torch/csrc/jit/frontend/tracer.h>
+#include <tuple>
+
+namespace {
+
+typedef std::tuple<int8_t, int8_t, int64_t, double, double> RopeKey;
+
+struct RopeTable {
+  at::Tensor cos;
+  at::Tensor sin;
+};
+
+std::mutex ropeCacheMutex;
+std::map<RopeKey, RopeTable> ropeCache;
+
+// Returns float32 cos/sin tables of shape [length, rotaryDim / 2] on device,
+// covering at least the first `positions` positions. Tables are shared per
+// (device, rotaryDim, base, scaling) and regrown geometrically on demand.
+RopeTable ropeTable(at::Device device, int64_t rotaryDim, double base,
+                    double scaling, int64_t positions) {
+  std::lock_guard<std::mutex> lock(ropeCacheMutex);
+  RopeKey key{int8_t(device.type()), device.index(), rotaryDim, base, scaling};
+  auto found = ropeCache.find(key);
+  if (found != ropeCache.end() && found->second.cos.size(0) >= positions) {
+    return found->second;
+  }
+
+  int64_t length = std::max<int64_t>(positions, 256);
+  if (found != ropeCache.end()) {
+    length = std::max(length, found->second.cos.size(0) * 2);
+  }
+  int64_t half = rotaryDim / 2;
+  auto options = at::TensorOptions().dtype(at::kDouble);
+  at::Tensor invFreq =
+      1.0 / at::pow(base, at::arange(0, half, options) * 2.0 / rotaryDim);
+  at::Tensor position = at::arange(0, length, options) / scaling;
+  at::Tensor angles = at::outer(position, invFreq);
+  RopeTable table{angles.cos().to(device, at::kFloat).contiguous(),
+                  angles.sin().to(device, at::kFloat).contiguous()};
+  ropeCache[key] = table;
+  return table;
+}
+
+template <typename scalar_t>
+void ropeRowsCPU(at::Tensor &x, const RopeTable &table, int64_t rotaryDim,
+                 int64_t positionOffset, int64_t seqDim, bool interleaved) {
+  int64_t ndim = x.dim();
+  int64_t half = rotaryDim / 2;
+  int64_t rows = x.numel() / x.size(-1);
+  scalar_t *data = x.data_ptr<scalar_t>();
+  const float *cosData = table.cos.data_ptr<float>();
+  const float *sinData = table.sin.data_ptr<float>();
+  auto sizes = x.sizes();
+  auto strides = x.strides();
+
+  at::parallel_for(0, rows, 16, [&](int64_t begin, int64_t end) {
+    for (int64_t r = begin; r < end; r++) {
+      // Decompose the row index over all dimensions but the last.
+      int64_t remaining = r;
+      int64_t offset = 0;
+      int64_t position = positionOffset;
+      for (int64_t d = ndim - 2; d >= 0; d--) {
+        int64_t index = remaining % sizes[d];
+        remaining /= sizes[d];
+        offset += index * strides[d];
+        if (d == seqDim) {
+          position += index;
+        }
+      }
+      scalar_t *row = data + offset;
+      const float *cosRow = cosData + position * half;
+      const float *sinRow = sinData + position * half;
+
+      if (interleaved) {
+        for (int64_t i = 0; i < half; i++) {
+          float x1 = static_cast<float>(row[2 * i]);
+          float x2 = static_cast<float>(row[2 * i + 1]);
+          row[2 * i] = static_cast<scalar_t>(x1 * cosRow[i] - x2 * sinRow[i]);
+          row[2 * i + 1] =
+              static_cast<scalar_t>(x2 * cosRow[i] + x1 * sinRow[i]);
+        }
+        continue;
+      }
+
+      int64_t i = 0;
+      if constexpr (std::is_same_v<scalar_t, float>) {
+        using Vec = at::vec::Vectorized<float>;
+        for (; i + Vec::size() <= half; i += Vec::size()) {
+          Vec x1 = Vec::loadu(row + i);
+          Vec x2 = Vec::loadu(row + half + i);
+          Vec c = Vec::loadu(cosRow + i);
+          Vec s = Vec::loadu(sinRow + i);
+          (x1 * c - x2 * s).store(row + i);
+          (x2 * c + x1 * s).store(row + half + i);
+        }
+      }
+      for (; i < half; i++) {
+        float x1 = static_cast<float>(row[i]);
+        float x2 = static_cast<float>(row[half + i]);
+        row[i] = static_cast<scalar_t>(x1 * cosRow[i] - x2 * sinRow[i]);
+        row[half + i] = static_cast<scalar_t>(x2 * cosRow[i] + x1 * sinRow[i]);
+      }
+    }
+  });
+}
+
+void ropeFallback(at::Tensor &x, const RopeTable &table, int64_t rotaryDim,
+                  int64_t positionOffset, int64_t seqDim, bool interleaved) {
+  int64_t half = rotaryDim / 2;
+  int64_t seqLength = x.size(seqDim);
+  // Broadcast [seqLength, half] over every dimension but seqDim and the last.
+  std::vector<int64_t> shape(x.dim(), 1);
+  shape[seqDim] = seqLength;
+  shape[x.dim() - 1] = half;
+  at::Tensor c = table.cos.narrow(0, positionOffset, seqLength)
+                     .to(x.scalar_type())
+                     .view(shape);
+  at::Tensor s = table.sin.narrow(0, positionOffset, seqLength)
+                     .to(x.scalar_type())
+                     .view(shape);
+  at::Tensor rotary = x.narrow(-1, 0, rotaryDim);
+  at::Tensor x1, x2;
+  if (interleaved) {
+    x1 = rotary.slice(-1, 0, rotaryDim, 2);
+    x2 = rotary.slice(-1, 1, rotaryDim, 2);
+  } else {
+    x1 = rotary.narrow(-1, 0, half);
+    x2 = rotary.narrow(-1, half, half);
+  }
+  at::Tensor rotated1 = x1 * c - x2 * s;
+  at::Tensor rotated2 = x2 * c + x1 * s;
+  x1.copy_(rotated1);
+  x2.copy_(rotated2);
+}
+
+void rope(at::Tensor &x, int64_t rotaryDim, double base, double scaling,
+          int64_t positionOffset, int64_t seqDim, bool interleaved) {
+  seqDim = seqDim < 0 ? seqDim + x.dim() : seqDim;
+  TORCH_CHECK(seqDim >= 0 && seqDim < x.dim() - 1,
+              "seqDim must not be the last dimension");
+  TORCH_CHECK(rotaryDim % 2 == 0 && rotaryDim <= x.size(-1),
+              "rotaryDim must be even and at most the head size");
+  RopeTable table = ropeTable(x.device(), rotaryDim, base, scaling,
+                              positionOffset + x.size(seqDim));
+  // The row kernel writes through data_ptr, which the tracer cannot see.
+  if (x.is_cpu() && x.stride(-1) == 1 && !torch::jit::tracer::isTracing()) {
+    AT_DISPATCH_FLOATING_TYPES_AND2(
+        at::kHalf, at::kBFloat16, x.scalar_type(), "torchffi_rope_", [&] {
+          ropeRowsCPU<scalar_t>(x, table, rotaryDim, positionOffset, seqDim,
+                                interleaved);
+        });
+  } else {
+    ropeFallback(x, table, rotaryDim, positionOffset, seqDim, interleaved);
+  }
+}
+
+} // namespace
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void torchffi_rotary_embedding_(tensor query, tensor key, int64_t rotaryDim,
+                                double base, double scaling,
+                                int64_t positionOffset, int64_t seqDim,
+                                bool interleaved, char **error) {
+  try {
+    rope(*query, rotaryDim, base, scaling, positionOffset, seqDim,
+         interleaved);
+    if (key != nullptr) {
+      rope(*key, rotaryDim, base, scaling, positionOffset, seqDim,
+           interleaved);
+    }
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+  }
+}
+
+void torchffi_rotary_embedding_cache_clear() {
+  std::lock_guard<std::mutex> lock(ropeCacheMutex);
+  ropeCache.clear();
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,184 @@
+#include <torch/all.h>
+#include <torch_ffi.h>
+
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec/vec.h>
+#include <cmath>
+#include <cstring>
+#include <torch/csrc/jit/frontend/tracer.h>
+
+namespace {
+
+bool sameLayout(const at::Tensor &x, const at::Tensor *t) {
+  return t == nullptr ||
+         (t->is_cpu() && t->is_contiguous() &&
+          t->scalar_type() == x.scalar_type() && t->sizes().equals(x.sizes()));
+}
+
+// x = a * x + c1 * t1 + c2 * t2 + noiseScale * noise, in place. Any of t1,
+// t2 and noise may be null.
+void combine_(at::Tensor &x, double a, const at::Tensor *t1, double c1,
+              const at::Tensor *t2, double c2, const at::Tensor *noise,
+              double noiseScale) {
+  // Traced steps use the ATen ops, which the tracer records.
+  if (!x.is_cpu() || !x.is_contiguous() || x.scalar_type() != at::kFloat ||
+      !sameLayout(x, t1) || !sameLayout(x, t2) || !sameLayout(x, noise) ||
+      torch::jit::tracer::isTracing()) {
+    x.mul_(a);
+    if (t1) {
+      x.add_(*t1, c1);
+    }
+    if (t2) {
+      x.add_(*t2, c2);
+    }
+    if (noise) {
+      x.add_(*noise, noiseScale);
+    }
+    return;
+  }
+
+  using Vec = at::vec::Vectorized<float>;
+  float *xData = x.data_ptr<float>();
+  const float *t1Data = t1 ? t1->data_ptr<float>() : nullptr;
+  const float *t2Data = t2 ? t2->data_ptr<float>() : nullptr;
+  const float *noiseData = noise ? noise->data_ptr<float>() : nullptr;
+  float fa = a, f1 = c1, f2 = c2, fn = noiseScale;
+
+  at::parallel_for(0, x.numel(), 32768, [&](int64_t begin, int64_t end) {
+    int64_t i = begin;
+    const Vec va(fa), v1(f1), v2(f2), vn(fn);
+    for (; i + Vec::size() <= end; i += Vec::size()) {
+      Vec value = Vec::loadu(xData + i) * va;
+      if (t1Data) {
+        value = at::vec::fmadd(Vec::loadu(t1Data + i), v1, value);
+      }
+      if (t2Data) {
+        value = at::vec::fmadd(Vec::loadu(t2Data + i), v2, value);
+      }
+      if (noiseData) {
+        value = at::vec::fmadd(Vec::loadu(noiseData + i), vn, value);
+      }
+      value.store(xData + i);
+    }
+    for (; i < end; i++) {
+      float value = xData[i] * fa;
+      if (t1Data) {
+        value += t1Data[i] * f1;
+      }
+      if (t2Data) {
+        value += t2Data[i] * f2;
+      }
+      if (noiseData) {
+        value += noiseData[i] * fn;
+      }
+      xData[i] = value;
+    }
+  });
+}
+
+void step_(at::Tensor &x, double a, const at::Tensor *t1, double c1,
+           const at::Tensor *t2, double c2, double noiseScale,
+           Generator generator) {
+  if (noiseScale == 0) {
+    combine_(x, a, t1, c1, t2, c2, nullptr, 0);
+    return;
+  }
+  std::optional<at::Generator> opGenerator = std::nullopt;
+  if (generator != nullptr) {
+    opGenerator = *generator;
+  }
+  at::Tensor noise = at::randn(x.sizes(), opGenerator, x.options());
+  combine_(x, a, t1, c1, t2, c2, &noise, noiseScale);
+}
+
+} // namespace
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void torchffi_sampler_step_(tensor x, double a, tensor t1, double c1,
+                            tensor t2, double c2, double noiseScale,
+                            Generator generator, char **error) {
+  try {
+    step_(*x, a, t1, c1, t2, c2, noiseScale, generator);
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+  }
+}
+
+// Euler (ancestral when eta > 0) step of the probability flow ODE in the
+// k-diffusion formulation, where d = (x - denoised) / sigma.
+void torchffi_euler_step_(tensor x, tensor denoised, double sigma,
+                          double sigmaNext, double eta, Generator generator,
+                          char **error) {
+  try {
+    double sigmaUp = 0;
+    double sigmaDown = sigmaNext;
+    if (eta > 0 && sigmaNext > 0) {
+      double variance = sigmaNext * sigmaNext *
+                        (sigma * sigma - sigmaNext * sigmaNext) /
+                        (sigma * sigma);
+      sigmaUp = std::min(sigmaNext, eta * std::sqrt(variance));
+      sigmaDown = std::sqrt(sigmaNext * sigmaNext - sigmaUp * sigmaUp);
+    }
+    double ratio = (sigmaDown - sigma) / sigma;
+    step_(*x, 1 + ratio, denoised, -ratio, nullptr, 0, sigmaUp, generator);
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+  }
+}
+
+// DDIM step from timestep t to the previous one given the predicted noise.
+void torchffi_ddim_step_(tensor x, tensor noisePrediction, double alphaCumprod,
+                         double alphaCumprodPrev, double eta,
+                         Generator generator, char **error) {
+  try {
+    double variance = (1 - alphaCumprodPrev) / (1 - alphaCumprod) *
+                      (1 - alphaCumprod / alphaCumprodPrev);
+    double sigma = eta * std::sqrt(std::max(variance, 0.0));
+    double sqrtAlpha = std::sqrt(alphaCumprod);
+    double sqrtAlphaPrev = std::sqrt(alphaCumprodPrev);
+    // x0 = (x - sqrt(1 - a) * eps) / sqrt(a)
+    // x' = sqrt(a') * x0 + sqrt(1 - a' - sigma^2) * eps + sigma * noise
+    double a = sqrtAlphaPrev / sqrtAlpha;
+    double c = std::sqrt(std::max(1 - alphaCumprodPrev - sigma * sigma, 0.0)) -
+               a * std::sqrt(1 - alphaCumprod);
+    step_(*x, a, noisePrediction, c, nullptr, 0, sigma, generator);
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+  }
+}
+
+// DPM-Solver++(2M) step. previousDenoised is null on the first step and
+// sigmaPrevious is ignored then.
+void torchffi_dpmpp_2m_step_(tensor x, tensor denoised,
+                             tensor previousDenoised, double sigma,
+                             double sigmaNext, double sigmaPrevious,
+                             char **error) {
+  try {
+    if (sigmaNext == 0) {
+      step_(*x, 0, denoised, 1, nullptr, 0, 0, nullptr);
+      return;
+    }
+    double t = -std::log(sigma);
+    double tNext = -std::log(sigmaNext);
+    double h = tNext - t;
+    double a = sigmaNext / sigma;
+    double c = -std::expm1(-h);
+    if (previousDenoised == nullptr) {
+      step_(*x, a, denoised, c, nullptr, 0, 0, nullptr);
+      return;
+    }
+    double hLast = t - (-std::log(sigmaPrevious));
+    double r = hLast / h;
+    step_(*x, a, denoised, c * (1 + 1 / (2 * r)), previousDenoised,
+          -c / (2 * r), 0, nullptr);
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,188 @@
+#include <torch/all.h>
+#include <torch_ffi.h>
+
+#include <atomic>
+#include <cstring>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr uint64_t kMagic = 0x4d48535446464954ULL; // "TIFFTSHM"
+constexpr int64_t kMaxDims = 16;
+constexpr size_t kMaxName = 256;
+// Keeps the data aligned for vectorized kernels.
+constexpr size_t kDataOffset = 512;
+
+// Stored at the start of the region. refs counts the tensors mapping the
+// region in all processes; the last one to drop its tensor unlinks it.
+struct Header {
+  uint64_t magic;
+  std::atomic<int64_t> refs;
+  int64_t dtype;
+  int64_t ndims;
+  int64_t sizes[kMaxDims];
+  uint64_t nbytes;
+  char name[kMaxName];
+};
+
+static_assert(sizeof(Header) <= kDataOffset, "Header overlaps the data");
+static_assert(std::atomic<int64_t>::is_always_lock_free,
+              "Shared reference counts need lock-free atomics");
+
+#ifndef _WIN32
+std::string errnoMessage(const char *what, const char *name) {
+  return std::string(what) + " " + name + ": " + strerror(errno);
+}
+
+// Owns one process's mapping of a region; the context of the tensor's
+// storage, so that shared tensors can be told apart by their deleter.
+struct Mapping {
+  void *region;
+  size_t length;
+
+  Header *header() const { return static_cast<Header *>(region); }
+};
+
+void unmap(void *context) {
+  Mapping *mapping = static_cast<Mapping *>(context);
+  Header *header = mapping->header();
+  if (header->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    shm_unlink(header->name);
+  }
+  munmap(mapping->region, mapping->length);
+  delete mapping;
+}
+
+tensor wrap(void *region, size_t length) {
+  Mapping *mapping = new Mapping{region, length};
+  const Header *header = mapping->header();
+  void *data = static_cast<char *>(region) + kDataOffset;
+  at::Tensor tensor =
+      at::for_blob(data, at::IntArrayRef(header->sizes, header->ndims))
+          .context(mapping, &unmap)
+          .options(at::TensorOptions().dtype(at::ScalarType(header->dtype)))
+          .make_tensor();
+  return new torch::Tensor(tensor);
+}
+#endif
+
+} // namespace
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+tensor torchffi_shm_tensor_new(char *name, int64_t *dims, size_t ndims,
+                               int8_t dtype, char **error) {
+  try {
+#ifdef _WIN32
+    TORCH_CHECK(false, "Shared memory tensors are not supported on Windows");
+#else
+    TORCH_CHECK(ndims <= size_t(kMaxDims), "Too many dimensions: ", ndims);
+    TORCH_CHECK(strlen(name) < kMaxName, "Name is too long: ", name);
+    int64_t numel = 1;
+    for (size_t i = 0; i < ndims; i++) {
+      TORCH_CHECK(dims[i] >= 0, "Negative size ", dims[i]);
+      numel *= dims[i];
+    }
+    const size_t nbytes = numel * c10::elementSize(at::ScalarType(dtype));
+    const size_t length = kDataOffset + nbytes;
+
+    const int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    TORCH_CHECK(fd >= 0, errnoMessage("Cannot create", name));
+    if (ftruncate(fd, off_t(length)) != 0) {
+      const std::string message = errnoMessage("Cannot size", name);
+      close(fd);
+      shm_unlink(name);
+      TORCH_CHECK(false, message);
+    }
+    void *region =
+        mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (region == MAP_FAILED) {
+      const std::string message = errnoMessage("Cannot map", name);
+      shm_unlink(name);
+      TORCH_CHECK(false, message);
+    }
+    Header *header = new (region) Header();
+    header->refs.store(1, std::memory_order_relaxed);
+    header->dtype = dtype;
+    header->ndims = int64_t(ndims);
+    std::copy(dims, dims + ndims, header->sizes);
+    header->nbytes = nbytes;
+    strncpy(header->name, name, kMaxName - 1);
+    // Published last: openers check the magic before trusting the rest.
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = kMagic;
+    return wrap(region, length);
+#endif
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+    return nullptr;
+  }
+}
+
+tensor torchffi_shm_tensor_open(char *name, char **error) {
+  try {
+#ifdef _WIN32
+    TORCH_CHECK(false, "Shared memory tensors are not supported on Windows");
+#else
+    const int fd = shm_open(name, O_RDWR, 0);
+    TORCH_CHECK(fd >= 0, errnoMessage("Cannot open", name));
+    struct stat info;
+    if (fstat(fd, &info) != 0 || size_t(info.st_size) < kDataOffset) {
+      close(fd);
+      TORCH_CHECK(false, "Not a shared memory tensor: ", name);
+    }
+    const size_t length = size_t(info.st_size);
+    void *region =
+        mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    TORCH_CHECK(region != MAP_FAILED, errnoMessage("Cannot map", name));
+    Header *header = static_cast<Header *>(region);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (header->magic != kMagic ||
+        kDataOffset + header->nbytes > length) {
+      munmap(region, length);
+      TORCH_CHECK(false, "Not a shared memory tensor: ", name);
+    }
+    // Only join while some process still holds the region; once the count
+    // has dropped to zero the name is being unlinked.
+    int64_t refs = header->refs.load(std::memory_order_acquire);
+    do {
+      if (refs <= 0) {
+        munmap(region, length);
+        TORCH_CHECK(false, "Shared memory tensor was released: ", name);
+      }
+    } while (!header->refs.compare_exchange_weak(refs, refs + 1,
+                                                 std::memory_order_acq_rel));
+    return wrap(region, length);
+#endif
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+    return nullptr;
+  }
+}
+
+// Number of tensors mapping the shared region of t in all processes, or -1
+// if t is not a shared memory tensor.
+int64_t torchffi_shm_tensor_refs(tensor t) {
+#ifdef _WIN32
+  return -1;
+#else
+  if (!t->has_storage()) return -1;
+  const c10::DataPtr &data = t->storage().data_ptr();
+  if (data.get_deleter() != &unmap) return -1;
+  const Mapping *mapping = static_cast<const Mapping *>(data.get_context());
+  return mapping->header()->refs.load(std::memory_order_acquire);
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif
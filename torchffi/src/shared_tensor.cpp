@@ -0,0 +1,57 @@
+#include <torch/all.h>
+#include <torch_ffi.h>
+
+#include <atomic>
+#include <cstring>
+
+// A reference to a tensor held on behalf of importers that have not picked
+// it up yet, possibly on other threads.
+struct SharedTensor_t {
+  at::Tensor tensor;
+  std::atomic<int64_t> remaining;
+};
+
+namespace {
+
+void releaseImports(SharedTensor token, int64_t count) {
+  if (token->remaining.fetch_sub(count, std::memory_order_acq_rel) <= count) {
+    delete token;
+  }
+}
+
+} // namespace
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+SharedTensor torchffi_tensor_share(tensor t, int64_t importers,
+                                   char **error) {
+  try {
+    TORCH_CHECK(importers > 0, "A shared tensor needs at least one importer");
+    return new SharedTensor_t{*t, importers};
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+    return nullptr;
+  }
+}
+
+tensor torchffi_shared_tensor_import(SharedTensor token) {
+  // A new TensorImpl over the same storage, so that metadata changes such
+  // as resizing or requires_grad stay local to the importer.
+  tensor result = new torch::Tensor(token->tensor.detach());
+  releaseImports(token, 1);
+  return result;
+}
+
+void torchffi_shared_tensor_release(SharedTensor token, int64_t count) {
+  releaseImports(token, count);
+}
+
+int64_t torchffi_shared_tensor_remaining(SharedTensor token) {
+  return token->remaining.load(std::memory_order_acquire);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,81 @@
+#include <torch/all.h>
+#include <torch_ffi.h>
+
+#include <cstring>
+#include <optional>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Verifies k draft tokens against k + 1 rows of target probabilities. Returns
+// the number of accepted draft tokens and writes the token that follows them
+// to nextToken, sampled from max(0, p - q) on rejection or from the bonus row
+// when every draft token was accepted.
+int64_t torchffi_speculative_verify(tensor draftProbs, tensor targetProbs,
+                                    tensor draftTokens, bool greedy,
+                                    Generator generator, int64_t *nextToken,
+                                    char **error) {
+  try {
+    std::optional<at::Generator> opGenerator = std::nullopt;
+    if (generator != nullptr) {
+      opGenerator = *generator;
+    }
+
+    at::Tensor target =
+        targetProbs->reshape({-1, targetProbs->size(-1)}).to(at::kFloat);
+    at::Tensor tokens =
+        draftTokens->reshape({-1}).to(target.device(), at::kLong);
+    int64_t k = tokens.size(0);
+    TORCH_CHECK(target.size(0) == k + 1, "targetProbs must have ", k + 1,
+                " rows but has ", target.size(0));
+
+    int64_t accepted = 0;
+    if (greedy) {
+      at::Tensor best = target.argmax(-1);
+      at::Tensor matches = best.narrow(0, 0, k).eq(tokens).to(at::kCPU);
+      auto match = matches.accessor<bool, 1>();
+      while (accepted < k && match[accepted]) {
+        accepted++;
+      }
+      *nextToken = best[accepted].item<int64_t>();
+      return accepted;
+    }
+
+    at::Tensor draft = draftProbs->reshape({-1, draftProbs->size(-1)})
+                           .to(target.device(), at::kFloat);
+    TORCH_CHECK(draft.size(0) == k, "draftProbs must have ", k,
+                " rows but has ", draft.size(0));
+
+    at::Tensor index = tokens.unsqueeze(1);
+    at::Tensor p = target.narrow(0, 0, k).gather(1, index).squeeze(1);
+    at::Tensor q = draft.gather(1, index).squeeze(1);
+    at::Tensor u = at::rand({k}, opGenerator, p.options());
+    // u <= min(1, p / q) without dividing by a possibly zero q.
+    at::Tensor accept = (u * q).le(p).to(at::kCPU);
+    auto acceptAccessor = accept.accessor<bool, 1>();
+    while (accepted < k && acceptAccessor[accepted]) {
+      accepted++;
+    }
+
+    at::Tensor distribution;
+    if (accepted < k) {
+      distribution = (target[accepted] - draft[accepted]).clamp_min(0);
+      if (distribution.sum().item<double>() <= 0) {
+        distribution = target[accepted];
+      }
+    } else {
+      distribution = target[k];
+    }
+    *nextToken =
+        at::multinomial(distribution, 1, false, opGenerator).item<int64_t>();
+    return accepted;
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+    return 0;
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -6,6 +6,9 @@
 #include <ATen/autocast_mode.h>
 #include <cstring>
 #include <optional>
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
 
 at::TensorOptions torchffi_make_tensor_options(TensorOptions options) {
   at::TensorOptions tensorOptions;
@@ -156,6 +159,36 @@ tensor torchffi_tensor_new_from_blob(void *data, int64_t *dims, size_t ndims,
   return new torch::Tensor(tensor);
 }
 
+// Wraps data without copying and hands its ownership to the storage, which
+// calls release(data, context) when the last reference to it dies. On error
+// the caller keeps ownership of data.
+tensor torchffi_tensor_new_from_blob_owned(void *data, int64_t *dims,
+                                           size_t ndims, TensorOptions options,
+                                           BlobRelease release, void *context,
+                                           char **error) {
+  try {
+    TORCH_CHECK(release != nullptr, "release callback is required");
+    at::Tensor tensor = at::from_blob(
+        data, torch::IntArrayRef(dims, ndims),
+        [release, context](void *ptr) { release(ptr, context); },
+        torchffi_make_tensor_options(options));
+    return new torch::Tensor(tensor);
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+    return nullptr;
+  }
+}
+
+// Release callback for buffers allocated with C malloc.
+void torchffi_blob_release_free(void *data, void *context) { free(data); }
+
+// Release callback for mmap regions. context holds the mapped length.
+void torchffi_blob_release_munmap(void *data, void *context) {
+#ifndef _WIN32
+  munmap(data, reinterpret_cast<size_t>(context));
+#endif
+}
+
 tensor torchffi_tensor_baddbmm(tensor input, tensor batch1, tensor batch2,
                                double beta, double alpha) {
   return new torch::Tensor(input->baddbmm(*batch1, *batch2, beta, alpha));
@@ -172,6 +205,21 @@ tensor torchffi_tensor_bmm(tensor input, tensor mat2) {
 
 void *torchffi_tensor_data_pointer(tensor t) { return t->data_ptr(); }
 
+void *torchffi_tensor_impl(tensor t) { return t->unsafeGetTensorImpl(); }
+
+tensor torchffi_tensor_share(tensor t) { return new torch::Tensor(*t); }
+
+int64_t torchffi_tensor_version(tensor t) { return t->_version(); }
+
+// Keeps whether dst requires grad, so that materializing a parameter does
+// not drop it.
+void torchffi_tensor_assign(tensor dst, tensor src) {
+  const bool requiresGrad = dst->requires_grad();
+  *dst = src->requires_grad() == requiresGrad
+             ? *src
+             : src->detach().requires_grad_(requiresGrad);
+}
+
 size_t torchffi_tensor_dim(tensor t) { return t->dim(); }
 
 void torchffi_tensor_sizes(tensor t, size_t dim, int64_t *shape) {
@@ -231,6 +279,67 @@ Scalar_t torchffi_tensor_scalar_at(tensor t, int64_t *indices,
   }
 }
 
+// Copies all of t, in logical row-major order, into out as dtype. copy_
+// handles any strides, device and dtype conversion in one pass.
+void torchffi_tensor_read_into(tensor t, void *out, int8_t dtype,
+                               char **error) {
+  try {
+    at::Tensor dst = at::from_blob(out, t->sizes(),
+                                   at::TensorOptions().dtype(
+                                       at::ScalarType(dtype)));
+    dst.copy_(*t);
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+  }
+}
+
+// Overwrites t with row-major data of type dtype.
+void torchffi_tensor_write_from(tensor t, const void *data, int8_t dtype,
+                                char **error) {
+  try {
+    at::Tensor src = at::from_blob(const_cast<void *>(data), t->sizes(),
+                                   at::TensorOptions().dtype(
+                                       at::ScalarType(dtype)));
+    t->copy_(src);
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+  }
+}
+
+// Reads count elements of t addressed by the index tuples in indices,
+// [count, t.dim()] row-major, into out as dtype. Negative indices count from
+// the end of their dimension.
+void torchffi_tensor_gather_into(tensor t, const int64_t *indices,
+                                 int64_t count, void *out, int8_t dtype,
+                                 char **error) {
+  try {
+    int64_t dim = t->dim();
+    at::Tensor linear = at::empty({count}, at::kLong);
+    int64_t *linearData = linear.data_ptr<int64_t>();
+    at::IntArrayRef sizes = t->sizes();
+    for (int64_t i = 0; i < count; i++) {
+      int64_t offset = 0;
+      for (int64_t d = 0; d < dim; d++) {
+        int64_t index = indices[i * dim + d];
+        if (index < 0) {
+          index += sizes[d];
+        }
+        TORCH_CHECK(index >= 0 && index < sizes[d], "index ",
+                    indices[i * dim + d], " is out of bounds for dimension ",
+                    d, " with size ", sizes[d]);
+        offset = offset * sizes[d] + index;
+      }
+      linearData[i] = offset;
+    }
+    at::Tensor values = at::take(*t, linear.to(t->device()));
+    at::from_blob(out, {count},
+                  at::TensorOptions().dtype(at::ScalarType(dtype)))
+        .copy_(values);
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+  }
+}
+
 tensor torchffi_tensor_get(tensor t, int index) {
   auto tensor = t->select(0, index);
   return new torch::Tensor(tensor);
@@ -0,0 +1,90 @@
+#include <torch/all.h>
+#include <torch_ffi.h>
+
+#include <cstring>
+
+// conv3x3(upsample_nearest_2x(x)) computed as four 2x2 convolutions over x,
+// one per output phase (row parity a, column parity b). Output row 2i + a
+// reads upsampled rows 2i + a - 1 .. 2i + a + 1, which are source rows
+// {i - 1, i, i} for a = 0 and {i, i, i + 1} for a = 1, so kernel rows that
+// hit the same source row are summed. Columns work the same way.
+
+namespace {
+
+at::Tensor foldPhase(const at::Tensor &w, int64_t dim, int64_t phase) {
+  at::Tensor k0 = w.narrow(dim, 0, 1);
+  at::Tensor k1 = w.narrow(dim, 1, 1);
+  at::Tensor k2 = w.narrow(dim, 2, 1);
+  if (phase == 0) {
+    return at::cat({k0, k1 + k2}, dim);
+  }
+  return at::cat({k0 + k1, k2}, dim);
+}
+
+} // namespace
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Returns [4, out, in, 2, 2] kernels for phases (0, 0), (0, 1), (1, 0) and
+// (1, 1) from a [out, in, 3, 3] kernel.
+tensor torchffi_upsample2x_conv2d_phase_weights(tensor weights, char **error) {
+  try {
+    TORCH_CHECK(weights->dim() == 4 && weights->size(2) == 3 &&
+                    weights->size(3) == 3,
+                "Expected a 3x3 convolution kernel");
+    std::vector<at::Tensor> phases;
+    for (int64_t a = 0; a < 2; a++) {
+      at::Tensor rows = foldPhase(*weights, 2, a);
+      for (int64_t b = 0; b < 2; b++) {
+        phases.push_back(foldPhase(rows, 3, b));
+      }
+    }
+    return new torch::Tensor(at::stack(phases));
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+    return nullptr;
+  }
+}
+
+// Equivalent to conv2d(upsample_nearest(input, scale 2), weights, bias,
+// padding 1) without materializing the upsampled input. Temporaries are a
+// padded copy of the input and one phase at a time, each a quarter of the
+// output, which is copied into its strided slice of the output.
+tensor torchffi_upsample2x_conv2d(tensor input, tensor phaseWeights,
+                                  tensor bias, char **error) {
+  try {
+    TORCH_CHECK(input->dim() == 4, "Expected NCHW input");
+    int64_t height = input->size(2);
+    int64_t width = input->size(3);
+    std::optional<at::Tensor> optionalBias =
+        bias ? std::optional<at::Tensor>(*bias) : std::nullopt;
+
+    at::Tensor padded = at::constant_pad_nd(*input, {1, 1, 1, 1});
+    at::Tensor output =
+        at::empty({input->size(0), phaseWeights->size(1), 2 * height,
+                   2 * width},
+                  input->options().memory_format(
+                      input->suggest_memory_format()));
+    for (int64_t a = 0; a < 2; a++) {
+      at::Tensor rows = padded.narrow(2, a, height + 1);
+      for (int64_t b = 0; b < 2; b++) {
+        at::Tensor phase =
+            at::conv2d(rows.narrow(3, b, width + 1), (*phaseWeights)[2 * a + b],
+                       optionalBias);
+        output.slice(2, a, 2 * height, 2)
+            .slice(3, b, 2 * width, 2)
+            .copy_(phase);
+      }
+    }
+    return new torch::Tensor(output);
+  } catch (const std::exception &e) {
+    *error = strdup(e.what());
+    return nullptr;
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif